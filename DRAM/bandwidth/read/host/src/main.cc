@@ -30,6 +30,8 @@
 #include <iomanip>
 #include <cstdlib>
 #include <cstdint>
+#include <ctime>
+#include <future>
 #include <limits>
 
 #include "CL/opencl.h"
@@ -39,15 +41,17 @@
 // OpenCL runtime configuration
 /********************************************************************/
 cl_uint                                num_devices   = 0;
-cl_context                             context       = NULL;
-cl_command_queue                       command_queue = NULL;
-cl_program                             program       = NULL;
-cl_kernel                              kernel        = NULL;
+aocl_utils::scoped_cl_context          context;
+aocl_utils::scoped_cl_command_queue    command_queue;
+aocl_utils::scoped_cl_program          program;
+aocl_utils::scoped_cl_kernel           kernel;
 cl_platform_id                         platform      = NULL;
 cl_int                                 status;
-cl_event                               write_event[1], kernel_event, finish_event;
-cl_mem                                 Y_buf;  // memory object for write
-cl_mem                                 X_buf;  // memory object for read
+aocl_utils::scoped_cl_event            write_event[1];
+std::vector<aocl_utils::scoped_cl_event> kernel_events, finish_events;  // one chain per try
+aocl_utils::BufferPool                 pool;   // where the buffers below come from
+aocl_utils::BufferPool::Lease          Y_buf;  // memory object for write
+aocl_utils::BufferPool::Lease          X_buf;  // memory object for read
 aocl_utils::scoped_array<cl_device_id> device_id;
 
 
@@ -58,11 +62,15 @@ aocl_utils::scoped_aligned_ptr<int> X;            // an array to contain integer
 size_t                              datanum;      // the number of integer values
 size_t                              try_num;      // the number of tries
 float                               frequency;    // the operating frequency (assuming MHz)
+bool                                calibrated;   // frequency given as auto: measured
+bool                                blocking;     // blocking reads instead of futures
+std::vector<std::future<cl_int> >   completions;  // of the chains in flight
 
 
 // variable to activate kernel 
 /********************************************************************/
 char   *name;
+std::string binary_file;
 size_t global_item_size[3], local_item_size[3];
 
 
@@ -70,8 +78,11 @@ size_t global_item_size[3], local_item_size[3];
 /********************************************************************/
 void init_data();
 void init_opencl();
-void run();
+void run(size_t i);
 void readbuf(size_t i);
+void wait_all();
+double thread_cpu_time();
+double calibrate();
 void verify();
 void cleanup();
 
@@ -80,20 +91,35 @@ void cleanup();
 int main(int argc, char *argv[]) {
 
   // check command line arguments
-  if (argc == 1) { std::cout << "usage: ./host <name> <datanum>"          << std::endl; exit(0); }
-  if (argc != 5) { std::cerr << "Error! The number of argument is wrong." << std::endl; exit(1); }
+  if (argc == 1) { std::cout << "usage: ./host <name> <datanum> <try_num> <frequency|auto> [sync|async]" << std::endl; exit(0); }
+  if (argc != 5 && argc != 6) { std::cerr << "Error! The number of argument is wrong." << std::endl; exit(1); }
   name      = argv[1];
   datanum   = std::stoull(std::string(argv[2]));
   try_num   = std::stoull(std::string(argv[3]));
-  frequency = std::stof(std::string(argv[4]));
+  calibrated = std::string(argv[4]) == "auto";
+  if (!calibrated) frequency = std::stof(std::string(argv[4]));
+  blocking  = argc == 6 && std::string(argv[5]) == "sync";
 
   // Initialization
   init_data(); init_opencl(); cycles_list.resize(try_num);
-
+  if (calibrated) frequency = aocl_utils::selectKernelMhz(calibrate(), binary_file.c_str());
+  kernel_events.resize(try_num); finish_events.resize(try_num);
+
+  // With futures, all chains are enqueued at once and the host thread only
+  // waits for them at the end; with blocking reads it waits for every try.
+  double       wall_start   = aocl_utils::getCurrentTimestamp();
+  double       thread_start = thread_cpu_time();
+  std::clock_t cpu_start    = std::clock();
   for (size_t i = 0; i < try_num; ++i) {
-    run();      // kernel running
+    run(i);     // kernel running
     readbuf(i); // getting the computation results
   }
+  wait_all();
+  double wall_time   = aocl_utils::getCurrentTimestamp() - wall_start;
+  double thread_time = thread_cpu_time() - thread_start;
+  double cpu_time    = double(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+  std::cout << "Host (" << (blocking ? "blocking reads" : "futures") << "): wall " << wall_time
+            << " sec, CPU " << thread_time << " sec (host thread), " << cpu_time << " sec (process)" << std::endl;
   
   // verify the computation results
   verify(); 
@@ -142,19 +168,25 @@ void init_opencl() {
   std::cout << "Using " << num_devices << " device(s)" << std::endl;
   std::cout << " " << aocl_utils::getDeviceName(device_id[0]).c_str() << std::endl;
   
+  // Select the binary for all device. Use the first device as the
+  // representative device (assuming all device are of the same type).
+  // Whether the bitstream is already resident must be known before the
+  // context is created.
+  binary_file = aocl_utils::getBoardBinaryFile(name, device_id[0]);
+  std::cout << "Using AOCX: " << binary_file.c_str() << std::endl;
+  // Without touching the device: what the AOCX holds, and whether it has the kernel
+  aocl_utils::printAocxSummary(binary_file.c_str());
+  if (!aocl_utils::checkAocxKernels(binary_file.c_str(), &name, 1)) exit(1);
+  const char *state_file = aocl_utils::getBitstreamStateFile();
+  bool resident = aocl_utils::prepareBinaryLoad(state_file, binary_file.c_str(), device_id, num_devices);
+
   // Create the context.
   context = clCreateContext(NULL, num_devices, device_id, NULL, NULL, &status);
   aocl_utils::checkError(status, "Failed to create context");
 
-  // Create the program for all device. Use the first device as the
-  // representative device (assuming all device are of the same type).
-  std::string binary_file = aocl_utils::getBoardBinaryFile(name, device_id[0]);
-  std::cout << "Using AOCX: " << binary_file.c_str() << std::endl;
-  program = createProgramFromBinary(context, binary_file.c_str(), device_id, num_devices);
-  
-  // Build the program that was just created.
-  status = clBuildProgram(program, 0, NULL, "", NULL, NULL);
-  aocl_utils::checkError(status, "Failed to build program");
+  // Create and build the program, reconfiguring the FPGA unless the
+  // resident bitstream can be reused.
+  program = aocl_utils::loadProgramFromBinary(context, binary_file.c_str(), device_id, num_devices, resident, state_file);
 
   // kernel
   kernel = clCreateKernel(program, name, &status);
@@ -164,38 +196,79 @@ void init_opencl() {
   }
 
   // command queue
-  command_queue = clCreateCommandQueue(context, device_id[0], 0, &status);
+  command_queue = clCreateCommandQueue(context, device_id[0], aocl_utils::traceQueueProperties(CL_QUEUE_PROFILING_ENABLE), &status);
 
   // memory object_m
-  Y_buf = clCreateBuffer(context, CL_MEM_WRITE_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(int), NULL, &status);
-  aocl_utils::checkError(status, "Failed to create buffer for Y");
-  X_buf = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, sizeof(int)*datanum, NULL, &status);
-  aocl_utils::checkError(status, "Failed to create buffer for X");
+  pool.setContext(context);
+  Y_buf = pool.acquire(CL_MEM_WRITE_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(int));
+  X_buf = pool.acquire(CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, sizeof(int)*datanum);
 
   // host to device_m
-  status = clEnqueueWriteBuffer(command_queue, X_buf, CL_TRUE, 0, sizeof(int)*datanum , X , 0, NULL, &write_event[0]);
+  status = clEnqueueWriteBuffer(command_queue, X_buf, CL_TRUE, 0, sizeof(int)*datanum , X , 0, NULL, write_event[0].out());
   aocl_utils::checkError(status, "Failed to transfer input X");
+  aocl_utils::traceCommand(write_event[0], "write X");
 
   // Set kernel arguments.
   unsigned argi = 0;
-  status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), &Y_buf);   aocl_utils::checkError(status, "Failed to set argument Y");
-  status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), &X_buf);   aocl_utils::checkError(status, "Failed to set argument X");
-  status = clSetKernelArg(kernel, argi++, sizeof(int),    &datanum); aocl_utils::checkError(status, "Failed to set argument N");
+  status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), Y_buf.ptr()); aocl_utils::checkError(status, "Failed to set argument Y");
+  status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), X_buf.ptr()); aocl_utils::checkError(status, "Failed to set argument X");
+  status = clSetKernelArg(kernel, argi++, sizeof(int),    &datanum);    aocl_utils::checkError(status, "Failed to set argument N");
 }
 
 
 /********************************************************************/
-void run() {
-  status = clEnqueueNDRangeKernel(command_queue, kernel, 1, NULL, global_item_size, local_item_size, 1, write_event, &kernel_event);
+void run(size_t i) {
+  status = clEnqueueNDRangeKernel(command_queue, kernel, 1, NULL, global_item_size, local_item_size, 1, write_event[0].ptr(), kernel_events[i].out());
   aocl_utils::checkError(status, "Failed to launch kernel");
+  aocl_utils::traceCommand(kernel_events[i], "kernel");
 }
 
 
 /********************************************************************/
 void readbuf(size_t i) {
   // device to host_m
-  status = clEnqueueReadBuffer(command_queue, Y_buf, CL_TRUE, 0, sizeof(int), &cycles_list[i], 1, &kernel_event, &finish_event);
+  status = clEnqueueReadBuffer(command_queue, Y_buf, blocking ? CL_TRUE : CL_FALSE, 0, sizeof(int), &cycles_list[i], 1, kernel_events[i].ptr(), finish_events[i].out());
   aocl_utils::checkError(status, "Failed to transfer output Y");
+  aocl_utils::traceCommand(finish_events[i], "read Y");
+  if (!blocking) completions.push_back(aocl_utils::whenComplete(finish_events[i]));
+}
+
+
+/********************************************************************/
+void wait_all() {
+  clFlush(command_queue);
+  for (size_t i = 0; i < completions.size(); ++i) {
+    aocl_utils::checkError(completions[i].get(), "Failed to transfer output Y");
+  }
+  completions.clear();
+}
+
+
+/********************************************************************/
+// The kernel clock from runs over 1/8, 1/4, 1/2 and all of X, fitting the
+// cycles the module reports against the kernel time (see
+// AOCLUtils/kernel_clock.h). Returns 0 if the module reported an error.
+double calibrate() {
+  std::vector<aocl_utils::ClockSample> samples;
+  cl_int last = 0;
+  for (int shift = 3; shift >= 0; --shift) {
+    cl_int n = cl_int(datanum >> shift) & ~15;  // whole 512-bit words
+    if (n == 0 || n == last) continue;
+    last = n;
+    status = clSetKernelArg(kernel, 2, sizeof(cl_int), &n); aocl_utils::checkError(status, "Failed to set argument N");
+    aocl_utils::scoped_cl_event event;
+    cl_int cycles;
+    status = clEnqueueNDRangeKernel(command_queue, kernel, 1, NULL, global_item_size, local_item_size, 1, write_event[0].ptr(), event.out());
+    aocl_utils::checkError(status, "Failed to launch kernel");
+    aocl_utils::traceCommand(event, "calibration kernel");
+    status = clEnqueueReadBuffer(command_queue, Y_buf, CL_TRUE, 0, sizeof(cl_int), &cycles, 1, event.ptr(), NULL);
+    aocl_utils::checkError(status, "Failed to transfer output Y");
+    if (cycles == 0) return 0;
+    aocl_utils::ClockSample sample = { double(cycles), aocl_utils::getStartEndTime(event) };
+    samples.push_back(sample);
+  }
+  status = clSetKernelArg(kernel, 2, sizeof(int), &datanum); aocl_utils::checkError(status, "Failed to set argument N");
+  return aocl_utils::fitKernelMhz(samples);
 }
 
 
@@ -218,21 +291,37 @@ void verify() {
     std::cout << std::string(50, '-') << std::endl;
     std::cout << std::setprecision(std::numeric_limits<float>::max_digits10) << "Avg. cycles: " << avg_cycles << std::endl;
     std::cout << "Memory read bandwidth: " << bandwidth * 1.0e-9 << " GB/s (" << elapsed_time << " sec)" << std::endl;
+    // What the DDR model gives for one call of read.v on an idle memory
+    aocl_utils::DdrModel ddr(aocl_utils::DdrConfig::fromEnv(frequency));
+    std::cout << std::flush;
+    aocl_utils::printPrediction(avg_cycles, double(aocl_utils::predictDramReadCycles(ddr, 0, 0, (datanum + 15) / 16)));
+    aocl_utils::printEfficiency(avg_cycles, aocl_utils::fsmReadCycles(aocl_utils::FsmParams::fromEnv(frequency), datanum));
   } else {
     std::cout << "Error! Evaluation failed..." << std::endl;
   }
 }
 
 
+/********************************************************************/
+double thread_cpu_time() {
+  timespec t;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+  return t.tv_sec + t.tv_nsec * 1.0e-9;
+}
+
+
 /********************************************************************/
 void cleanup() {
-  for (int i = 0; i < 1; ++i) clReleaseEvent(write_event[i]);
+  for (int i = 0; i < 1; ++i) write_event[i].reset();
+  kernel_events.clear();
+  finish_events.clear();
   clFlush(command_queue);
   clFinish(command_queue);
-  clReleaseMemObject(Y_buf);
-  clReleaseMemObject(X_buf);
-  clReleaseKernel(kernel);
-  clReleaseProgram(program);
-  clReleaseCommandQueue(command_queue);
-  clReleaseContext(context);
+  Y_buf.release();
+  X_buf.release();
+  pool.trim();
+  kernel.reset();
+  program.reset();
+  command_queue.reset();
+  context.reset();
 }
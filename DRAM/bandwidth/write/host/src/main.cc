@@ -38,21 +38,23 @@ using namespace aocl_utils;
 // OpenCL runtime configuration
 /********************************************************************/
 cl_uint                    num_devices   = 0;
-cl_context                 context       = NULL;
-cl_command_queue           command_queue = NULL;
-cl_program                 program       = NULL;
-cl_kernel                  kernel        = NULL;
+scoped_cl_context          context;
+scoped_cl_command_queue    command_queue;
+scoped_cl_program          program;
+scoped_cl_kernel           kernel;
 cl_platform_id             platform      = NULL;
 scoped_array<cl_device_id> device_id;
 cl_int                     status;
-cl_event                   write_event[1], kernel_event, finish_event;
-cl_mem                     Y_buf;  // memory object for write
-cl_mem                     X_buf;  // memory object for read
+scoped_cl_event            write_event[1], kernel_event, finish_event;
+BufferPool                 pool;   // where the buffers below come from
+BufferPool::Lease          Y_buf;  // memory object for write
+BufferPool::Lease          X_buf;  // memory object for read
 
 
 // Application data on the host PC
 /********************************************************************/
 int datanum;                // the number of integer values
+float frequency = 0;        // the operating frequency (assuming MHz), optional
 scoped_aligned_ptr<int> Y;  // an array to receive the computation results from the FPGA
 scoped_aligned_ptr<int> X;  // an array to contain integer data sent to the FPGA
 
@@ -79,10 +81,11 @@ int main(int argc, char *argv[]) {
   double start, end;
   
   // check command line arguments
-  if (argc == 1) { printf("usage: ./host <hogehoge> <datanum>\n");      exit(0); }
-  if (argc != 3) { printf("Error! The number of argument is wrong.\n"); exit(1); }
+  if (argc == 1) { printf("usage: ./host <hogehoge> <datanum> [<frequency>]\n"); exit(0); }
+  if (argc != 3 && argc != 4) { printf("Error! The number of argument is wrong.\n"); exit(1); }
   name    = argv[1];
   datanum = atoi(argv[2]);
+  if (argc == 4) frequency = atof(argv[3]);
 
   // Initialization
   init_data(); init_opencl();
@@ -97,6 +100,15 @@ int main(int argc, char *argv[]) {
   
   // verify the computation results and show the kernel execution time
   verify(); printf("time : %f sec.\n", end-start);
+
+  // the kernel alone, as the DDR model sees it
+  if (frequency > 0) {
+    DdrModel ddr(DdrConfig::fromEnv(frequency));
+    uint64_t cycles = predictDramWriteCycles(ddr, 0, 0, (datanum + 15) / 16);
+    printf("predicted kernel time : %f sec. (DDR model, %llu cycles)\n", cycles / (frequency * 1.0e6), (unsigned long long)cycles);
+    // the measured time includes the launch, so the efficiency is a lower bound
+    printEfficiency((end-start) * frequency * 1.0e6, fsmWriteCycles(FsmParams::fromEnv(frequency), datanum));
+  }
   
   // Free the resources allocated
   cleanup();
@@ -143,19 +155,31 @@ void init_opencl() {
   printf("Using %d device(s)\n", num_devices);
   printf("  %s\n", getDeviceName(device_id[0]).c_str());
   
+  // Select the binary for all device. Use the first device as the
+  // representative device (assuming all device are of the same type).
+  // Whether the bitstream is already resident must be known before the
+  // context is created.
+  std::string binary_file = getBoardBinaryFile(name, device_id[0]);
+  printf("Using AOCX: %s\n", binary_file.c_str());
+  // Without touching the device: what the AOCX holds, and whether it has the kernel
+  printAocxSummary(binary_file.c_str());
+  if (!checkAocxKernels(binary_file.c_str(), &name, 1)) exit(1);
+  // The module does not count cycles, so the clock cannot be measured here;
+  // without a frequency on the command line, take the fmax of the AOCX
+  if (frequency <= 0) {
+    frequency = getBinaryFmaxMhz(binary_file.c_str());
+    if (frequency > 0) printf("Kernel clock: %.3f MHz (fmax of the AOCX)\n", frequency);
+  }
+  const char *state_file = getBitstreamStateFile();
+  bool resident = prepareBinaryLoad(state_file, binary_file.c_str(), device_id, num_devices);
+
   // Create the context.
   context = clCreateContext(NULL, num_devices, device_id, NULL, NULL, &status);
   checkError(status, "Failed to create context");
 
-  // Create the program for all device. Use the first device as the
-  // representative device (assuming all device are of the same type).
-  std::string binary_file = getBoardBinaryFile(name, device_id[0]);
-  printf("Using AOCX: %s\n", binary_file.c_str());
-  program = createProgramFromBinary(context, binary_file.c_str(), device_id, num_devices);
-  
-  // Build the program that was just created.
-  status = clBuildProgram(program, 0, NULL, "", NULL, NULL);
-  checkError(status, "Failed to build program");
+  // Create and build the program, reconfiguring the FPGA unless the
+  // resident bitstream can be reused.
+  program = loadProgramFromBinary(context, binary_file.c_str(), device_id, num_devices, resident, state_file);
 
   // kernel
   kernel = clCreateKernel(program, name, &status);
@@ -165,38 +189,40 @@ void init_opencl() {
   }
 
   // command queue
-  command_queue = clCreateCommandQueue(context, device_id[0], 0, &status);
+  command_queue = clCreateCommandQueue(context, device_id[0], traceQueueProperties(0), &status);
 
   // memory object_m
-  Y_buf = clCreateBuffer(context, CL_MEM_WRITE_ONLY | CL_CHANNEL_1_INTELFPGA, sizeof(int)*datanum, NULL, &status);
-  checkError(status, "Failed to create buffer for Y");
-  X_buf = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(int)*datanum, NULL, &status);
-  checkError(status, "Failed to create buffer for X");
+  pool.setContext(context);
+  Y_buf = pool.acquire(CL_MEM_WRITE_ONLY | CL_CHANNEL_1_INTELFPGA, sizeof(int)*datanum);
+  X_buf = pool.acquire(CL_MEM_READ_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(int)*datanum);
 
   // host to device_m
-  status = clEnqueueWriteBuffer(command_queue, X_buf, CL_TRUE, 0, sizeof(int)*datanum , X , 0, NULL, &write_event[0]);
+  status = clEnqueueWriteBuffer(command_queue, X_buf, CL_TRUE, 0, sizeof(int)*datanum , X , 0, NULL, write_event[0].out());
   checkError(status, "Failed to transfer input X");
+  traceCommand(write_event[0], "write X");
 
   // Set kernel arguments.
   unsigned argi = 0;
-  status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), &Y_buf);   checkError(status, "Failed to set argument Y");
-  status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), &X_buf);   checkError(status, "Failed to set argument X");
-  status = clSetKernelArg(kernel, argi++, sizeof(int),    &datanum); checkError(status, "Failed to set argument N");
+  status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), Y_buf.ptr()); checkError(status, "Failed to set argument Y");
+  status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), X_buf.ptr()); checkError(status, "Failed to set argument X");
+  status = clSetKernelArg(kernel, argi++, sizeof(int),    &datanum);    checkError(status, "Failed to set argument N");
 }
 
 
 /********************************************************************/
 void run() {
-  status = clEnqueueNDRangeKernel(command_queue, kernel, 1, NULL, global_item_size, local_item_size, 1, write_event, &kernel_event);
+  status = clEnqueueNDRangeKernel(command_queue, kernel, 1, NULL, global_item_size, local_item_size, 1, write_event[0].ptr(), kernel_event.out());
   checkError(status, "Failed to launch kernel");
+  traceCommand(kernel_event, "kernel");
 }
 
 
 /********************************************************************/
 void readbuf() {
   // device to host_m
-  status = clEnqueueReadBuffer(command_queue, Y_buf, CL_TRUE, 0, sizeof(int)*datanum, Y, 1, &kernel_event, &finish_event);
+  status = clEnqueueReadBuffer(command_queue, Y_buf, CL_TRUE, 0, sizeof(int)*datanum, Y, 1, kernel_event.ptr(), finish_event.out());
   checkError(status, "Failed to transfer output Y");
+  traceCommand(finish_event, "read Y");
 }
 
 
@@ -228,13 +254,16 @@ void verify() {
 
 /********************************************************************/
 void cleanup() {
-  for (int i = 0; i < 1; ++i) clReleaseEvent(write_event[i]);
+  for (int i = 0; i < 1; ++i) write_event[i].reset();
+  kernel_event.reset();
+  finish_event.reset();
   clFlush(command_queue);
   clFinish(command_queue);
-  clReleaseMemObject(Y_buf);
-  clReleaseMemObject(X_buf);
-  clReleaseKernel(kernel);
-  clReleaseProgram(program);
-  clReleaseCommandQueue(command_queue);
-  clReleaseContext(context);
+  Y_buf.release();
+  X_buf.release();
+  pool.trim();
+  kernel.reset();
+  program.reset();
+  command_queue.reset();
+  context.reset();
 }
@@ -43,16 +43,17 @@ static const int WIDTH = 512;
 // OpenCL runtime configuration
 /********************************************************************/
 cl_uint                                num_devices   = 0;
-cl_context                             context       = NULL;
-cl_command_queue                       command_queue = NULL;
-cl_program                             program       = NULL;
-cl_kernel                              kernel        = NULL;
+aocl_utils::scoped_cl_context          context;
+aocl_utils::scoped_cl_command_queue    command_queue;
+aocl_utils::scoped_cl_program          program;
+aocl_utils::scoped_cl_kernel           kernel;
 cl_platform_id                         platform      = NULL;
 cl_int                                 status;
-cl_event                               write_event[2], kernel_event, finish_event;
-cl_mem                                 Y_buf;  // memory object for write
-cl_mem                                 X_buf;  // memory object for read
-cl_mem                                 I_buf;  // memory object for read
+aocl_utils::scoped_cl_event            write_event[2], kernel_event, finish_event;
+aocl_utils::BufferPool                 pool;   // where the buffers below come from
+aocl_utils::BufferPool::Lease          Y_buf;  // memory object for write
+aocl_utils::BufferPool::Lease          X_buf;  // memory object for read
+aocl_utils::BufferPool::Lease          I_buf;  // memory object for read
 aocl_utils::scoped_array<cl_device_id> device_id;
 
 
@@ -64,10 +65,12 @@ aocl_utils::scoped_aligned_ptr<int> I;
 size_t datanum;                         // the number of integer values
 size_t try_num;                         // the number of tries
 float  frequency;                       // the operating frequency (assuming MHz)
+bool   calibrated;                      // frequency given as auto: the fmax of the AOCX
 
 // variable to activate kernel 
 /********************************************************************/
 char   *name;
+std::string binary_file;
 size_t global_item_size[3], local_item_size[3];
 
 
@@ -77,6 +80,7 @@ void init_data();
 void init_opencl();
 void run();
 void readbuf();
+float kernel_mhz();
 void verify();
 void cleanup();
 
@@ -85,15 +89,17 @@ void cleanup();
 int main(int argc, char *argv[]) {
 
   // check command line arguments
-  if (argc == 1) { std::cout << "usage: ./host <name> <datanum> <try_num> <frequency>" << std::endl; exit(0); }
+  if (argc == 1) { std::cout << "usage: ./host <name> <datanum> <try_num> <frequency|auto>" << std::endl; exit(0); }
   if (argc != 5) { std::cerr << "Error! The number of arguments is wrong." << std::endl; exit(1); }
   name      = argv[1];
   datanum   = std::stoull(std::string(argv[2]));
   try_num   = std::stoull(std::string(argv[3]));
-  frequency = std::stof(std::string(argv[4]));
+  calibrated = std::string(argv[4]) == "auto";
+  if (!calibrated) frequency = std::stof(std::string(argv[4]));
 
   // Initialization
   init_data(); init_opencl();
+  if (calibrated) frequency = kernel_mhz();
 
   // kernel running
   run();
@@ -157,19 +163,25 @@ void init_opencl() {
   std::cout << "Using " << num_devices << " device(s)" << std::endl;
   std::cout << " " << aocl_utils::getDeviceName(device_id[0]).c_str() << std::endl;
   
+  // Select the binary for all device. Use the first device as the
+  // representative device (assuming all device are of the same type).
+  // Whether the bitstream is already resident must be known before the
+  // context is created.
+  binary_file = aocl_utils::getBoardBinaryFile(name, device_id[0]);
+  std::cout << "Using AOCX: " << binary_file.c_str() << std::endl;
+  // Without touching the device: what the AOCX holds, and whether it has the kernel
+  aocl_utils::printAocxSummary(binary_file.c_str());
+  if (!aocl_utils::checkAocxKernels(binary_file.c_str(), &name, 1)) exit(1);
+  const char *state_file = aocl_utils::getBitstreamStateFile();
+  bool resident = aocl_utils::prepareBinaryLoad(state_file, binary_file.c_str(), device_id, num_devices);
+
   // Create the context.
   context = clCreateContext(NULL, num_devices, device_id, NULL, NULL, &status);
   aocl_utils::checkError(status, "Failed to create context");
 
-  // Create the program for all device. Use the first device as the
-  // representative device (assuming all device are of the same type).
-  std::string binary_file = aocl_utils::getBoardBinaryFile(name, device_id[0]);
-  std::cout << "Using AOCX: " << binary_file.c_str() << std::endl;
-  program = createProgramFromBinary(context, binary_file.c_str(), device_id, num_devices);
-  
-  // Build the program that was just created.
-  status = clBuildProgram(program, 0, NULL, "", NULL, NULL);
-  aocl_utils::checkError(status, "Failed to build program");
+  // Create and build the program, reconfiguring the FPGA unless the
+  // resident bitstream can be reused.
+  program = aocl_utils::loadProgramFromBinary(context, binary_file.c_str(), device_id, num_devices, resident, state_file);
 
   // kernel
   kernel = clCreateKernel(program, name, &status);
@@ -179,43 +191,61 @@ void init_opencl() {
   }
 
   // command queue
-  command_queue = clCreateCommandQueue(context, device_id[0], 0, &status);
+  command_queue = clCreateCommandQueue(context, device_id[0], aocl_utils::traceQueueProperties(CL_QUEUE_PROFILING_ENABLE), &status);
 
   // memory object_m
-  Y_buf = clCreateBuffer(context, CL_MEM_WRITE_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(int)*try_num, NULL, &status);
-  aocl_utils::checkError(status, "Failed to create buffer for Y");
-  X_buf = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, sizeof(int)*datanum, NULL, &status);
-  aocl_utils::checkError(status, "Failed to create buffer for X");
-  I_buf = clCreateBuffer(context, CL_MEM_READ_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(int)*try_num, NULL, &status);
-  aocl_utils::checkError(status, "Failed to create buffer for I");
+  pool.setContext(context);
+  Y_buf = pool.acquire(CL_MEM_WRITE_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(int)*try_num);
+  X_buf = pool.acquire(CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, sizeof(int)*datanum);
+  I_buf = pool.acquire(CL_MEM_READ_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(int)*try_num);
 
   // host to device_m
-  status = clEnqueueWriteBuffer(command_queue, X_buf, CL_FALSE, 0, sizeof(int)*datanum , X , 0, NULL, &write_event[0]);
+  status = clEnqueueWriteBuffer(command_queue, X_buf, CL_FALSE, 0, sizeof(int)*datanum , X , 0, NULL, write_event[0].out());
   aocl_utils::checkError(status, "Failed to transfer input X");
-  status = clEnqueueWriteBuffer(command_queue, I_buf, CL_FALSE, 0, sizeof(int)*try_num , I , 0, NULL, &write_event[1]);
+  aocl_utils::traceCommand(write_event[0], "write X");
+  status = clEnqueueWriteBuffer(command_queue, I_buf, CL_FALSE, 0, sizeof(int)*try_num , I , 0, NULL, write_event[1].out());
   aocl_utils::checkError(status, "Failed to transfer input I");
+  aocl_utils::traceCommand(write_event[1], "write I");
 
   // Set kernel arguments.
   unsigned argi = 0;
-  status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), &Y_buf);   aocl_utils::checkError(status, "Failed to set argument Y");
-  status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), &X_buf);   aocl_utils::checkError(status, "Failed to set argument X");
-  status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), &I_buf);   aocl_utils::checkError(status, "Failed to set argument I");
-  status = clSetKernelArg(kernel, argi++, sizeof(int),    &try_num); aocl_utils::checkError(status, "Failed to set argument N");
+  status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), Y_buf.ptr()); aocl_utils::checkError(status, "Failed to set argument Y");
+  status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), X_buf.ptr()); aocl_utils::checkError(status, "Failed to set argument X");
+  status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), I_buf.ptr()); aocl_utils::checkError(status, "Failed to set argument I");
+  status = clSetKernelArg(kernel, argi++, sizeof(int),    &try_num);    aocl_utils::checkError(status, "Failed to set argument N");
 }
 
 
 /********************************************************************/
 void run() {
-  status = clEnqueueNDRangeKernel(command_queue, kernel, 1, NULL, global_item_size, local_item_size, 2, write_event, &kernel_event);
+  cl_event wait_list[2] = {write_event[0], write_event[1]};
+  status = clEnqueueNDRangeKernel(command_queue, kernel, 1, NULL, global_item_size, local_item_size, 2, wait_list, kernel_event.out());
   aocl_utils::checkError(status, "Failed to launch kernel");
+  aocl_utils::traceCommand(kernel_event, "kernel");
 }
 
 
 /********************************************************************/
 void readbuf() {
   // device to host_m
-  status = clEnqueueReadBuffer(command_queue, Y_buf, CL_TRUE, 0, sizeof(int)*try_num, Y, 1, &kernel_event, &finish_event);
+  status = clEnqueueReadBuffer(command_queue, Y_buf, CL_TRUE, 0, sizeof(int)*try_num, Y, 1, kernel_event.ptr(), finish_event.out());
   aocl_utils::checkError(status, "Failed to transfer output Y");
+  aocl_utils::traceCommand(finish_event, "read Y");
+}
+
+
+/********************************************************************/
+// The module reports load latencies, which depend on the memory, not a cycle
+// count the host knows in advance, so there is nothing to fit the clock
+// against: auto takes the kernel fmax that the compiler stored in the AOCX.
+float kernel_mhz() {
+  double fmax = aocl_utils::getBinaryFmaxMhz(binary_file.c_str());
+  if (fmax <= 0) {
+    std::cerr << "Error! No fmax in " << binary_file << "; give the frequency in MHz instead of auto." << std::endl;
+    exit(1);
+  }
+  std::cout << "Kernel clock: " << fmax << " MHz (fmax of the AOCX)" << std::endl;
+  return fmax;
 }
 
 
@@ -234,6 +264,14 @@ void verify() {
     std::cout << std::string(30, '-') << std::endl;
     std::cout << "Avg. cycles: " << (float(Y[0]) / float(try_num));
     std::cout << " (" << (float(Y[0]) / float(try_num)) * (float(1000)/frequency) << " nsec)" << std::endl;
+    // The same loads through the DDR model
+    aocl_utils::DdrModel ddr(aocl_utils::DdrConfig::fromEnv(frequency));
+    std::vector<int> predicted(try_num);
+    aocl_utils::predictLatencyKernelCycles(ddr, 0, I, try_num, predicted.data());
+    uint64_t predicted_sum = 0;
+    for (size_t i = 0; i < try_num; ++i) predicted_sum += predicted[i];
+    std::cout << std::flush;
+    aocl_utils::printPrediction(float(Y[0]) / float(try_num), double(predicted_sum) / double(try_num));
   } else {
     std::cout << "Error! Evaluation failed..." << std::endl;
   }
@@ -242,14 +280,17 @@ void verify() {
 
 /********************************************************************/
 void cleanup() {
-  for (int i = 0; i < 2; ++i) clReleaseEvent(write_event[i]);
+  for (int i = 0; i < 2; ++i) write_event[i].reset();
+  kernel_event.reset();
+  finish_event.reset();
   clFlush(command_queue);
   clFinish(command_queue);
-  clReleaseMemObject(Y_buf);
-  clReleaseMemObject(X_buf);
-  clReleaseMemObject(I_buf);
-  clReleaseKernel(kernel);
-  clReleaseProgram(program);
-  clReleaseCommandQueue(command_queue);
-  clReleaseContext(context);
+  Y_buf.release();
+  X_buf.release();
+  I_buf.release();
+  pool.trim();
+  kernel.reset();
+  program.reset();
+  command_queue.reset();
+  context.reset();
 }
@@ -0,0 +1,178 @@
+// Verilator harness for the DRAM RTL modules: Avalon-MM memory model.
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "avalon_mem.h"
+
+namespace dram_sim {
+
+static const unsigned PAGE_WORDS = 1024;
+
+static double envDouble(const char *name, double default_value) {
+  const char *value = getenv(name);
+  return (value != NULL && *value != '\0') ? strtod(value, NULL) : default_value;
+}
+
+// Configuration
+/********************************************************************/
+MemConfig MemConfig::fromEnv() {
+  MemConfig c;
+  c.wait_period      = (unsigned)envDouble("SIM_MEM_WAIT_PERIOD", 0);
+  c.wait_cycles      = (unsigned)envDouble("SIM_MEM_WAIT_CYCLES", 0);
+  c.wait_probability = envDouble("SIM_MEM_WAIT_PROB", 0);
+  c.seed             = (unsigned)envDouble("SIM_SEED", 1);
+  return c;
+}
+
+void MemConfig::print() const {
+  if(wait_period > 0 && wait_cycles > 0) {
+    printf("Injected waitrequest: %u/%u cycles\n", wait_cycles, wait_period);
+  }
+  if(wait_probability > 0) {
+    printf("Injected waitrequest: random, p=%.3f (seed %u)\n", wait_probability, seed);
+  }
+}
+
+void AvalonMemory::printStats() const {
+  const aocl_utils::DdrStats &ddr = m_ddr.stats();
+  printf("Read:  %llu bursts, %llu beats\n", (unsigned long long)m_stats.read_bursts, (unsigned long long)m_stats.read_beats);
+  printf("Write: %llu bursts, %llu beats\n", (unsigned long long)m_stats.write_bursts, (unsigned long long)m_stats.write_beats);
+  printf("Rows:  %llu hits, %llu misses, %llu refreshes\n",
+         (unsigned long long)ddr.row_hits, (unsigned long long)ddr.row_misses, (unsigned long long)ddr.refreshes);
+  printf("Cycles held off by waitrequest: %llu\n", (unsigned long long)m_stats.wait_cycles);
+}
+
+
+// Contents
+/********************************************************************/
+AvalonMemory::AvalonMemory(const MemConfig &config, const aocl_utils::DdrConfig &ddr)
+  : m_config(config),
+    m_ddr(ddr),
+    m_rng(config.seed),
+    m_now(0),
+    m_pending(0),
+    m_write_addr(0),
+    m_write_remaining(0),
+    m_waitrequest(false),
+    m_readdatavalid(false),
+    m_writeack(false) {
+  m_stats = MemStats();
+  std::fill(m_readdata, m_readdata + BEAT_WORDS, 0);
+}
+
+uint32_t AvalonMemory::load(uint64_t addr) const {
+  uint64_t word = addr >> 2;
+  std::unordered_map<uint64_t, std::vector<uint32_t> >::const_iterator it = m_pages.find(word / PAGE_WORDS);
+  if(it != m_pages.end()) {
+    return it->second[word % PAGE_WORDS];
+  }
+  return m_init ? m_init(word << 2) : 0;
+}
+
+void AvalonMemory::store(uint64_t addr, uint32_t value) {
+  uint64_t word = addr >> 2;
+  std::vector<uint32_t> &page = m_pages[word / PAGE_WORDS];
+  if(page.empty()) {
+    // Materialize the page with the initial contents
+    uint64_t first = (word / PAGE_WORDS) * PAGE_WORDS;
+    page.resize(PAGE_WORDS);
+    for(unsigned i = 0; i < PAGE_WORDS; ++i) {
+      page[i] = m_init ? m_init((first + i) << 2) : 0;
+    }
+  }
+  page[word % PAGE_WORDS] = value;
+}
+
+
+// Timing
+/********************************************************************/
+void AvalonMemory::scheduleRead(uint64_t addr, unsigned burstcount) {
+  uint64_t base = addr & ~(uint64_t)(BEAT_BYTES - 1);
+  for(unsigned i = 0; i < burstcount; ++i) {
+    uint64_t beat_addr = base + (uint64_t)i * BEAT_BYTES;
+    Beat beat = { m_ddr.readBeat(m_now, beat_addr), beat_addr, i + 1 == burstcount };
+    m_beats.push_back(beat);
+  }
+  ++m_pending;
+  ++m_stats.read_bursts;
+}
+
+void AvalonMemory::writeBeat(const AvalonMaster &master) {
+  if(m_write_remaining == 0) {
+    // First beat of a burst carries the address and burst count
+    m_write_addr = master.address & ~(uint64_t)(BEAT_BYTES - 1);
+    m_write_remaining = std::max(master.burstcount, 1u);
+    ++m_stats.write_bursts;
+  }
+
+  for(unsigned w = 0; w < BEAT_WORDS; ++w) {
+    unsigned enable = (unsigned)(master.byteenable >> (4 * w)) & 0xf;
+    if(enable == 0) {
+      continue;
+    }
+    uint64_t word_addr = m_write_addr + 4 * w;
+    uint32_t value = master.writedata[w];
+    if(enable != 0xf) {
+      uint32_t mask = 0;
+      for(unsigned b = 0; b < 4; ++b) {
+        if(enable & (1u << b)) {
+          mask |= 0xffu << (8 * b);
+        }
+      }
+      value = (load(word_addr) & ~mask) | (value & mask);
+    }
+    store(word_addr, value);
+  }
+  ++m_stats.write_beats;
+
+  uint64_t done = m_ddr.writeBeat(m_now, m_write_addr);
+  m_write_addr += BEAT_BYTES;
+  if(--m_write_remaining == 0) {
+    m_ddr.scheduleWriteAck(m_now, done);
+  }
+}
+
+void AvalonMemory::drive(uint64_t now) {
+  m_now = now;
+
+  m_readdatavalid = (!m_beats.empty() && m_beats.front().ready <= now);
+  if(m_readdatavalid) {
+    const Beat &beat = m_beats.front();
+    for(unsigned w = 0; w < BEAT_WORDS; ++w) {
+      m_readdata[w] = load(beat.addr + 4 * w);
+    }
+    if(beat.last) {
+      --m_pending;
+    }
+    m_beats.pop_front();
+    ++m_stats.read_beats;
+  }
+
+  m_writeack = m_ddr.takeWriteAck(now);
+
+  bool stall = (m_config.wait_period > 0 && now % m_config.wait_period < m_config.wait_cycles);
+  if(m_config.wait_probability > 0) {
+    stall = (std::uniform_real_distribution<double>(0.0, 1.0)(m_rng) < m_config.wait_probability) || stall;
+  }
+  m_waitrequest = stall || m_pending >= m_ddr.config().queue_depth || !m_ddr.canWrite(now);
+}
+
+void AvalonMemory::sample(const AvalonMaster &master) {
+  if(!master.read && !master.write) {
+    return;
+  }
+  if(m_waitrequest) {
+    ++m_stats.wait_cycles;
+    return;
+  }
+  if(master.read) {
+    scheduleRead(master.address, std::max(master.burstcount, 1u));
+  }
+  if(master.write) {
+    writeBeat(master);
+  }
+}
+
+} // ns dram_sim
@@ -0,0 +1,123 @@
+// Verilator harness for the DRAM RTL modules: Avalon-MM memory model.
+//
+// AvalonMemory is the slave side of the 512-bit Avalon-MM port that aoc
+// connects an RTL module's AVALON_MEM interface to. Its timing comes from the
+// DDR model in common (AOCLUtils/ddr_model.h: banks and rows, tRCD/tRP/tCL,
+// refresh, the data bus, the controller latency and queue); on top of that
+// it handles
+//  - bursts, whose beats are returned one per cycle in order,
+//  - waitrequest backpressure: injected (periodic and/or random), when too
+//    many read bursts are outstanding and when the write buffer is full,
+//  - one writeack per write burst.
+// Addresses are byte addresses; the low 6 bits are ignored, as the
+// interconnect does for a 512-bit slave.
+//
+// Every cycle, the harness calls drive() before the rising clock edge to get
+// the slave outputs, and sample() with the master outputs at the edge.
+
+#ifndef DRAM_SIM_AVALON_MEM_H
+#define DRAM_SIM_AVALON_MEM_H
+
+#include <deque>
+#include <functional>
+#include <random>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+#include "AOCLUtils/ddr_model.h"
+
+namespace dram_sim {
+
+static const unsigned BEAT_BYTES = 64;                 // 512 bits
+static const unsigned BEAT_WORDS = BEAT_BYTES / 4;
+
+// Backpressure injected on top of the DDR model, read from the environment
+// (defaults in brackets).
+struct MemConfig {
+  unsigned wait_period;         // SIM_MEM_WAIT_PERIOD [0]: waitrequest for wait_cycles
+  unsigned wait_cycles;         // SIM_MEM_WAIT_CYCLES [0]:   cycles out of every wait_period
+  double   wait_probability;    // SIM_MEM_WAIT_PROB [0]: random waitrequest per cycle
+  unsigned seed;                // SIM_SEED [1]
+
+  static MemConfig fromEnv();
+  void print() const;
+};
+
+// Outputs of the master, sampled at the rising clock edge.
+struct AvalonMaster {
+  uint64_t        address;
+  bool            read;
+  bool            write;
+  unsigned        burstcount;
+  const uint32_t *writedata;   // BEAT_WORDS words
+  uint64_t        byteenable;
+};
+
+struct MemStats {
+  uint64_t read_bursts;
+  uint64_t read_beats;
+  uint64_t write_bursts;
+  uint64_t write_beats;
+  uint64_t wait_cycles;         // cycles a request was held off by waitrequest
+};
+
+class AvalonMemory {
+public:
+  AvalonMemory(const MemConfig &config, const aocl_utils::DdrConfig &ddr);
+
+  // Contents of words that have not been written (zero by default).
+  void setInitializer(const std::function<uint32_t(uint64_t addr)> &init) { m_init = init; }
+  uint32_t load(uint64_t addr) const;
+  void store(uint64_t addr, uint32_t value);
+
+  // Computes the slave outputs of cycle `now`.
+  void drive(uint64_t now);
+  bool waitrequest() const { return m_waitrequest; }
+  bool readdatavalid() const { return m_readdatavalid; }
+  const uint32_t *readdata() const { return m_readdata; }
+  bool writeack() const { return m_writeack; }
+
+  // Accepts a read command or write beat unless waitrequest is asserted.
+  void sample(const AvalonMaster &master);
+
+  // True if no read beats or write acks are still due
+  bool idle() const { return m_beats.empty() && !m_ddr.pendingWriteAcks() && m_write_remaining == 0; }
+
+  const MemConfig &config() const { return m_config; }
+  const MemStats &stats() const { return m_stats; }
+  const aocl_utils::DdrModel &ddr() const { return m_ddr; }
+  void printStats() const;
+
+private:
+  struct Beat {
+    uint64_t ready;   // cycle the beat is returned in
+    uint64_t addr;
+    bool     last;    // last beat of its burst
+  };
+
+  void scheduleRead(uint64_t addr, unsigned burstcount);
+  void writeBeat(const AvalonMaster &master);
+
+  MemConfig                                               m_config;
+  aocl_utils::DdrModel                                    m_ddr;
+  std::function<uint32_t(uint64_t)>                       m_init;
+  std::unordered_map<uint64_t, std::vector<uint32_t> >    m_pages;
+  std::mt19937                                            m_rng;
+  MemStats                                                m_stats;
+
+  uint64_t                                                m_now;
+  std::deque<Beat>                                        m_beats;        // scheduled read beats
+  unsigned                                                m_pending;      // outstanding read bursts
+  uint64_t                                                m_write_addr;
+  unsigned                                                m_write_remaining;
+
+  bool                                                    m_waitrequest;
+  bool                                                    m_readdatavalid;
+  uint32_t                                                m_readdata[BEAT_WORDS];
+  bool                                                    m_writeack;
+};
+
+} // ns dram_sim
+
+#endif
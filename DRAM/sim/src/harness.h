@@ -0,0 +1,212 @@
+// Verilator harness for the DRAM RTL modules: clocking and the kernel side.
+//
+// Harness<Top, Port> clocks a Verilated RTL module the way the aoc pipeline
+// does: it presents the arguments with m_valid_in until the module accepts
+// them (m_ready_out), then waits for m_valid_out and takes the result with
+// m_ready_in. The module's Avalon-MM port, named by Port (see
+// AVALON_MM_PORT), is connected to an AvalonMemory.
+//
+// Environment: SIM_READY_IN_DELAY [0] holds m_ready_in low for that many
+// cycles of m_valid_out; SIM_TIMEOUT_CYCLES [2^32] bounds a call; SIM_VCD
+// names a waveform file when the harness is built with TRACE=1.
+
+#ifndef DRAM_SIM_HARNESS_H
+#define DRAM_SIM_HARNESS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "verilated.h"
+#if VM_TRACE
+#include "verilated_vcd_c.h"
+#endif
+
+#include "avalon_mem.h"
+
+// Connects the Avalon-MM port `prefix` (src, dst) of a module to the memory
+// model. Defines a Port class for Harness.
+#define AVALON_MM_PORT(Name, prefix)                                            \
+  struct Name {                                                                 \
+    template<class Top>                                                         \
+    static void drive(Top *top, const dram_sim::AvalonMemory &mem) {            \
+      top->prefix##_waitrequest   = mem.waitrequest();                          \
+      top->prefix##_readdatavalid = mem.readdatavalid();                        \
+      top->prefix##_writeack      = mem.writeack();                             \
+      for(unsigned w = 0; w < dram_sim::BEAT_WORDS; ++w) {                      \
+        top->prefix##_readdata[w] = mem.readdata()[w];                          \
+      }                                                                         \
+    }                                                                           \
+    template<class Top>                                                         \
+    static dram_sim::AvalonMaster sample(Top *top, uint32_t *writedata) {       \
+      for(unsigned w = 0; w < dram_sim::BEAT_WORDS; ++w) {                      \
+        writedata[w] = top->prefix##_writedata[w];                              \
+      }                                                                         \
+      dram_sim::AvalonMaster m = { top->prefix##_address,                       \
+                                   top->prefix##_read != 0,                     \
+                                   top->prefix##_write != 0,                    \
+                                   (unsigned)top->prefix##_burstcount,          \
+                                   writedata,                                   \
+                                   (uint64_t)top->prefix##_byteenable };        \
+      return m;                                                                 \
+    }                                                                           \
+  }
+
+namespace dram_sim {
+
+template<class Top, class Port>
+class Harness {
+public:
+  explicit Harness(AvalonMemory &mem)
+    : m_mem(mem), m_top(new Top), m_cycle(0), m_call_start(0), m_valid_out_cycles(0), m_trace(NULL) {
+    const char *delay = getenv("SIM_READY_IN_DELAY");
+    const char *timeout = getenv("SIM_TIMEOUT_CYCLES");
+    m_ready_in_delay = (delay != NULL) ? strtoull(delay, NULL, 0) : 0;
+    m_timeout = (timeout != NULL) ? strtoull(timeout, NULL, 0) : (1ULL << 32);
+#if VM_TRACE
+    const char *vcd = getenv("SIM_VCD");
+    if(vcd != NULL) {
+      Verilated::traceEverOn(true);
+      m_trace = new VerilatedVcdC;
+      m_top->trace(m_trace, 99);
+      m_trace->open(vcd);
+    }
+#endif
+    m_top->clock = 0;
+    m_top->resetn = 0;
+    m_top->m_valid_in = 0;
+    m_top->m_ready_in = 0;
+    for(unsigned i = 0; i < 4; ++i) {
+      tick();
+    }
+    m_top->resetn = 1;
+    tick();
+  }
+
+  ~Harness() {
+    m_top->final();
+#if VM_TRACE
+    if(m_trace != NULL) {
+      m_trace->close();
+      delete m_trace;
+    }
+#endif
+    delete m_top;
+  }
+
+  // Module inputs other than the handshake (the kernel arguments)
+  Top *top() { return m_top; }
+
+  // Cycles since reset
+  uint64_t cycle() const { return m_cycle; }
+
+  // Cycle in which the last call was accepted, the `start` of the
+  // predict* functions of AOCLUtils/ddr_model.h
+  uint64_t callStart() const { return m_call_start; }
+
+  // One call of the RTL function with the arguments already set on top().
+  // Returns m_output_value; `cycles` (if given) is set to the cycles from
+  // the module accepting the arguments to it returning the result.
+  uint32_t call(uint64_t *cycles = NULL) {
+    uint64_t deadline = m_cycle + m_timeout;
+
+    m_top->m_valid_in = 1;
+    while(!tick().started) {
+      checkTimeout(deadline);
+    }
+    m_top->m_valid_in = 0;
+    m_call_start = m_cycle - 1;
+
+    Edge edge;
+    do {
+      edge = tick();
+      checkTimeout(deadline);
+    } while(!edge.returned);
+
+    if(cycles != NULL) {
+      *cycles = m_cycle - 1 - m_call_start;
+    }
+    return edge.output;
+  }
+
+  // Clocks the module until the memory has no more beats or acks to give
+  void drain() {
+    uint64_t deadline = m_cycle + m_timeout;
+    while(!m_mem.idle()) {
+      tick();
+      checkTimeout(deadline);
+    }
+  }
+
+private:
+  struct Edge {
+    bool     started;   // arguments accepted at this edge
+    bool     returned;  // result taken at this edge
+    uint32_t output;
+  };
+
+  Edge tick() {
+    // Inputs of this cycle
+    m_mem.drive(m_cycle);
+    Port::drive(m_top, m_mem);
+    m_top->m_ready_in = (m_top->m_valid_out && m_valid_out_cycles >= m_ready_in_delay);
+    m_top->clock = 0;
+    m_top->eval();
+    dump(2 * m_cycle);
+
+    // Everything the module and the memory see at the rising edge
+    Edge edge;
+    edge.started = m_top->resetn && m_top->m_ready_out && m_top->m_valid_in;
+    edge.returned = m_top->resetn && m_top->m_valid_out && m_top->m_ready_in;
+    edge.output = m_top->m_output_value;
+    m_valid_out_cycles = m_top->m_valid_out ? m_valid_out_cycles + 1 : 0;
+    if(m_top->resetn) {
+      m_mem.sample(Port::sample(m_top, m_writedata));
+    }
+
+    m_top->clock = 1;
+    m_top->eval();
+    dump(2 * m_cycle + 1);
+    ++m_cycle;
+    return edge;
+  }
+
+  void dump(uint64_t time) {
+#if VM_TRACE
+    if(m_trace != NULL) {
+      m_trace->dump(time);
+    }
+#else
+    (void)time;
+#endif
+  }
+
+  void checkTimeout(uint64_t deadline) {
+    if(m_cycle >= deadline) {
+      fprintf(stderr, "ERROR: The module did not finish within %llu cycles.\n", (unsigned long long)m_timeout);
+      exit(1);
+    }
+  }
+
+  AvalonMemory &m_mem;
+  Top          *m_top;
+  uint64_t      m_cycle;
+  uint64_t      m_call_start;
+  uint64_t      m_valid_out_cycles;
+  uint64_t      m_ready_in_delay;
+  uint64_t      m_timeout;
+  uint32_t      m_writedata[BEAT_WORDS];
+#if VM_TRACE
+  VerilatedVcdC *m_trace;
+#else
+  void          *m_trace;
+#endif
+
+  // noncopyable
+  Harness(const Harness &);
+  Harness &operator =(const Harness &);
+};
+
+} // ns dram_sim
+
+#endif
@@ -0,0 +1,80 @@
+// Verilator harness for DRAM/bandwidth/read/device/read.v
+//
+// Does what the host in DRAM/bandwidth/read does, against the memory model:
+// X[i] = i + 1 is streamed through read(X, N) try_num times, and the cycle
+// counts the module returns are averaged into a bandwidth.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "Vread.h"
+#include "harness.h"
+
+AVALON_MM_PORT(SrcPort, src);
+
+// Byte address of X in the memory model
+static const uint64_t X_ADDR = 0;
+
+double sc_time_stamp() { return 0; }
+
+/********************************************************************/
+int main(int argc, char *argv[]) {
+  Verilated::commandArgs(argc, argv);
+
+  // check command line arguments
+  if(argc == 1) { printf("usage: ./tb_read_bandwidth <datanum> <try_num> <frequency>\n"); exit(0); }
+  if(argc != 4) { fprintf(stderr, "Error! The number of arguments is wrong.\n"); exit(1); }
+  size_t datanum   = std::stoull(std::string(argv[1]));
+  size_t try_num   = std::stoull(std::string(argv[2]));
+  float  frequency = std::stof(std::string(argv[3]));
+
+  aocl_utils::DdrConfig ddr_config = aocl_utils::DdrConfig::fromEnv(frequency);
+  dram_sim::MemConfig config = dram_sim::MemConfig::fromEnv();
+  ddr_config.print();
+  config.print();
+  dram_sim::AvalonMemory mem(config, ddr_config);
+  // Runs the same calls through the software model of the module
+  aocl_utils::DdrModel predictor(ddr_config);
+  mem.setInitializer([](uint64_t addr) { return (uint32_t)((addr - X_ADDR) / 4 + 1); });
+
+  dram_sim::Harness<Vread, SrcPort> sim(mem);
+  sim.top()->m_src_addr = X_ADDR;
+  sim.top()->m_input_index = (uint32_t)datanum;
+
+  // read.v reads (N + 15) / 16 beats
+  uint64_t beats = (datanum + dram_sim::BEAT_WORDS - 1) / dram_sim::BEAT_WORDS;
+  std::vector<uint32_t> cycles_list(try_num);
+  uint64_t call_cycles = 0, predicted_sum = 0;
+  for(size_t i = 0; i < try_num; ++i) {
+    uint64_t cycles;
+    cycles_list[i] = sim.call(&cycles);
+    call_cycles += cycles;
+    predicted_sum += aocl_utils::predictDramReadCycles(predictor, sim.callStart(), X_ADDR, beats);
+  }
+
+  bool     error      = false;
+  uint64_t cycles_sum = 0;
+  printf("\n");
+  for(size_t i = 0; i < try_num; ++i) {
+    if(cycles_list[i] == 0) error = true;
+    cycles_sum += cycles_list[i];
+  }
+  if(error) {
+    printf("Error! Evaluation failed...\n");
+    return 1;
+  }
+
+  float avg_cycles   = float(cycles_sum) / float(try_num);
+  float elapsed_time = avg_cycles / (frequency * 1.0e6f);
+  float bandwidth    = float(sizeof(int) * datanum) / elapsed_time;
+  printf("Verification: PASS\n");
+  printf("%s\n", std::string(50, '-').c_str());
+  printf("Avg. cycles: %.9g\n", avg_cycles);
+  printf("Memory read bandwidth: %.9g GB/s (%.9g sec)\n", bandwidth * 1.0e-9, elapsed_time);
+  aocl_utils::printPrediction(avg_cycles, double(predicted_sum) / double(try_num));
+  printf("Avg. cycles from call to return: %.9g\n", double(call_cycles) / double(try_num));
+  mem.printStats();
+  return 0;
+}
@@ -0,0 +1,81 @@
+// Verilator harness for DRAM/latency/read/device/read.v
+//
+// Does what the host in DRAM/latency/read does, against the memory model:
+// try_num loads of X[I[i]] from random indices, each timed by the module.
+// The indices are aligned to 512 bits: the module compares the low 32 bits
+// of the beat, which hold X[I[i]] only if I[i] is the first word of it.
+
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "Vread.h"
+#include "harness.h"
+
+AVALON_MM_PORT(SrcPort, src);
+
+// Byte address of X in the memory model
+static const uint64_t X_ADDR = 0;
+
+double sc_time_stamp() { return 0; }
+
+/********************************************************************/
+int main(int argc, char *argv[]) {
+  Verilated::commandArgs(argc, argv);
+
+  // check command line arguments
+  if(argc == 1) { printf("usage: ./tb_read_latency <datanum> <try_num> <frequency>\n"); exit(0); }
+  if(argc != 4) { fprintf(stderr, "Error! The number of arguments is wrong.\n"); exit(1); }
+  size_t datanum   = std::stoull(std::string(argv[1]));
+  size_t try_num   = std::stoull(std::string(argv[2]));
+  float  frequency = std::stof(std::string(argv[3]));
+
+  aocl_utils::DdrConfig ddr_config = aocl_utils::DdrConfig::fromEnv(frequency);
+  dram_sim::MemConfig config = dram_sim::MemConfig::fromEnv();
+  ddr_config.print();
+  config.print();
+  dram_sim::AvalonMemory mem(config, ddr_config);
+  // Runs the same calls through the software model of the module
+  aocl_utils::DdrModel predictor(ddr_config);
+  mem.setInitializer([](uint64_t addr) { return (uint32_t)((addr - X_ADDR) / 4 + 1); });
+
+  std::mt19937 engine(config.seed);
+  std::uniform_int_distribution<size_t> distribution(0, datanum - 1);
+  std::vector<uint32_t> I(try_num), Y(try_num);
+  for(size_t i = 0; i < try_num; ++i) {
+    I[i] = (uint32_t)distribution(engine);
+    I[i] -= I[i] % dram_sim::BEAT_WORDS;
+  }
+
+  dram_sim::Harness<Vread, SrcPort> sim(mem);
+  uint64_t predicted_sum = 0;
+  for(size_t i = 0; i < try_num; ++i) {
+    uint64_t addr = X_ADDR + 4 * (uint64_t)I[i];
+    sim.top()->m_src_addr = X_ADDR;
+    sim.top()->m_input_index = I[i];
+    sim.top()->m_input_value = mem.load(addr);
+    Y[i] = sim.call();
+    predicted_sum += aocl_utils::predictReadLatencyCycles(predictor, sim.callStart(), addr);
+  }
+
+  bool     error      = false;
+  uint64_t cycles_sum = 0;
+  printf("\n");
+  for(size_t i = 0; i < try_num; ++i) {
+    if(Y[i] == 0) error = true;
+    cycles_sum += Y[i];
+  }
+  if(error) {
+    printf("Error! Evaluation failed...\n");
+    return 1;
+  }
+
+  float avg_cycles = float(cycles_sum) / float(try_num);
+  printf("%s\n", std::string(30, '-').c_str());
+  printf("Avg. cycles: %g (%g nsec)\n", avg_cycles, avg_cycles * (1000.0f / frequency));
+  aocl_utils::printPrediction(avg_cycles, double(predicted_sum) / double(try_num));
+  mem.printStats();
+  return 0;
+}
@@ -0,0 +1,88 @@
+// Verilator harness for DRAM/bandwidth/write/device/write.v
+//
+// Calls write(Y, N) try_num times against the memory model, checks that
+// Y[i] = i was stored for every element of the beats written and averages
+// the cycle counts the module returns into a bandwidth.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+
+#include "Vwrite.h"
+#include "harness.h"
+
+AVALON_MM_PORT(DstPort, dst);
+
+// Byte address of Y in the memory model
+static const uint64_t Y_ADDR = 0;
+
+double sc_time_stamp() { return 0; }
+
+/********************************************************************/
+int main(int argc, char *argv[]) {
+  Verilated::commandArgs(argc, argv);
+
+  // check command line arguments
+  if(argc == 1) { printf("usage: ./tb_write_bandwidth <datanum> <try_num> <frequency>\n"); exit(0); }
+  if(argc != 4) { fprintf(stderr, "Error! The number of arguments is wrong.\n"); exit(1); }
+  size_t datanum   = std::stoull(std::string(argv[1]));
+  size_t try_num   = std::stoull(std::string(argv[2]));
+  float  frequency = std::stof(std::string(argv[3]));
+
+  aocl_utils::DdrConfig ddr_config = aocl_utils::DdrConfig::fromEnv(frequency);
+  dram_sim::MemConfig config = dram_sim::MemConfig::fromEnv();
+  ddr_config.print();
+  config.print();
+  dram_sim::AvalonMemory mem(config, ddr_config);
+  // Runs the same calls through the software model of the module
+  aocl_utils::DdrModel predictor(ddr_config);
+  // Anything but the value the module writes
+  mem.setInitializer([](uint64_t) { return 0xdeadbeefu; });
+
+  dram_sim::Harness<Vwrite, DstPort> sim(mem);
+  sim.top()->m_dst_addr = Y_ADDR;
+  sim.top()->m_input_index = (uint32_t)datanum;
+
+  // write.v writes (N + 15) / 16 beats
+  uint64_t beats = (datanum + dram_sim::BEAT_WORDS - 1) / dram_sim::BEAT_WORDS;
+  std::vector<uint32_t> cycles_list(try_num);
+  uint64_t predicted_sum = 0;
+  for(size_t i = 0; i < try_num; ++i) {
+    cycles_list[i] = sim.call();
+    predicted_sum += aocl_utils::predictDramWriteCycles(predictor, sim.callStart(), Y_ADDR, beats);
+  }
+  sim.drain();
+
+  // write.v stores whole beats
+  size_t written = beats * dram_sim::BEAT_WORDS;
+  bool pass = true;
+  for(size_t i = 0; i < written && pass; ++i) {
+    uint32_t y = mem.load(Y_ADDR + 4 * (uint64_t)i);
+    if(y != (uint32_t)i) {
+      printf("Failed verification!!!\n");
+      printf("Y[%zu]: %u, expected: %zu\n", i, y, i);
+      pass = false;
+    }
+  }
+
+  uint64_t cycles_sum = 0;
+  for(size_t i = 0; i < try_num; ++i) {
+    cycles_sum += cycles_list[i];
+  }
+  printf("\n");
+  printf("Verification: %s\n", pass ? "PASS" : "FAIL");
+  if(!pass) {
+    return 1;
+  }
+
+  float avg_cycles   = float(cycles_sum) / float(try_num);
+  float elapsed_time = avg_cycles / (frequency * 1.0e6f);
+  float bandwidth    = float(sizeof(int) * datanum) / elapsed_time;
+  printf("%s\n", std::string(50, '-').c_str());
+  printf("Avg. cycles: %.9g\n", avg_cycles);
+  printf("Memory write bandwidth: %.9g GB/s (%.9g sec)\n", bandwidth * 1.0e-9, elapsed_time);
+  aocl_utils::printPrediction(avg_cycles, double(predicted_sum) / double(try_num));
+  mem.printStats();
+  return 0;
+}
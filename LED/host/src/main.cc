@@ -43,16 +43,16 @@ static const int WIDTH = 512;
 // OpenCL runtime configuration
 /********************************************************************/
 cl_uint                                num_devices   = 0;
-cl_context                             context       = NULL;
-cl_command_queue                       command_queue = NULL;
-cl_program                             program       = NULL;
-cl_kernel                              kernel        = NULL;
+aocl_utils::scoped_cl_context          context;
+aocl_utils::scoped_cl_command_queue    command_queue;
+aocl_utils::scoped_cl_program          program;
+aocl_utils::scoped_cl_kernel           kernel;
 cl_platform_id                         platform      = NULL;
 cl_int                                 status;
-cl_event                               write_event[2], kernel_event, finish_event;
-cl_mem                                 Y_buf;  // memory object for write
-cl_mem                                 X_buf;  // memory object for read
-cl_mem                                 I_buf;  // memory object for read
+aocl_utils::scoped_cl_event            write_event[2], kernel_event, finish_event;
+aocl_utils::scoped_cl_mem              Y_buf;  // memory object for write
+aocl_utils::scoped_cl_mem              X_buf;  // memory object for read
+aocl_utils::scoped_cl_mem              I_buf;  // memory object for read
 aocl_utils::scoped_array<cl_device_id> device_id;
 
 
@@ -158,19 +158,25 @@ void init_opencl() {
   std::cout << "Using " << num_devices << " device(s)" << std::endl;
   std::cout << " " << aocl_utils::getDeviceName(device_id[0]).c_str() << std::endl;
   
+  // Select the binary for all device. Use the first device as the
+  // representative device (assuming all device are of the same type).
+  // Whether the bitstream is already resident must be known before the
+  // context is created.
+  std::string binary_file = aocl_utils::getBoardBinaryFile(name, device_id[0]);
+  std::cout << "Using AOCX: " << binary_file.c_str() << std::endl;
+  // Without touching the device: what the AOCX holds, and whether it has the kernel
+  aocl_utils::printAocxSummary(binary_file.c_str());
+  if (!aocl_utils::checkAocxKernels(binary_file.c_str(), &name, 1)) exit(1);
+  const char *state_file = aocl_utils::getBitstreamStateFile();
+  bool resident = aocl_utils::prepareBinaryLoad(state_file, binary_file.c_str(), device_id, num_devices);
+
   // Create the context.
   context = clCreateContext(NULL, num_devices, device_id, NULL, NULL, &status);
   aocl_utils::checkError(status, "Failed to create context");
 
-  // Create the program for all device. Use the first device as the
-  // representative device (assuming all device are of the same type).
-  std::string binary_file = aocl_utils::getBoardBinaryFile(name, device_id[0]);
-  std::cout << "Using AOCX: " << binary_file.c_str() << std::endl;
-  program = createProgramFromBinary(context, binary_file.c_str(), device_id, num_devices);
-  
-  // Build the program that was just created.
-  status = clBuildProgram(program, 0, NULL, "", NULL, NULL);
-  aocl_utils::checkError(status, "Failed to build program");
+  // Create and build the program, reconfiguring the FPGA unless the
+  // resident bitstream can be reused.
+  program = aocl_utils::loadProgramFromBinary(context, binary_file.c_str(), device_id, num_devices, resident, state_file);
 
   // kernel
   kernel = clCreateKernel(program, name, &status);
@@ -180,7 +186,7 @@ void init_opencl() {
   }
 
   // command queue
-  command_queue = clCreateCommandQueue(context, device_id[0], 0, &status);
+  command_queue = clCreateCommandQueue(context, device_id[0], aocl_utils::traceQueueProperties(0), &status);
 
   // // memory object_m
   // Y_buf = clCreateBuffer(context, CL_MEM_WRITE_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(int)*try_num, NULL, &status);
@@ -209,16 +215,18 @@ void init_opencl() {
 /********************************************************************/
 void run() {
   // status = clEnqueueNDRangeKernel(command_queue, kernel, 1, NULL, global_item_size, local_item_size, 2, write_event, &kernel_event);
-  status = clEnqueueNDRangeKernel(command_queue, kernel, 1, NULL, global_item_size, local_item_size, 0, NULL, &kernel_event);
+  status = clEnqueueNDRangeKernel(command_queue, kernel, 1, NULL, global_item_size, local_item_size, 0, NULL, kernel_event.out());
   aocl_utils::checkError(status, "Failed to launch kernel");
+  aocl_utils::traceCommand(kernel_event, "kernel");
 }
 
 
 /********************************************************************/
 void readbuf() {
   // device to host_m
-  status = clEnqueueReadBuffer(command_queue, Y_buf, CL_TRUE, 0, sizeof(int)*try_num, Y, 1, &kernel_event, &finish_event);
+  status = clEnqueueReadBuffer(command_queue, Y_buf, CL_TRUE, 0, sizeof(int)*try_num, Y, 1, kernel_event.ptr(), finish_event.out());
   aocl_utils::checkError(status, "Failed to transfer output Y");
+  aocl_utils::traceCommand(finish_event, "read Y");
 }
 
 
@@ -245,14 +253,16 @@ void verify() {
 
 /********************************************************************/
 void cleanup() {
-  for (int i = 0; i < 2; ++i) clReleaseEvent(write_event[i]);
+  for (int i = 0; i < 2; ++i) write_event[i].reset();
+  kernel_event.reset();
+  finish_event.reset();
   clFlush(command_queue);
   clFinish(command_queue);
-  clReleaseMemObject(Y_buf);
-  clReleaseMemObject(X_buf);
-  clReleaseMemObject(I_buf);
-  clReleaseKernel(kernel);
-  clReleaseProgram(program);
-  clReleaseCommandQueue(command_queue);
-  clReleaseContext(context);
+  Y_buf.reset();
+  X_buf.reset();
+  I_buf.reset();
+  kernel.reset();
+  program.reset();
+  command_queue.reset();
+  context.reset();
 }
@@ -0,0 +1,55 @@
+///////////////////////////////////////////////////////////////////////////////////
+// Benchmark registry and result formatting of the aoclbench driver.
+///////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+
+#include "bench.h"
+
+namespace aoclbench {
+
+const size_t global_item_size[3] = {1, 1, 1};
+const size_t local_item_size[3]  = {1, 1, 1};
+
+
+/********************************************************************/
+std::string Result::str(const std::string &test) const {
+  std::stringstream ss;
+  ss << "test=" << test << " status=" << (m_pass ? "PASS" : "FAIL");
+  for (size_t i = 0; i < m_fields.size(); ++i) {
+    ss << " " << m_fields[i].first << "=" << m_fields[i].second;
+  }
+  return ss.str();
+}
+
+
+/********************************************************************/
+static std::vector<Benchmark *> &registry() {
+  // Constructed on first use, since registration happens during static
+  // initialization of the individual test files.
+  static std::vector<Benchmark *> benchmarks;
+  return benchmarks;
+}
+
+static bool byName(const Benchmark *a, const Benchmark *b) {
+  return std::string(a->name()) < std::string(b->name());
+}
+
+void registerBenchmark(Benchmark *benchmark) {
+  std::vector<Benchmark *> &benchmarks = registry();
+  benchmarks.insert(std::upper_bound(benchmarks.begin(), benchmarks.end(), benchmark, byName), benchmark);
+}
+
+const std::vector<Benchmark *> &benchmarks() {
+  return registry();
+}
+
+Benchmark *findBenchmark(const std::string &name) {
+  const std::vector<Benchmark *> &benchmarks = registry();
+  for (size_t i = 0; i < benchmarks.size(); ++i) {
+    if (name == benchmarks[i]->name()) return benchmarks[i];
+  }
+  return NULL;
+}
+
+} // ns aoclbench
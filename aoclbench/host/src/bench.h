@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////////
+// Benchmark interface and registry of the aoclbench driver.
+//
+// Each test is a Benchmark subclass in its own source file, registered with
+// REGISTER_BENCHMARK. The driver owns the Session (platform, device, context,
+// program, queue, buffers) and hands it to every test, so a suite of tests
+// shares a single device initialization.
+//
+// Every configuration of a test produces one result line:
+//   test=<name> status=<PASS|FAIL> <param>=<value> ... <metric>=<value> ...
+///////////////////////////////////////////////////////////////////////////////////
+
+#ifndef AOCLBENCH_BENCH_H
+#define AOCLBENCH_BENCH_H
+
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "CL/opencl.h"
+#include "AOCLUtils/aocl_utils.h"
+
+namespace aoclbench {
+
+// A parameter of a test: its name, default value and a short description.
+struct Param {
+  const char *name;
+  const char *default_value;
+  const char *help;
+};
+
+// One line of output: key=value pairs in insertion order.
+class Result {
+public:
+  Result() : m_pass(true) {}
+
+  template<typename T>
+  void add(const std::string &key, const T &value) {
+    std::stringstream ss;
+    ss << std::setprecision(std::numeric_limits<float>::max_digits10) << value;
+    m_fields.push_back(std::make_pair(key, ss.str()));
+  }
+
+  // Marks the configuration as failed if pass is false.
+  void check(bool pass) { m_pass = m_pass && pass; }
+  bool passed() const { return m_pass; }
+
+  std::string str(const std::string &test) const;
+
+private:
+  bool m_pass;
+  std::vector<std::pair<std::string, std::string> > m_fields;
+};
+
+// Thrown by Benchmark::run for a configuration it cannot run, such as an
+// unsupported parameter value. The driver reports the configuration as failed
+// and goes on with the next one.
+class ParamError : public std::runtime_error {
+public:
+  explicit ParamError(const std::string &what) : std::runtime_error(what) {}
+};
+
+class Benchmark {
+public:
+  virtual ~Benchmark() {}
+
+  virtual const char *name() const = 0;
+  virtual const char *description() const = 0;
+
+  // Default AOCX prefix (see getBoardBinaryFile), relative to the executable.
+  virtual const char *binary() const = 0;
+
+  // AOCX prefix of one configuration, given the prefix of the test (binary(),
+  // or the --<name>.aocx option). A test built as one AOCX per configuration
+  // appends what selects it; the driver loads that AOCX before run().
+  // Throws ParamError if there is no AOCX for the configuration.
+  virtual std::string binaryFor(const aocl_utils::SweepPoint &, const std::string &prefix) const { return prefix; }
+
+  // Parameters read from each configuration. Values given on the command line
+  // or in the sweep override the defaults.
+  virtual std::vector<Param> params() const = 0;
+
+  // Runs one configuration. The program built from binaryFor() is current.
+  // Throws ParamError if the configuration is invalid.
+  virtual void run(aocl_utils::Session &session, const aocl_utils::SweepPoint &point, Result &result) = 0;
+};
+
+// All registered benchmarks, sorted by name.
+const std::vector<Benchmark *> &benchmarks();
+
+// Returns the benchmark with the given name, or NULL.
+Benchmark *findBenchmark(const std::string &name);
+
+void registerBenchmark(Benchmark *benchmark);
+
+template<typename T>
+struct Registrar {
+  Registrar() { registerBenchmark(new T()); }
+};
+
+#define REGISTER_BENCHMARK(cls) static aoclbench::Registrar<cls> cls##_registrar
+
+// Work sizes of the single work-item kernels
+extern const size_t global_item_size[3];
+extern const size_t local_item_size[3];
+
+} // ns aoclbench
+
+#endif
@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////////////
+// Cycle counter test: the kernel of cycle_counter.
+//
+// wait_func waits for N cycles; the counter behind the io channels cnt_start,
+// cnt_stop and cnt_rslt measures the same call. The difference is the overhead
+// of the counter itself.
+///////////////////////////////////////////////////////////////////////////////////
+
+#include "bench.h"
+
+
+/********************************************************************/
+class CycleCounter : public aoclbench::Benchmark {
+public:
+  const char *name() const { return "cycle_counter"; }
+  const char *description() const { return "cycles of wait_func measured by the cycle counter"; }
+  const char *binary() const { return "../../cycle_counter/bin/tb_wait_func"; }
+  std::vector<aoclbench::Param> params() const {
+    aoclbench::Param params[] = {
+      {"cycles", "1M", "the number of cycles wait_func waits for"},
+    };
+    return std::vector<aoclbench::Param>(params, params + sizeof(params)/sizeof(params[0]));
+  }
+
+  void run(aocl_utils::Session &session, const aocl_utils::SweepPoint &point, aoclbench::Result &result) {
+    cl_long cycles = aocl_utils::getCount(point, "cycles", 1048576);
+    cl_int  status;
+
+    cl_mem E_buf = session.buffer("cycle_counter.E", CL_MEM_READ_WRITE | CL_CHANNEL_1_INTELFPGA, sizeof(cl_long));
+    cl_mem M_buf = session.buffer("cycle_counter.M", CL_MEM_READ_WRITE | CL_CHANNEL_1_INTELFPGA, sizeof(cl_long));
+
+    cl_kernel kernel = session.kernel("tb_wait_func");
+    unsigned  argi   = 0;
+    status = clSetKernelArg(kernel, argi++, sizeof(cl_mem),  &E_buf);  aocl_utils::checkError(status, "Failed to set argument expected");
+    status = clSetKernelArg(kernel, argi++, sizeof(cl_mem),  &M_buf);  aocl_utils::checkError(status, "Failed to set argument measured");
+    status = clSetKernelArg(kernel, argi++, sizeof(cl_long), &cycles); aocl_utils::checkError(status, "Failed to set argument N");
+
+    aocl_utils::scoped_cl_event kernel_event;
+    status = clEnqueueNDRangeKernel(session.queue(), kernel, 1, NULL, aoclbench::global_item_size, aoclbench::local_item_size, 0, NULL, kernel_event.out());
+    aocl_utils::checkError(status, "Failed to launch kernel");
+    aocl_utils::traceCommand(kernel_event, "kernel");
+
+    cl_long expected_cycles, measured_cycles;
+    status = clEnqueueReadBuffer(session.queue(), E_buf, CL_TRUE, 0, sizeof(cl_long), &expected_cycles, 1, kernel_event.ptr(), aocl_utils::traceEvent("read E"));
+    aocl_utils::checkError(status, "Failed to transfer output expected_cycles");
+    status = clEnqueueReadBuffer(session.queue(), M_buf, CL_TRUE, 0, sizeof(cl_long), &measured_cycles, 1, kernel_event.ptr(), aocl_utils::traceEvent("read M"));
+    aocl_utils::checkError(status, "Failed to transfer output measured_cycles");
+    double time = aocl_utils::getStartEndTime(kernel_event) * 1.0e-9;
+
+    // The counter can only add cycles to what wait_func took.
+    result.check(expected_cycles > 0 && measured_cycles >= expected_cycles);
+    result.add("cycles", cycles);
+    result.add("expected_cycles", expected_cycles);
+    result.add("measured_cycles", measured_cycles);
+    result.add("overhead_cycles", measured_cycles - expected_cycles);
+    result.add("time_s", time);
+  }
+};
+REGISTER_BENCHMARK(CycleCounter);
+
+
+// The tagged counters of common/device/aocl_counters.h: tb_regions runs
+// wait_func once for N cycles and four times for N/4 under one region ID,
+// inside a region of the whole kernel.
+/********************************************************************/
+class CycleCounterRegions : public aoclbench::Benchmark {
+public:
+  const char *name() const { return "cycle_counter_regions"; }
+  const char *description() const { return "cycles of wait_func regions measured by the tagged counters"; }
+  const char *binary() const { return "../../cycle_counter/bin/tb_regions"; }
+  std::vector<aoclbench::Param> params() const {
+    aoclbench::Param params[] = {
+      {"cycles", "1M", "the number of cycles of the region of one wait_func call"},
+    };
+    return std::vector<aoclbench::Param>(params, params + sizeof(params)/sizeof(params[0]));
+  }
+
+  void run(aocl_utils::Session &session, const aocl_utils::SweepPoint &point, aoclbench::Result &result) {
+    cl_long cycles = aocl_utils::getCount(point, "cycles", 1048576);
+    cl_int  status;
+
+    cl_mem R_buf = session.buffer("cycle_counter_regions.R", CL_MEM_READ_WRITE, sizeof(cl_long));
+    aocl_utils::CounterCollector counters(session.context(), session.program());
+
+    cl_kernel kernel = session.kernel("tb_regions");
+    unsigned  argi   = 0;
+    status = clSetKernelArg(kernel, argi++, sizeof(cl_mem),  &R_buf);  aocl_utils::checkError(status, "Failed to set argument result");
+    status = clSetKernelArg(kernel, argi++, sizeof(cl_long), &cycles); aocl_utils::checkError(status, "Failed to set argument N");
+
+    // Counts left over from earlier runs
+    counters.drain(session.queue());
+
+    aocl_utils::scoped_cl_event kernel_event;
+    status = clEnqueueNDRangeKernel(session.queue(), kernel, 1, NULL, aoclbench::global_item_size, aoclbench::local_item_size, 0, NULL, kernel_event.out());
+    aocl_utils::checkError(status, "Failed to launch kernel");
+    aocl_utils::traceCommand(kernel_event, "kernel");
+    counters.drain(session.queue(), 1, kernel_event.ptr());
+
+    // Each region takes at least its wait_func cycles (N + 2, see
+    // AOCLUtils/counter_model.h), and the whole kernel at least both of the
+    // others.
+    cl_ulong wait_once = aocl_utils::waitFuncResult(cycles), wait_loop = 4 * aocl_utils::waitFuncResult(cycles >> 2);
+    cl_ulong all = counters.rawCycles(0), once = counters.rawCycles(1), loop = counters.rawCycles(2);
+    result.check(counters.stops(0) == 1 && counters.stops(1) == 1 && counters.stops(2) == 4 &&
+                 once >= wait_once && loop >= wait_loop && all >= once + loop);
+    result.add("cycles", cycles);
+    result.add("all_cycles", all);
+    result.add("once_cycles", once);
+    result.add("loop_cycles", loop);
+    result.add("loop_stops", counters.stops(2));
+    result.add("loop_overhead_cycles", (double)(loop - wait_loop) / 4);
+    if (counters.calibrated()) {
+      // What is left of the overhead after the calibration is subtracted
+      result.add("loop_residual_cycles", (counters.cycles(2) - wait_loop) / 4);
+    }
+  }
+};
+REGISTER_BENCHMARK(CycleCounterRegions);
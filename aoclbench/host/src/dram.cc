@@ -0,0 +1,341 @@
+///////////////////////////////////////////////////////////////////////////////////
+// DRAM evaluation tests: the kernels of DRAM/bandwidth/read,
+// DRAM/bandwidth/write and DRAM/latency/read.
+//
+// Verification is performed on the RTL modules on FPGA for reads (a zero cycle
+// count signals an error) and on the host for writes.
+///////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <cstdint>
+#include <random>
+
+#include "bench.h"
+
+
+// Data width between RTL module and external memory
+/********************************************************************/
+static const int WIDTH = 512;
+static const int ELEMS_PER_ACCESS = WIDTH / (sizeof(int) << 3);
+
+
+// Input data shared by the read tests
+/********************************************************************/
+class InputX {
+public:
+  InputX(const std::string &tag) : m_tag(tag), m_num(0), m_buf_num(0) {}
+
+  // Returns a device buffer holding X[i] = i + 1 for the first datanum
+  // values, which is what the RTL modules verify against. The device copy
+  // stays valid across configurations as long as the buffer is not
+  // reallocated, so it is uploaded only when it has to grow.
+  cl_mem upload(aocl_utils::Session &session, size_t datanum, cl_mem_flags flags) {
+    bool allocated;
+    cl_mem X_buf = session.buffer(m_tag, flags, sizeof(int)*datanum, &allocated);
+    if (allocated) m_buf_num = 0;
+    if (m_buf_num < datanum) {
+      prepare(datanum);
+      cl_int status = clEnqueueWriteBuffer(session.queue(), X_buf, CL_TRUE, 0, sizeof(int)*datanum, m_X, 0, NULL, aocl_utils::traceEvent("write X"));
+      aocl_utils::checkError(status, "Failed to transfer input X");
+      m_buf_num = datanum;
+    }
+    return X_buf;
+  }
+
+private:
+  void prepare(size_t datanum) {
+    if (m_num >= datanum) return;
+    m_X.reset(datanum);
+    #pragma omp parallel for
+    for (size_t i = 0; i < datanum; ++i) {
+      m_X[i] = i + 1;
+    }
+    m_num = datanum;
+  }
+
+  std::string                         m_tag;
+  aocl_utils::scoped_aligned_ptr<int> m_X;       // X on the host PC
+  size_t                              m_num;     // the number of valid values in m_X
+  size_t                              m_buf_num; // the number of valid values in the device buffer
+};
+
+
+// The kernel clock of the current binary in MHz: freq if it is a number, and
+// for auto the measured clock if there is one, else the fmax of the AOCX.
+/********************************************************************/
+static double kernel_mhz(aocl_utils::Session &session, const std::string &freq, double measured_mhz) {
+  if (freq != "auto") return std::stod(freq);
+  if (measured_mhz > 0) return measured_mhz;
+  double fmax = aocl_utils::getBinaryFmaxMhz(session.binaryFile().c_str());
+  if (fmax <= 0) throw aoclbench::ParamError("No fmax in " + session.binaryFile() + "; give freq in MHz instead of auto");
+  return fmax;
+}
+
+
+/********************************************************************/
+class DramRead : public aoclbench::Benchmark {
+public:
+  DramRead() : m_X("dram_read.X"), m_mhz(0) {}
+
+  const char *name() const { return "dram_read"; }
+  const char *description() const { return "DRAM read bandwidth with bursts of the RTL module"; }
+  const char *binary() const { return "../../DRAM/bandwidth/read/bin/tb_read"; }
+  std::vector<aoclbench::Param> params() const {
+    aoclbench::Param params[] = {
+      {"datanum", "1M",    "the number of integer values read"},
+      {"tries",   "20",    "the number of kernel launches averaged"},
+      {"freq",    "auto",  "the kernel clock (MHz), or auto: measured, else the fmax of the AOCX"},
+    };
+    return std::vector<aoclbench::Param>(params, params + sizeof(params)/sizeof(params[0]));
+  }
+
+  void run(aocl_utils::Session &session, const aocl_utils::SweepPoint &point, aoclbench::Result &result) {
+    size_t datanum   = aocl_utils::getCount(point, "datanum", 1048576);
+    size_t try_num   = std::max<size_t>(1, aocl_utils::getCount(point, "tries", 20));
+    std::string freq = aocl_utils::getString(point, "freq", "auto");
+    cl_int status;
+
+    cl_mem X_buf = m_X.upload(session, datanum, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA);
+    cl_mem Y_buf = session.buffer("dram_read.Y", CL_MEM_WRITE_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(int));
+
+    cl_kernel kernel = session.kernel("tb_read");
+    cl_int    n      = datanum;
+    unsigned  argi   = 0;
+    status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), &Y_buf); aocl_utils::checkError(status, "Failed to set argument Y");
+    status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), &X_buf); aocl_utils::checkError(status, "Failed to set argument X");
+    status = clSetKernelArg(kernel, argi++, sizeof(cl_int), &n);     aocl_utils::checkError(status, "Failed to set argument N");
+    double frequency = kernel_mhz(session, freq, (freq == "auto") ? measure_mhz(session, kernel, Y_buf, n) : 0);
+
+    bool     error      = false;
+    uint64_t cycles_sum = 0;
+    for (size_t i = 0; i < try_num; ++i) {
+      cl_int cycles;
+      status = clEnqueueNDRangeKernel(session.queue(), kernel, 1, NULL, aoclbench::global_item_size, aoclbench::local_item_size, 0, NULL, aocl_utils::traceEvent("kernel"));
+      aocl_utils::checkError(status, "Failed to launch kernel");
+      status = clEnqueueReadBuffer(session.queue(), Y_buf, CL_TRUE, 0, sizeof(cl_int), &cycles, 0, NULL, aocl_utils::traceEvent("read Y"));
+      aocl_utils::checkError(status, "Failed to transfer output Y");
+      if (cycles == 0) error = true;
+      cycles_sum += cycles;
+    }
+
+    float avg_cycles   = float(cycles_sum) / float(try_num);
+    float elapsed_time = avg_cycles / (frequency * 1.0e6);
+    result.check(!error);
+    result.add("datanum", datanum);
+    result.add("tries", try_num);
+    result.add("kernel_mhz", frequency);
+    result.add("avg_cycles", avg_cycles);
+    result.add("bandwidth_GBps", float(sizeof(int) * datanum) / elapsed_time * 1.0e-9);
+
+    uint64_t fsm_cycles = aocl_utils::fsmReadCycles(aocl_utils::FsmParams::fromEnv(frequency), datanum);
+    result.add("fsm_cycles", fsm_cycles);
+    result.add("efficiency", double(fsm_cycles) / avg_cycles);
+  }
+
+private:
+  // The kernel clock from runs over 1/8, 1/4, 1/2 and all of X, fitting the
+  // cycles the module reports against the kernel time (see
+  // AOCLUtils/kernel_clock.h), once per binary. Returns 0 if the module
+  // reported an error.
+  double measure_mhz(aocl_utils::Session &session, cl_kernel kernel, cl_mem Y_buf, cl_int datanum) {
+    if (m_mhz_binary == session.binaryFile()) return m_mhz;
+    std::vector<aocl_utils::ClockSample> samples;
+    cl_int status, last = 0;
+    for (int shift = 3; shift >= 0; --shift) {
+      cl_int n = (datanum >> shift) & ~15;  // whole 512-bit words
+      if (n == 0 || n == last) continue;
+      last = n;
+      status = clSetKernelArg(kernel, 2, sizeof(cl_int), &n); aocl_utils::checkError(status, "Failed to set argument N");
+      aocl_utils::scoped_cl_event event;
+      cl_int cycles;
+      status = clEnqueueNDRangeKernel(session.queue(), kernel, 1, NULL, aoclbench::global_item_size, aoclbench::local_item_size, 0, NULL, event.out());
+      aocl_utils::checkError(status, "Failed to launch kernel");
+      aocl_utils::traceCommand(event, "calibration kernel");
+      status = clEnqueueReadBuffer(session.queue(), Y_buf, CL_TRUE, 0, sizeof(cl_int), &cycles, 1, event.ptr(), NULL);
+      aocl_utils::checkError(status, "Failed to transfer output Y");
+      if (cycles == 0) break;
+      aocl_utils::ClockSample sample = { double(cycles), aocl_utils::getStartEndTime(event) };
+      samples.push_back(sample);
+    }
+    status = clSetKernelArg(kernel, 2, sizeof(cl_int), &datanum); aocl_utils::checkError(status, "Failed to set argument N");
+    if (samples.size() < 2) return 0;
+    m_mhz        = aocl_utils::fitKernelMhz(samples);
+    m_mhz_binary = session.binaryFile();
+    return m_mhz;
+  }
+
+  InputX      m_X;
+  std::string m_mhz_binary;  // the binary m_mhz was measured for
+  double      m_mhz;
+};
+REGISTER_BENCHMARK(DramRead);
+
+
+/********************************************************************/
+class DramWrite : public aoclbench::Benchmark {
+public:
+  DramWrite() : m_Y_num(0) {}
+
+  const char *name() const { return "dram_write"; }
+  const char *description() const { return "DRAM write bandwidth with bursts of the RTL module"; }
+  const char *binary() const { return "../../DRAM/bandwidth/write/bin/tb_write"; }
+  std::vector<aoclbench::Param> params() const {
+    aoclbench::Param params[] = {
+      {"datanum", "1M",    "the number of integer values written"},
+      {"tries",   "20",    "the number of kernel launches averaged"},
+      {"verify",  "1",     "read back and check the written values (0 to skip)"},
+      {"freq",    "auto",  "the kernel clock (MHz) for the FSM bound, or auto: the fmax of the AOCX"},
+    };
+    return std::vector<aoclbench::Param>(params, params + sizeof(params)/sizeof(params[0]));
+  }
+
+  void run(aocl_utils::Session &session, const aocl_utils::SweepPoint &point, aoclbench::Result &result) {
+    size_t datanum   = aocl_utils::getCount(point, "datanum", 1048576);
+    size_t try_num   = std::max<size_t>(1, aocl_utils::getCount(point, "tries", 20));
+    bool   check     = aocl_utils::getCount(point, "verify", 1) != 0;
+    double frequency = kernel_mhz(session, aocl_utils::getString(point, "freq", "auto"), 0);
+    cl_int status;
+
+    // X is not accessed by the RTL module, but the kernel takes it.
+    cl_mem Y_buf = session.buffer("dram_write.Y", CL_MEM_WRITE_ONLY | CL_CHANNEL_1_INTELFPGA, sizeof(int)*datanum);
+    cl_mem X_buf = session.buffer("dram_write.X", CL_MEM_READ_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(int));
+
+    cl_kernel kernel = session.kernel("tb_write");
+    cl_int    n      = datanum;
+    unsigned  argi   = 0;
+    status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), &Y_buf); aocl_utils::checkError(status, "Failed to set argument Y");
+    status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), &X_buf); aocl_utils::checkError(status, "Failed to set argument X");
+    status = clSetKernelArg(kernel, argi++, sizeof(cl_int), &n);     aocl_utils::checkError(status, "Failed to set argument N");
+
+    // The write module does not return its cycle count, so the kernel time is
+    // taken from the profiling information of the kernel event.
+    cl_ulong                    time_sum = 0;
+    aocl_utils::scoped_cl_event kernel_event;
+    for (size_t i = 0; i < try_num; ++i) {
+      status = clEnqueueNDRangeKernel(session.queue(), kernel, 1, NULL, aoclbench::global_item_size, aoclbench::local_item_size, 0, NULL, kernel_event.out());
+      aocl_utils::checkError(status, "Failed to launch kernel");
+      aocl_utils::traceCommand(kernel_event, "kernel");
+      clWaitForEvents(1, kernel_event.ptr());
+      time_sum += aocl_utils::getStartEndTime(kernel_event);
+    }
+
+    // The module writes Y[i] = i.
+    bool error = false;
+    if (check) {
+      if (m_Y_num < datanum) { m_Y.reset(datanum); m_Y_num = datanum; }
+      status = clEnqueueReadBuffer(session.queue(), Y_buf, CL_TRUE, 0, sizeof(int)*datanum, m_Y, 0, NULL, aocl_utils::traceEvent("read Y"));
+      aocl_utils::checkError(status, "Failed to transfer output Y");
+      for (size_t i = 0; i < datanum; ++i) {
+        if (m_Y[i] != int(i)) { error = true; break; }
+      }
+    }
+
+    double elapsed_time = double(time_sum) * 1.0e-9 / double(try_num);
+    result.check(!error);
+    result.add("datanum", datanum);
+    result.add("tries", try_num);
+    result.add("verification", !check ? "SKIP" : error ? "FAIL" : "PASS");
+    result.add("kernel_mhz", frequency);
+    result.add("avg_time_s", elapsed_time);
+    result.add("bandwidth_GBps", double(sizeof(int) * datanum) / elapsed_time * 1.0e-9);
+
+    // The event time includes the launch, so this is a lower bound
+    uint64_t fsm_cycles = aocl_utils::fsmWriteCycles(aocl_utils::FsmParams::fromEnv(frequency), datanum);
+    result.add("fsm_cycles", fsm_cycles);
+    result.add("efficiency", double(fsm_cycles) / (elapsed_time * frequency * 1.0e6));
+  }
+
+private:
+  aocl_utils::scoped_aligned_ptr<int> m_Y;      // Y read back from the FPGA
+  size_t                              m_Y_num;  // the capacity of m_Y
+};
+REGISTER_BENCHMARK(DramWrite);
+
+
+/********************************************************************/
+class DramLatency : public aoclbench::Benchmark {
+public:
+  DramLatency() : m_X("dram_latency.X") {}
+
+  const char *name() const { return "dram_latency"; }
+  const char *description() const { return "DRAM load latency of single accesses"; }
+  const char *binary() const { return "../../DRAM/latency/read/bin/tb_read"; }
+  std::vector<aoclbench::Param> params() const {
+    aoclbench::Param params[] = {
+      {"datanum", "1M",     "the number of integer values in the accessed region"},
+      {"tries",   "1000",   "the number of accesses averaged"},
+      {"pattern", "random", "the access pattern (random or sequential)"},
+      {"freq",    "auto",   "the kernel clock (MHz), or auto: the fmax of the AOCX"},
+    };
+    return std::vector<aoclbench::Param>(params, params + sizeof(params)/sizeof(params[0]));
+  }
+
+  void run(aocl_utils::Session &session, const aocl_utils::SweepPoint &point, aoclbench::Result &result) {
+    size_t      datanum   = aocl_utils::getCount(point, "datanum", 1048576);
+    size_t      try_num   = std::max<size_t>(1, aocl_utils::getCount(point, "tries", 1000));
+    std::string pattern   = aocl_utils::getString(point, "pattern", "random");
+    double      frequency = kernel_mhz(session, aocl_utils::getString(point, "freq", "auto"), 0);
+    cl_int      status;
+
+    if (datanum < size_t(ELEMS_PER_ACCESS)) {
+      throw aoclbench::ParamError("datanum must be at least " + std::to_string(ELEMS_PER_ACCESS));
+    }
+
+    // The indices accessed, aligned to the width of a memory access
+    aocl_utils::scoped_aligned_ptr<int> I(try_num);
+    if (pattern == "random") {
+      std::default_random_engine g_engine_(std::random_device{}());
+      std::uniform_int_distribution<int> distribution(0, datanum-1);
+      for (size_t i = 0; i < try_num; ++i) {
+        I[i] = distribution(g_engine_);
+        I[i] -= I[i] % ELEMS_PER_ACCESS;
+      }
+    } else if (pattern == "sequential") {
+      for (size_t i = 0; i < try_num; ++i) {
+        I[i] = (i * ELEMS_PER_ACCESS) % (datanum - datanum % ELEMS_PER_ACCESS);
+      }
+    } else {
+      throw aoclbench::ParamError("Pattern(" + pattern + ") is not supported");
+    }
+
+    cl_mem X_buf = m_X.upload(session, datanum, CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA);
+    cl_mem I_buf = session.buffer("dram_latency.I", CL_MEM_READ_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(int)*try_num);
+    cl_mem Y_buf = session.buffer("dram_latency.Y", CL_MEM_WRITE_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(int)*try_num);
+    status = clEnqueueWriteBuffer(session.queue(), I_buf, CL_TRUE, 0, sizeof(int)*try_num, I, 0, NULL, aocl_utils::traceEvent("write I"));
+    aocl_utils::checkError(status, "Failed to transfer input I");
+
+    cl_kernel kernel = session.kernel("tb_read");
+    cl_int    n      = try_num;
+    unsigned  argi   = 0;
+    status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), &Y_buf); aocl_utils::checkError(status, "Failed to set argument Y");
+    status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), &X_buf); aocl_utils::checkError(status, "Failed to set argument X");
+    status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), &I_buf); aocl_utils::checkError(status, "Failed to set argument I");
+    status = clSetKernelArg(kernel, argi++, sizeof(cl_int), &n);     aocl_utils::checkError(status, "Failed to set argument N");
+
+    status = clEnqueueNDRangeKernel(session.queue(), kernel, 1, NULL, aoclbench::global_item_size, aoclbench::local_item_size, 0, NULL, aocl_utils::traceEvent("kernel"));
+    aocl_utils::checkError(status, "Failed to launch kernel");
+    aocl_utils::scoped_aligned_ptr<int> Y(try_num);
+    status = clEnqueueReadBuffer(session.queue(), Y_buf, CL_TRUE, 0, sizeof(int)*try_num, Y, 0, NULL, aocl_utils::traceEvent("read Y"));
+    aocl_utils::checkError(status, "Failed to transfer output Y");
+
+    bool     error      = false;
+    uint64_t cycles_sum = 0;
+    for (size_t i = 0; i < try_num; ++i) {
+      if (Y[i] == 0) error = true;
+      cycles_sum += Y[i];
+    }
+
+    float avg_cycles = float(cycles_sum) / float(try_num);
+    result.check(!error);
+    result.add("datanum", datanum);
+    result.add("tries", try_num);
+    result.add("pattern", pattern);
+    result.add("kernel_mhz", frequency);
+    result.add("avg_cycles", avg_cycles);
+    result.add("avg_latency_ns", avg_cycles * (1000.0 / frequency));
+  }
+
+private:
+  InputX m_X;
+};
+REGISTER_BENCHMARK(DramLatency);
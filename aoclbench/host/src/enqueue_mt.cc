@@ -0,0 +1,309 @@
+///////////////////////////////////////////////////////////////////////////////////
+// Multi-threaded enqueue tests: T host threads launch the kernel of nop
+// (enqueue_mt) or small tb_read kernels of DRAM/bandwidth/read
+// (enqueue_mt_read) on one board, in one of three modes:
+//   per_thread  each thread owns an in-order queue
+//   shared      all threads enqueue to a single in-order queue
+//   dispatcher  the threads push launch requests into a lock-free ring and
+//               one dispatcher thread enqueues them to a single queue
+//
+// Each thread keeps up to `depth` launches in flight. The latency of a launch
+// runs from the request of its thread until that thread sees it complete; the
+// enqueue time is the host time until the enqueue call returned (in dispatcher
+// mode, from the push into the ring). Where the aggregate throughput stops
+// growing with T, the locking inside the runtime is the limit.
+///////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+#include "bench.h"
+
+
+// Bounded multi-producer ring of launch requests (after D. Vyukov's bounded
+// MPMC queue): a cell is free for the producer of ticket t when its sequence
+// is t, and full for the consumer when it is t + 1.
+/********************************************************************/
+template<typename T>
+class SubmitRing {
+public:
+  explicit SubmitRing(size_t capacity) : m_cells(capacity), m_mask(capacity - 1), m_head(0), m_tail(0) {
+    for (size_t i = 0; i < capacity; ++i) m_cells[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  // Returns false if the ring is full.
+  bool push(T value) {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell  &cell = m_cells[tail & m_mask];
+      size_t seq  = cell.sequence.load(std::memory_order_acquire);
+      if (seq == tail) {
+        if (m_tail.compare_exchange_weak(tail, tail + 1, std::memory_order_relaxed)) {
+          cell.value = value;
+          cell.sequence.store(tail + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (seq < tail) {
+        return false;
+      } else {
+        tail = m_tail.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Single consumer. Returns false if the ring is empty.
+  bool pop(T &value) {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    Cell  &cell = m_cells[head & m_mask];
+    if (cell.sequence.load(std::memory_order_acquire) != head + 1) return false;
+    value = cell.value;
+    cell.sequence.store(head + m_mask + 1, std::memory_order_release);
+    m_head.store(head + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T                   value;
+  };
+
+  std::vector<Cell>                m_cells;  // a power of two
+  size_t                           m_mask;
+  alignas(64) std::atomic<size_t>  m_head;
+  alignas(64) std::atomic<size_t>  m_tail;
+};
+
+
+// One launch of a host thread
+/********************************************************************/
+struct Launch {
+  double                request;   // when the thread requested it
+  double                enqueued;  // when the enqueue call returned
+  double                complete;  // when the thread saw it complete
+  std::atomic<cl_event> event;     // set once enqueued
+
+  Launch() : request(0), enqueued(0), complete(0), event(NULL) {}
+};
+
+// The p-th percentile of values, in microseconds
+static double percentileUs(std::vector<double> &values, double p) {
+  if (values.empty()) return 0;
+  size_t i = std::min(values.size() - 1, (size_t)(p * values.size()));
+  std::nth_element(values.begin(), values.begin() + i, values.end());
+  return values[i] * 1.0e6;
+}
+
+
+/********************************************************************/
+class EnqueueMt : public aoclbench::Benchmark {
+public:
+  std::vector<aoclbench::Param> params() const {
+    aoclbench::Param params[] = {
+      {"threads",  "4",          "the number of host threads launching kernels"},
+      {"mode",     "per_thread", "per_thread, shared or dispatcher (see enqueue_mt.cc)"},
+      {"launches", "1000",       "the number of launches of each thread"},
+      {"depth",    "8",          "the number of launches each thread keeps in flight"},
+      {"datanum",  "1K",         "the number of integer values read by tb_read (enqueue_mt_read)"},
+    };
+    return std::vector<aoclbench::Param>(params, params + sizeof(params)/sizeof(params[0]));
+  }
+
+  void run(aocl_utils::Session &session, const aocl_utils::SweepPoint &point, aoclbench::Result &result) {
+    size_t      num_threads = aocl_utils::getCount(point, "threads", 4);
+    std::string mode        = aocl_utils::getString(point, "mode", "per_thread");
+    size_t      num         = aocl_utils::getCount(point, "launches", 1000);
+    size_t      depth       = std::max<size_t>(1, aocl_utils::getCount(point, "depth", 8));
+    size_t      datanum     = aocl_utils::getCount(point, "datanum", 1024);
+    if (mode != "per_thread" && mode != "shared" && mode != "dispatcher") {
+      throw aoclbench::ParamError("Unknown mode " + mode + " (per_thread, shared or dispatcher)");
+    }
+    bool   dispatcher = mode == "dispatcher";
+    cl_int status;
+
+    // Queues and kernels: clSetKernelArg is not thread-safe on a shared
+    // kernel, so each enqueuing thread has its own
+    size_t num_queues  = (mode == "per_thread") ? num_threads : 1;
+    size_t num_kernels = dispatcher ? 1 : num_threads;
+    std::vector<aocl_utils::scoped_cl_command_queue> queues(num_queues);
+    for (size_t q = 0; q < num_queues; ++q) {
+      queues[q] = clCreateCommandQueue(session.context(), session.device(), 0, &status);
+      aocl_utils::checkError(status, "Failed to create command queue");
+    }
+    std::vector<aocl_utils::scoped_cl_kernel> kernels(num_kernels);
+    for (size_t k = 0; k < num_kernels; ++k) {
+      kernels[k] = clCreateKernel(session.program(), kernelName(), &status);
+      aocl_utils::checkError(status, "Failed to create kernel");
+      setArgs(session, kernels[k], k, datanum);
+    }
+
+    std::vector<std::vector<Launch> > launches(num_threads);
+    for (size_t t = 0; t < num_threads; ++t) {
+      std::vector<Launch>(num).swap(launches[t]);
+    }
+    SubmitRing<Launch *> ring(ringCapacity(num_threads * depth));
+    std::atomic<size_t>  ready(0);
+    std::atomic<bool>    go(false);
+
+    // Host threads
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < num_threads; ++t) {
+      threads.push_back(std::thread([&, t] {
+        cl_command_queue queue  = queues[std::min(t, num_queues - 1)];
+        cl_kernel        kernel = kernels[std::min(t, num_kernels - 1)];
+        std::vector<Launch> &mine = launches[t];
+        ++ready;
+        while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+        for (size_t i = 0; i < num; ++i) {
+          if (i >= depth) complete(mine[i - depth]);
+          Launch &launch = mine[i];
+          launch.request = aocl_utils::getCurrentTimestamp();
+          if (dispatcher) {
+            while (!ring.push(&launch)) std::this_thread::yield();
+          } else {
+            cl_event event;
+            cl_int   s = clEnqueueNDRangeKernel(queue, kernel, 1, NULL, aoclbench::global_item_size, aoclbench::local_item_size, 0, NULL, &event);
+            aocl_utils::checkError(s, "Failed to launch kernel");
+            launch.enqueued = aocl_utils::getCurrentTimestamp();
+            launch.event.store(event, std::memory_order_release);
+          }
+        }
+        if (!dispatcher) clFlush(queue);
+        for (size_t i = (num > depth) ? num - depth : 0; i < num; ++i) complete(mine[i]);
+      }));
+    }
+
+    // The dispatcher thread of the dispatcher mode; it flushes whenever the
+    // ring runs dry, so that waiting threads are not starved
+    std::thread dispatch;
+    if (dispatcher) {
+      dispatch = std::thread([&] {
+        size_t remaining = num_threads * num;
+        bool   flushed   = true;
+        while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+        while (remaining != 0) {
+          Launch *launch;
+          if (!ring.pop(launch)) {
+            if (!flushed) { clFlush(queues[0]); flushed = true; }
+            std::this_thread::yield();
+            continue;
+          }
+          cl_event event;
+          cl_int   s = clEnqueueNDRangeKernel(queues[0], kernels[0], 1, NULL, aoclbench::global_item_size, aoclbench::local_item_size, 0, NULL, &event);
+          aocl_utils::checkError(s, "Failed to launch kernel");
+          launch->enqueued = aocl_utils::getCurrentTimestamp();
+          launch->event.store(event, std::memory_order_release);
+          flushed = false;
+          --remaining;
+        }
+        clFlush(queues[0]);
+      });
+    }
+
+    while (ready.load() != num_threads) std::this_thread::yield();
+    double start = aocl_utils::getCurrentTimestamp();
+    go.store(true, std::memory_order_release);
+    for (size_t t = 0; t < num_threads; ++t) threads[t].join();
+    if (dispatcher) dispatch.join();
+    double elapsed = aocl_utils::getCurrentTimestamp() - start;
+    for (size_t q = 0; q < num_queues; ++q) {
+      status = clFinish(queues[q]);
+      result.check(status == CL_SUCCESS);
+    }
+
+    std::vector<double> enqueue, latency;
+    enqueue.reserve(num_threads * num);
+    latency.reserve(num_threads * num);
+    for (size_t t = 0; t < num_threads; ++t) {
+      for (size_t i = 0; i < num; ++i) {
+        enqueue.push_back(launches[t][i].enqueued - launches[t][i].request);
+        latency.push_back(launches[t][i].complete - launches[t][i].request);
+      }
+    }
+    result.add("threads", num_threads);
+    result.add("mode", mode);
+    result.add("launches", num);
+    result.add("depth", depth);
+    result.add("launches_per_s", double(num_threads * num) / elapsed);
+    result.add("enqueue_p50_us", percentileUs(enqueue, 0.50));
+    result.add("enqueue_p99_us", percentileUs(enqueue, 0.99));
+    result.add("latency_p50_us", percentileUs(latency, 0.50));
+    result.add("latency_p99_us", percentileUs(latency, 0.99));
+  }
+
+protected:
+  virtual const char *kernelName() const = 0;
+
+  // Sets the arguments of the kernel of enqueuing thread k
+  virtual void setArgs(aocl_utils::Session &session, cl_kernel kernel, size_t k, size_t datanum) = 0;
+
+private:
+  static size_t ringCapacity(size_t n) {
+    size_t capacity = 2;
+    while (capacity < n) capacity <<= 1;
+    return capacity;
+  }
+
+  // Waits for a launch of the calling thread and releases its event
+  static void complete(Launch &launch) {
+    cl_event event;
+    while ((event = launch.event.load(std::memory_order_acquire)) == NULL) std::this_thread::yield();
+    cl_int status = clWaitForEvents(1, &event);
+    aocl_utils::checkError(status, "Failed to wait for kernel");
+    launch.complete = aocl_utils::getCurrentTimestamp();
+    clReleaseEvent(event);
+  }
+};
+
+
+/********************************************************************/
+class EnqueueMtNop : public EnqueueMt {
+public:
+  const char *name() const { return "enqueue_mt"; }
+  const char *description() const { return "launch throughput and latency of T host threads with empty kernels"; }
+  const char *binary() const { return "../../nop/bin/nop"; }
+
+protected:
+  const char *kernelName() const { return "nop"; }
+  void setArgs(aocl_utils::Session &, cl_kernel, size_t, size_t) {}
+};
+REGISTER_BENCHMARK(EnqueueMtNop);
+
+
+/********************************************************************/
+class EnqueueMtRead : public EnqueueMt {
+public:
+  const char *name() const { return "enqueue_mt_read"; }
+  const char *description() const { return "launch throughput and latency of T host threads with small DRAM reads"; }
+  const char *binary() const { return "../../DRAM/bandwidth/read/bin/tb_read"; }
+
+protected:
+  const char *kernelName() const { return "tb_read"; }
+
+  // Each kernel writes its cycle count to a Y of its own; X holds what the
+  // RTL module verifies against (X[i] = i + 1)
+  void setArgs(aocl_utils::Session &session, cl_kernel kernel, size_t k, size_t datanum) {
+    bool   allocated;
+    cl_mem X_buf = session.buffer("enqueue_mt_read.X", CL_MEM_READ_ONLY | CL_CHANNEL_1_INTELFPGA, sizeof(int)*datanum, &allocated);
+    if (allocated || datanum > m_X.size()) {
+      m_X.resize(datanum);
+      for (size_t i = 0; i < datanum; ++i) m_X[i] = i + 1;
+      cl_int status = clEnqueueWriteBuffer(session.queue(), X_buf, CL_TRUE, 0, sizeof(int)*datanum, m_X.data(), 0, NULL, aocl_utils::traceEvent("write X"));
+      aocl_utils::checkError(status, "Failed to transfer input X");
+    }
+    cl_mem Y_buf = session.buffer("enqueue_mt_read.Y" + std::to_string(k), CL_MEM_WRITE_ONLY | CL_CHANNEL_2_INTELFPGA, sizeof(int));
+    cl_int n     = datanum;
+    unsigned argi = 0;
+    cl_int status;
+    status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), &Y_buf); aocl_utils::checkError(status, "Failed to set argument Y");
+    status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), &X_buf); aocl_utils::checkError(status, "Failed to set argument X");
+    status = clSetKernelArg(kernel, argi++, sizeof(cl_int), &n);     aocl_utils::checkError(status, "Failed to set argument N");
+  }
+
+private:
+  std::vector<int> m_X;
+};
+REGISTER_BENCHMARK(EnqueueMtRead);
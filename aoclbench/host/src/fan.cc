@@ -0,0 +1,243 @@
+///////////////////////////////////////////////////////////////////////////////////
+// Fan-out and fan-in test: the channel arrays of interkernel_comm/test.cl.
+//
+// pattern=out: fanout_send_<dist>_<N> splits `messages` float8 values over
+// fo<N>_ch[N], and the N workers fanout_recv_<N>_<k> drain one channel each.
+// pattern=in: the N producers fanin_send_<N>_<k> each stream their share into
+// fi<N>_ch[k], and fanin_recv_<N> collects them in arrival order. The values
+// are split round robin (dist=rr) or by FAN_HASH of their s0 (dist=hash);
+// hot is the fraction of the values that share one key, which the hash sends
+// to one worker. The kernels of each N are built alone into test_fan<N>.aocx
+// (make gen_fan in interkernel_comm). Every kernel runs on a queue of its
+// own. Reported:
+//
+//   bytes_per_s      payload / (last END - first START) over all kernels
+//   imbalance        largest share / mean share (1: even)
+//   time_imbalance   longest worker (or producer) / mean one
+//   slowest_us       the longest worker (or producer)
+//
+// A replication factor stops paying once bytes_per_s no longer scales with
+// workers, or once time_imbalance grows with it.
+///////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+#include "bench.h"
+
+
+// The replication factors of test.cl
+/********************************************************************/
+static const unsigned WORKERS[] = {2, 4, 8};
+static const size_t   FLOAT8_SIZE = 8 * sizeof(cl_float);
+
+
+/********************************************************************/
+class Fan : public aoclbench::Benchmark {
+public:
+  const char *name() const { return "fan"; }
+  const char *description() const { return "throughput and load imbalance of channel arrays, one to N and N to one"; }
+  const char *binary() const { return "../../interkernel_comm/test"; }
+  std::string binaryFor(const aocl_utils::SweepPoint &point, const std::string &prefix) const {
+    unsigned workers = aocl_utils::getCount(point, "workers", 4);
+    check(workers);
+    return prefix + "_fan" + std::to_string(workers);
+  }
+  std::vector<aoclbench::Param> params() const {
+    aoclbench::Param params[] = {
+      {"pattern",  "out", "out: one producer to N workers, in: N producers to one collector"},
+      {"workers",  "4",   "N: 2, 4 or 8"},
+      {"dist",     "rr",  "how the values are split: rr (round robin) or hash"},
+      {"messages", "1M",  "the number of float8 values"},
+      {"hot",      "0",   "the fraction of the values with the same key"},
+      {"tries",    "3",   "the number of runs averaged"},
+    };
+    return std::vector<aoclbench::Param>(params, params + sizeof(params)/sizeof(params[0]));
+  }
+
+  void run(aocl_utils::Session &session, const aocl_utils::SweepPoint &point, aoclbench::Result &result) {
+    std::string pattern  = aocl_utils::getString(point, "pattern", "out");
+    unsigned    workers  = aocl_utils::getCount(point, "workers", 4);
+    std::string dist     = aocl_utils::getString(point, "dist", "rr");
+    cl_int      messages = aocl_utils::getCount(point, "messages", 1048576);
+    double      hot      = std::stod(aocl_utils::getString(point, "hot", "0"));
+    size_t      tries    = std::max<size_t>(1, aocl_utils::getCount(point, "tries", 3));
+    check(workers);
+    if ((pattern != "out" && pattern != "in") || (dist != "rr" && dist != "hash")) {
+      throw aoclbench::ParamError("Unknown pattern " + pattern + " or dist " + dist);
+    }
+    bool   fan_out = pattern == "out";
+    size_t bytes = (size_t)messages * FLOAT8_SIZE;
+    cl_int status;
+
+    // Payload, and the share of each worker in the order it sends or receives
+    prepare(messages, hot);
+    std::vector<std::vector<unsigned char> > shares(workers);
+    for (cl_int i = 0; i < messages; ++i) {
+      const unsigned char *value = &m_payload[i * FLOAT8_SIZE];
+      unsigned w = (dist == "hash") ? hash(value, workers) : i % workers;
+      shares[w].insert(shares[w].end(), value, value + FLOAT8_SIZE);
+    }
+
+    // One side: the single producer or collector, with the whole payload
+    std::string n = std::to_string(workers);
+    cl_kernel one = session.kernel(fan_out ? "fanout_send_" + dist + "_" + n : "fanin_recv_" + n);
+    cl_mem one_buf = session.buffer("fan.one", CL_MEM_READ_WRITE, bytes);
+    if (fan_out) {
+      status = clEnqueueWriteBuffer(session.queue(), one_buf, CL_TRUE, 0, bytes, m_payload.data(), 0, NULL, aocl_utils::traceEvent("write payload"));
+      aocl_utils::checkError(status, "Failed to transfer the payload");
+    }
+    status = clSetKernelArg(one, 0, sizeof(cl_mem), &one_buf); aocl_utils::checkError(status, "Failed to set argument data");
+    status = clSetKernelArg(one, 1, sizeof(cl_int), &messages); aocl_utils::checkError(status, "Failed to set argument n");
+
+    // Other side: the N workers or producers, each with its share
+    std::vector<cl_kernel> many(workers);
+    std::vector<cl_mem>    many_bufs(workers);
+    std::vector<cl_int>    counts(workers);
+    for (unsigned k = 0; k < workers; ++k) {
+      std::string suffix = n + "_" + std::to_string(k);
+      counts[k]    = shares[k].size() / FLOAT8_SIZE;
+      many[k]      = session.kernel(fan_out ? "fanout_recv_" + suffix : "fanin_send_" + suffix);
+      many_bufs[k] = session.buffer("fan.share" + std::to_string(k), CL_MEM_READ_WRITE, std::max(shares[k].size(), FLOAT8_SIZE));
+      if (!fan_out && counts[k] > 0) {
+        status = clEnqueueWriteBuffer(session.queue(), many_bufs[k], CL_TRUE, 0, shares[k].size(), shares[k].data(), 0, NULL, aocl_utils::traceEvent("write share"));
+        aocl_utils::checkError(status, "Failed to transfer a share");
+      }
+      status = clSetKernelArg(many[k], 0, sizeof(cl_mem), &many_bufs[k]); aocl_utils::checkError(status, "Failed to set argument data");
+      status = clSetKernelArg(many[k], 1, sizeof(cl_int), &counts[k]); aocl_utils::checkError(status, "Failed to set argument n");
+    }
+
+    std::vector<aocl_utils::scoped_cl_command_queue> queues(workers + 1);
+    for (unsigned q = 0; q <= workers; ++q) {
+      queues[q] = clCreateCommandQueue(session.context(), session.device(), CL_QUEUE_PROFILING_ENABLE, &status);
+      aocl_utils::checkError(status, "Failed to create a command queue");
+    }
+
+    double window_ns = 0, slowest_ns = 0, time_imbalance = 0;
+    bool   verified = true;
+    for (size_t i = 0; i < tries; ++i) {
+      // The output side starts each run with a pattern the random payload in
+      // [0, 1) never has, so that neither an earlier run nor an earlier point
+      // (whose buffers the session kept) can pass the check; each fill goes
+      // on the queue of the kernel that writes the buffer
+      const cl_uint pattern = 0xdeadbeef;
+      if (fan_out) {
+        for (unsigned k = 0; k < workers; ++k) {
+          status = clEnqueueFillBuffer(queues[k], many_bufs[k], &pattern, sizeof(pattern), 0, std::max(shares[k].size(), FLOAT8_SIZE), 0, NULL, aocl_utils::traceEvent("fill share"));
+          aocl_utils::checkError(status, "Failed to fill a share");
+        }
+      } else {
+        status = clEnqueueFillBuffer(queues[workers], one_buf, &pattern, sizeof(pattern), 0, bytes, 0, NULL, aocl_utils::traceEvent("fill collected"));
+        aocl_utils::checkError(status, "Failed to fill the collector buffer");
+      }
+
+      std::vector<aocl_utils::scoped_cl_event> events(workers + 1);
+      status = clEnqueueNDRangeKernel(queues[workers], one, 1, NULL, aoclbench::global_item_size, aoclbench::local_item_size, 0, NULL, events[workers].out());
+      aocl_utils::checkError(status, "Failed to launch the producer or collector");
+      for (unsigned k = 0; k < workers; ++k) {
+        status = clEnqueueNDRangeKernel(queues[k], many[k], 1, NULL, aoclbench::global_item_size, aoclbench::local_item_size, 0, NULL, events[k].out());
+        aocl_utils::checkError(status, "Failed to launch a worker or producer");
+      }
+      // All kernels have to run at once: the channels are only 16 deep
+      for (unsigned q = 0; q <= workers; ++q) clFlush(queues[q]);
+      for (unsigned q = 0; q <= workers; ++q) clFinish(queues[q]);
+
+      cl_ulong first = ~(cl_ulong)0, last = 0;
+      double   longest = 0, total = 0;
+      for (unsigned q = 0; q <= workers; ++q) {
+        cl_ulong start = profile(events[q], CL_PROFILING_COMMAND_START), end = profile(events[q], CL_PROFILING_COMMAND_END);
+        first = std::min(first, start);
+        last  = std::max(last, end);
+        if (q < workers) {
+          longest = std::max(longest, (double)(end - start));
+          total  += end - start;
+        }
+      }
+      window_ns      += last - first;
+      slowest_ns     += longest;
+      time_imbalance += (total > 0) ? longest / (total / workers) : 1.0;
+      verified = verified && verify(session, fan_out, one_buf, many_bufs, shares);
+    }
+
+    size_t largest = 0;
+    for (unsigned k = 0; k < workers; ++k) largest = std::max<size_t>(largest, counts[k]);
+
+    result.check(verified);
+    result.add("pattern", pattern);
+    result.add("workers", workers);
+    result.add("dist", dist);
+    result.add("messages", messages);
+    result.add("bytes_per_s", bytes * tries / (window_ns * 1.0e-9));
+    result.add("imbalance", (double)largest / ((double)messages / workers));
+    result.add("time_imbalance", time_imbalance / tries);
+    result.add("slowest_us", slowest_ns / tries * 1.0e-3);
+  }
+
+private:
+  static void check(unsigned workers) {
+    if (std::find(WORKERS, WORKERS + 3, workers) == WORKERS + 3) {
+      throw aoclbench::ParamError("No channel array of " + std::to_string(workers) + " in test.cl");
+    }
+  }
+
+  // Random values; with hot > 0 that fraction of them shares the key s0
+  void prepare(cl_int messages, double hot) {
+    std::mt19937 g(12345);
+    std::uniform_real_distribution<float> d;
+    m_payload.resize((size_t)messages * FLOAT8_SIZE);
+    for (cl_int i = 0; i < messages; ++i) {
+      cl_float value[8];
+      for (unsigned j = 0; j < 8; ++j) value[j] = d(g);
+      if (d(g) < hot) value[0] = 0.5f;
+      memcpy(&m_payload[i * FLOAT8_SIZE], value, FLOAT8_SIZE);
+    }
+  }
+
+  // FAN_HASH of test.cl
+  static unsigned hash(const unsigned char *value, unsigned workers) {
+    cl_uint bits;
+    memcpy(&bits, value, sizeof(bits));
+    return ((cl_uint)(bits * 2654435761u) >> 16) % workers;
+  }
+
+  static cl_ulong profile(cl_event event, cl_profiling_info param) {
+    cl_ulong value;
+    cl_int status = clGetEventProfilingInfo(event, param, sizeof(value), &value, NULL);
+    aocl_utils::checkError(status, "Failed to query event profiling info");
+    return value;
+  }
+
+  // Fan-out: every worker got its share in order. Fan-in: the collector got
+  // every value once, in any order.
+  bool verify(aocl_utils::Session &session, bool fan_out, cl_mem one_buf, const std::vector<cl_mem> &many_bufs,
+              const std::vector<std::vector<unsigned char> > &shares) {
+    cl_int status;
+    if (fan_out) {
+      for (size_t k = 0; k < shares.size(); ++k) {
+        if (shares[k].empty()) continue;
+        std::vector<unsigned char> received(shares[k].size());
+        status = clEnqueueReadBuffer(session.queue(), many_bufs[k], CL_TRUE, 0, received.size(), received.data(), 0, NULL, aocl_utils::traceEvent("read share"));
+        aocl_utils::checkError(status, "Failed to transfer a share");
+        if (received != shares[k]) return false;
+      }
+      return true;
+    }
+    std::vector<unsigned char> received(m_payload.size());
+    status = clEnqueueReadBuffer(session.queue(), one_buf, CL_TRUE, 0, received.size(), received.data(), 0, NULL, aocl_utils::traceEvent("read collected"));
+    aocl_utils::checkError(status, "Failed to transfer the collected values");
+    return sorted(received) == sorted(m_payload);
+  }
+
+  static std::vector<std::string> sorted(const std::vector<unsigned char> &values) {
+    std::vector<std::string> elements;
+    for (size_t i = 0; i < values.size(); i += FLOAT8_SIZE) {
+      elements.push_back(std::string((const char *)&values[i], FLOAT8_SIZE));
+    }
+    std::sort(elements.begin(), elements.end());
+    return elements;
+  }
+
+  std::vector<unsigned char> m_payload;  // the values on the host PC
+};
+REGISTER_BENCHMARK(Fan);
@@ -0,0 +1,178 @@
+///////////////////////////////////////////////////////////////////////////////////
+// Inter-kernel channel test: the send/recv pairs of interkernel_comm/test.cl.
+//
+// send_<type>_d<depth> streams `messages` values from memory into a channel
+// of that depth, and recv_<type>_d<depth> drains it back to memory. Each pair
+// is built alone into test_<type>_d<depth>.aocx (make gen_channels in
+// interkernel_comm), so that its area and clock are those of a two-kernel
+// design. As in interkernel_comm, the producer runs on queue cq0 and the
+// consumer on cq1, which fills the receive buffer with a pattern before each
+// run. The profiling times of the two kernels give:
+//
+//   bytes_per_s   payload / (last END - first START)
+//   skew_us       recv START - send START (the consumer launched late)
+//   tail_us       recv END - send END (the consumer draining the channel)
+//   send_stall    fraction of the producer's cycles without a write, i.e.
+//   recv_stall    blocked on a full channel (the consumer's: on an empty one)
+//
+// The stall fractions assume one transfer per cycle and need the kernel
+// clock: the fmax in the AOCX of the pair, or the mhz parameter. A channel is
+// deep enough once a deeper one no longer raises bytes_per_s or lowers
+// send_stall.
+///////////////////////////////////////////////////////////////////////////////////
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+
+#include "bench.h"
+
+
+// The payload types and depths of test.cl
+/********************************************************************/
+static const char     *const TYPES[]  = {"float", "float4", "float8", "float16"};
+static const unsigned        WIDTHS[] = {1, 4, 8, 16};
+static const unsigned        DEPTHS[] = {0, 16, 64, 256, 1024};
+
+
+/********************************************************************/
+class Interkernel : public aoclbench::Benchmark {
+public:
+  const char *name() const { return "interkernel"; }
+  const char *description() const { return "throughput and stalls of a channel between two kernels"; }
+  const char *binary() const { return "../../interkernel_comm/test"; }
+  std::string binaryFor(const aocl_utils::SweepPoint &point, const std::string &prefix) const {
+    std::string type  = aocl_utils::getString(point, "type", "float8");
+    unsigned    depth = aocl_utils::getCount(point, "depth", 16);
+    check(type, depth);
+    return prefix + "_" + type + "_d" + std::to_string(depth);
+  }
+  std::vector<aoclbench::Param> params() const {
+    aoclbench::Param params[] = {
+      {"type",     "float8", "the payload type: float, float4, float8 or float16"},
+      {"depth",    "16",     "the channel depth: 0, 16, 64, 256 or 1024"},
+      {"messages", "1M",     "the number of values sent"},
+      {"tries",    "3",      "the number of runs averaged"},
+      {"mhz",      "0",      "the kernel clock for the stall fractions (0: fmax of the AOCX)"},
+    };
+    return std::vector<aoclbench::Param>(params, params + sizeof(params)/sizeof(params[0]));
+  }
+
+  void run(aocl_utils::Session &session, const aocl_utils::SweepPoint &point, aoclbench::Result &result) {
+    std::string type     = aocl_utils::getString(point, "type", "float8");
+    unsigned    depth    = aocl_utils::getCount(point, "depth", 16);
+    cl_int      messages = aocl_utils::getCount(point, "messages", 1048576);
+    size_t      tries    = std::max<size_t>(1, aocl_utils::getCount(point, "tries", 3));
+    double      mhz      = std::stod(aocl_utils::getString(point, "mhz", "0"));
+    size_t      t = check(type, depth);
+    if (mhz <= 0) mhz = aocl_utils::getBinaryFmaxMhz(session.binaryFile().c_str());
+    size_t num   = (size_t)messages * WIDTHS[t];
+    size_t bytes = num * sizeof(cl_float);
+    cl_int status;
+
+    // Payload: random values, so that a dropped or repeated one shows
+    prepare(num);
+    cl_mem send_buf = session.buffer("interkernel.send", CL_MEM_READ_ONLY, bytes);
+    cl_mem recv_buf = session.buffer("interkernel.recv", CL_MEM_WRITE_ONLY, bytes);
+    status = clEnqueueWriteBuffer(session.queue(), send_buf, CL_TRUE, 0, bytes, m_send.data(), 0, NULL, aocl_utils::traceEvent("write send"));
+    aocl_utils::checkError(status, "Failed to transfer the payload");
+
+    std::string suffix = type + "_d" + std::to_string(depth);
+    cl_kernel send = session.kernel("send_" + suffix);
+    cl_kernel recv = session.kernel("recv_" + suffix);
+    status = clSetKernelArg(send, 0, sizeof(cl_mem), &send_buf); aocl_utils::checkError(status, "Failed to set argument data of send");
+    status = clSetKernelArg(send, 1, sizeof(cl_int), &messages); aocl_utils::checkError(status, "Failed to set argument n of send");
+    status = clSetKernelArg(recv, 0, sizeof(cl_mem), &recv_buf); aocl_utils::checkError(status, "Failed to set argument data of recv");
+    status = clSetKernelArg(recv, 1, sizeof(cl_int), &messages); aocl_utils::checkError(status, "Failed to set argument n of recv");
+
+    aocl_utils::scoped_cl_command_queue cq0, cq1;
+    cq0 = clCreateCommandQueue(session.context(), session.device(), CL_QUEUE_PROFILING_ENABLE, &status);
+    aocl_utils::checkError(status, "Failed to create command queue cq0");
+    cq1 = clCreateCommandQueue(session.context(), session.device(), CL_QUEUE_PROFILING_ENABLE, &status);
+    aocl_utils::checkError(status, "Failed to create command queue cq1");
+
+    double window_ns = 0, send_ns = 0, recv_ns = 0, skew_ns = 0, tail_ns = 0;
+    bool   verified = true;
+    for (size_t i = 0; i < tries; ++i) {
+      // A pattern the random payload in [0, 1) never has, so that a run that
+      // delivers nothing does not pass on the values of the previous one
+      const cl_uint pattern = 0xdeadbeef;
+      status = clEnqueueFillBuffer(cq1, recv_buf, &pattern, sizeof(pattern), 0, bytes, 0, NULL, aocl_utils::traceEvent("fill recv"));
+      aocl_utils::checkError(status, "Failed to fill the receive buffer");
+
+      aocl_utils::scoped_cl_event send_event, recv_event;
+      status = clEnqueueNDRangeKernel(cq0, send, 1, NULL, aoclbench::global_item_size, aoclbench::local_item_size, 0, NULL, send_event.out());
+      aocl_utils::checkError(status, "Failed to launch send");
+      status = clEnqueueNDRangeKernel(cq1, recv, 1, NULL, aoclbench::global_item_size, aoclbench::local_item_size, 0, NULL, recv_event.out());
+      aocl_utils::checkError(status, "Failed to launch recv");
+      aocl_utils::traceCommand(send_event, "send");
+      aocl_utils::traceCommand(recv_event, "recv");
+      // Both kernels have to run at once: send blocks once the channel is full
+      clFlush(cq0);
+      clFlush(cq1);
+      clFinish(cq0);
+      clFinish(cq1);
+
+      cl_ulong send_start = profile(send_event, CL_PROFILING_COMMAND_START), send_end = profile(send_event, CL_PROFILING_COMMAND_END);
+      cl_ulong recv_start = profile(recv_event, CL_PROFILING_COMMAND_START), recv_end = profile(recv_event, CL_PROFILING_COMMAND_END);
+      window_ns += std::max(send_end, recv_end) - std::min(send_start, recv_start);
+      send_ns   += send_end - send_start;
+      recv_ns   += recv_end - recv_start;
+      skew_ns   += (double)recv_start - (double)send_start;
+      tail_ns   += (double)recv_end - (double)send_end;
+
+      std::vector<cl_float> received(num);
+      status = clEnqueueReadBuffer(cq1, recv_buf, CL_TRUE, 0, bytes, received.data(), 0, NULL, aocl_utils::traceEvent("read recv"));
+      aocl_utils::checkError(status, "Failed to transfer the received values");
+      verified = verified && memcmp(received.data(), m_send.data(), bytes) == 0;
+    }
+
+    result.check(verified);
+    result.add("type", type);
+    result.add("depth", depth);
+    result.add("messages", messages);
+    result.add("bytes_per_s", bytes * tries / (window_ns * 1.0e-9));
+    result.add("send_us", send_ns / tries * 1.0e-3);
+    result.add("recv_us", recv_ns / tries * 1.0e-3);
+    result.add("skew_us", skew_ns / tries * 1.0e-3);
+    result.add("tail_us", tail_ns / tries * 1.0e-3);
+    if (mhz > 0) {
+      result.add("send_stall", stall(messages, send_ns / tries, mhz));
+      result.add("recv_stall", stall(messages, recv_ns / tries, mhz));
+    }
+  }
+
+private:
+  // Returns the index of type in TYPES
+  static size_t check(const std::string &type, unsigned depth) {
+    size_t t = std::find(TYPES, TYPES + 4, type) - TYPES;
+    if (t == 4 || std::find(DEPTHS, DEPTHS + 5, depth) == DEPTHS + 5) {
+      throw aoclbench::ParamError("No channel of " + type + " with depth " + std::to_string(depth) + " in test.cl");
+    }
+    return t;
+  }
+
+  void prepare(size_t num) {
+    if (m_send.size() >= num) return;
+    std::mt19937 g(12345);
+    std::uniform_real_distribution<float> d;
+    m_send.resize(num);
+    for (size_t i = 0; i < num; ++i) m_send[i] = d(g);
+  }
+
+  static cl_ulong profile(cl_event event, cl_profiling_info param) {
+    cl_ulong value;
+    cl_int status = clGetEventProfilingInfo(event, param, sizeof(value), &value, NULL);
+    aocl_utils::checkError(status, "Failed to query event profiling info");
+    return value;
+  }
+
+  // Fraction of the cycles of a kernel of `ns` without one of its `messages` transfers
+  static double stall(cl_int messages, double ns, double mhz) {
+    double cycles = ns * mhz * 1.0e-3;
+    return (cycles > messages) ? 1.0 - messages / cycles : 0.0;
+  }
+
+  std::vector<cl_float> m_send;  // the payload on the host PC
+};
+REGISTER_BENCHMARK(Interkernel);
@@ -0,0 +1,38 @@
+///////////////////////////////////////////////////////////////////////////////////
+// LED test: the kernel of LED, which writes a value to the io channel ledcon.
+//
+// There is nothing to read back; the test passes if the kernel completes and
+// the LEDs on the board show the value.
+///////////////////////////////////////////////////////////////////////////////////
+
+#include "bench.h"
+
+
+/********************************************************************/
+class Led : public aoclbench::Benchmark {
+public:
+  const char *name() const { return "led"; }
+  const char *description() const { return "writes a value to the board LEDs"; }
+  const char *binary() const { return "../../LED/bin/led"; }
+  std::vector<aoclbench::Param> params() const {
+    aoclbench::Param params[] = {
+      {"value", "3", "the value shown on the LEDs"},
+    };
+    return std::vector<aoclbench::Param>(params, params + sizeof(params)/sizeof(params[0]));
+  }
+
+  void run(aocl_utils::Session &session, const aocl_utils::SweepPoint &point, aoclbench::Result &result) {
+    cl_int value = aocl_utils::getCount(point, "value", 3);
+    cl_int status;
+
+    cl_kernel kernel = session.kernel("led");
+    status = clSetKernelArg(kernel, 0, sizeof(cl_int), &value); aocl_utils::checkError(status, "Failed to set argument N");
+
+    status = clEnqueueNDRangeKernel(session.queue(), kernel, 1, NULL, aoclbench::global_item_size, aoclbench::local_item_size, 0, NULL, aocl_utils::traceEvent("kernel"));
+    aocl_utils::checkError(status, "Failed to launch kernel");
+    status = clFinish(session.queue());
+    result.check(status == CL_SUCCESS);
+    result.add("value", value);
+  }
+};
+REGISTER_BENCHMARK(Led);
@@ -0,0 +1,159 @@
+///////////////////////////////////////////////////////////////////////////////////
+// This host program is a single driver for the board tests of this repository
+// (DRAM bandwidth and latency, cycle counter, LED, ...).
+//
+// Each test registers itself as a Benchmark (see bench.h). The platform and
+// device are initialized once and the selected tests run one after another,
+// each over a list of configurations given as a sweep specification (see
+// AOCLUtils/sweep.h). The context, program, command queue and device buffers
+// stay alive between the configurations of a test, the program changing only
+// for a configuration built into an AOCX of its own, and device buffers are
+// pooled across tests (see AOCLUtils/buffer_pool.h). One result line is printed
+// as soon as each configuration completes. A configuration with an invalid
+// parameter fails without stopping the run. A summary line counts the tests
+// and the configurations that passed and failed; the exit status is non-zero
+// if any configuration failed.
+//
+// usage: ./host --test=<name>[,<name>...] | --suite
+//               [--sweep="datanum=4M,64M;tries=20"] [--<param>=<value> ...]
+//               [--<name>.aocx=<prefix>]
+//        ./host --list
+///////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <cstdlib>
+#include <exception>
+
+#include "CL/opencl.h"
+#include "AOCLUtils/aocl_utils.h"
+#include "bench.h"
+
+
+// OpenCL runtime configuration
+/********************************************************************/
+aocl_utils::scoped_ptr<aocl_utils::Session> session;
+
+
+// Function prototypes
+/********************************************************************/
+void usage();
+std::vector<aoclbench::Benchmark *> select_tests(const aocl_utils::Options &options);
+aocl_utils::SweepPoint make_point(const aoclbench::Benchmark &test, const aocl_utils::Options &options,
+                                  const aocl_utils::SweepPoint &sweep_point);
+void cleanup();
+
+
+/********************************************************************/
+int main(int argc, char *argv[]) {
+
+  aocl_utils::Options options(argc, argv);
+
+  // check command line arguments
+  if (options.has("list") || (!options.has("test") && !options.has("suite"))) { usage(); exit(0); }
+  std::vector<aoclbench::Benchmark *> tests = select_tests(options);
+  std::vector<aocl_utils::SweepPoint> sweep = aocl_utils::parseSweep(options.has("sweep") ? options.get<std::string>("sweep") : "");
+
+  // Initialization (once for all tests)
+  std::cout << "Initializing OpenCL" << std::endl;
+  if (!aocl_utils::setCwdToExeDir()) exit(1);
+  session.reset(new aocl_utils::Session());
+
+  size_t passed = 0, failed = 0, tests_failed = 0;
+  for (size_t t = 0; t < tests.size(); ++t) {
+    aoclbench::Benchmark &test = *tests[t];
+    std::string aocx_option = std::string(test.name()) + ".aocx";
+    std::string prefix = options.has(aocx_option) ? options.get<std::string>(aocx_option) : std::string(test.binary());
+    std::cout << "Running " << sweep.size() << " configuration(s) of " << test.name() << std::endl;
+
+    size_t failed_before = failed;
+    for (size_t p = 0; p < sweep.size(); ++p) {
+      aocl_utils::SweepPoint point = make_point(test, options, sweep[p]);
+      aoclbench::Result result;
+      try {
+        std::string binary = test.binaryFor(point, prefix);
+        if (!aocl_utils::fileExists(aocl_utils::getBoardBinaryFile(binary.c_str(), session->device()).c_str())) {
+          throw aoclbench::ParamError("No AOCX for " + binary);
+        }
+        session->loadProgram(binary);  // nothing to do if it is current
+        aocl_utils::TraceScope scope(test.name());
+        test.run(*session, point, result);
+      } catch (const std::exception &e) {
+        // A bad parameter (ParamError, or a number that parseCount or
+        // std::stod could not parse) fails this configuration only
+        std::cerr << "Error! " << test.name() << ": " << e.what() << std::endl;
+        result.check(false);
+      }
+      std::cout << result.str(test.name()) << std::endl;  // flush so that results stream out as they complete
+      if (result.passed()) ++passed; else ++failed;
+    }
+    if (failed > failed_before) ++tests_failed;
+
+    // Hand the buffers of this test to the pool for the next one
+    session->releaseBuffers();
+  }
+  session->pool().printStats();
+  std::cout << "summary tests=" << tests.size() << " tests_passed=" << tests.size() - tests_failed << " tests_failed=" << tests_failed
+            << " configurations=" << passed + failed << " configurations_passed=" << passed << " configurations_failed=" << failed << std::endl;
+
+  // Free the resources allocated
+  cleanup();
+
+  return (failed == 0) ? 0 : 1;
+}
+
+
+/********************************************************************/
+void usage() {
+  std::cout << "usage: ./host --test=<name>[,<name>...] | --suite [--sweep=<spec>] [--<param>=<value> ...] [--<name>.aocx=<prefix>]" << std::endl;
+  std::cout << "       ./host --list" << std::endl;
+  std::cout << std::endl << "tests:" << std::endl;
+  const std::vector<aoclbench::Benchmark *> &all = aoclbench::benchmarks();
+  for (size_t t = 0; t < all.size(); ++t) {
+    std::cout << "  " << all[t]->name() << ": " << all[t]->description() << std::endl;
+    std::cout << "    aocx: " << all[t]->binary() << std::endl;
+    std::vector<aoclbench::Param> params = all[t]->params();
+    for (size_t i = 0; i < params.size(); ++i) {
+      std::cout << "    --" << params[i].name << "=" << params[i].default_value << "  " << params[i].help << std::endl;
+    }
+  }
+}
+
+
+/********************************************************************/
+std::vector<aoclbench::Benchmark *> select_tests(const aocl_utils::Options &options) {
+  if (options.has("suite")) return aoclbench::benchmarks();
+
+  std::vector<aoclbench::Benchmark *> tests;
+  std::string names = options.get<std::string>("test");
+  for (size_t begin = 0; begin <= names.size(); ) {
+    size_t end = names.find(',', begin);
+    if (end == std::string::npos) end = names.size();
+    std::string name = names.substr(begin, end - begin);
+    aoclbench::Benchmark *test = aoclbench::findBenchmark(name);
+    if (test == NULL) { std::cerr << "Error! Unknown test " << name << " (see --list)" << std::endl; exit(1); }
+    tests.push_back(test);
+    begin = end + 1;
+  }
+  return tests;
+}
+
+
+/********************************************************************/
+aocl_utils::SweepPoint make_point(const aoclbench::Benchmark &test, const aocl_utils::Options &options,
+                                  const aocl_utils::SweepPoint &sweep_point) {
+  // A value in the sweep takes precedence over a plain option, which takes
+  // precedence over the default of the test.
+  aocl_utils::SweepPoint point = sweep_point;
+  std::vector<aoclbench::Param> params = test.params();
+  for (size_t i = 0; i < params.size(); ++i) {
+    if (point.count(params[i].name)) continue;
+    point[params[i].name] = options.has(params[i].name) ? options.get<std::string>(params[i].name) : std::string(params[i].default_value);
+  }
+  return point;
+}
+
+
+/********************************************************************/
+void cleanup() {
+  if (session) session->release();
+}
@@ -0,0 +1,103 @@
+// aocxinfo: prints what an AOCX holds, read from its ELF sections.
+//
+// usage: aocxinfo [--sections] [--section=<name>] [--require=<kernel>[,<kernel>...]] <file.aocx>...
+//   --sections      also list the sections with their offsets and sizes
+//   --section=name  write the contents of one section to stdout, nothing else
+//   --require=...   exit with status 1 if a file lacks one of the kernels
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#include "AOCLUtils/aocx.h"
+
+static void usage() {
+  printf("usage: aocxinfo [--sections] [--section=<name>] [--require=<kernel>[,<kernel>...]] <file.aocx>...\n");
+}
+
+static void print(const char *file, const aocl_utils::AocxInfo &info, bool sections) {
+  printf("%s\n", file);
+  printf("  board:    %s\n", info.board.empty() ? "?" : info.board.c_str());
+  printf("  compiler: %s\n", info.version.empty() ? "?" : info.version.c_str());
+  printf("  target:   %s\n", info.target.empty() ? "?" : info.target.c_str());
+  if(!info.compile_options.empty()) {
+    printf("  options:  %s\n", info.compile_options.c_str());
+  }
+  if(info.fmax_mhz > 0) {
+    printf("  fmax:     %.3f MHz\n", info.fmax_mhz);
+  } else {
+    printf("  fmax:     ?\n");
+  }
+  printf("  kernels: ");
+  for(size_t k = 0; k < info.kernels.size(); ++k) {
+    printf(" %s", info.kernels[k].c_str());
+  }
+  printf("%s\n", info.kernels.empty() ? " ?" : "");
+  if(sections) {
+    printf("  %-32s %12s %12s\n", "section", "offset", "size");
+    for(size_t i = 0; i < info.sections.size(); ++i) {
+      if(!info.sections[i].name.empty()) {
+        printf("  %-32s %12llu %12llu\n", info.sections[i].name.c_str(),
+               (unsigned long long)info.sections[i].offset, (unsigned long long)info.sections[i].size);
+      }
+    }
+  }
+}
+
+int main(int argc, char *argv[]) {
+  bool                     sections = false;
+  std::string              section;
+  std::vector<std::string> required;
+  std::vector<const char *> files;
+  for(int i = 1; i < argc; ++i) {
+    if(strcmp(argv[i], "--sections") == 0) {
+      sections = true;
+    } else if(strncmp(argv[i], "--section=", 10) == 0) {
+      section = argv[i] + 10;
+    } else if(strncmp(argv[i], "--require=", 10) == 0) {
+      std::string list = argv[i] + 10;
+      for(size_t pos = 0; pos <= list.size();) {
+        size_t comma = list.find(',', pos);
+        if(comma == std::string::npos) comma = list.size();
+        if(comma > pos) required.push_back(list.substr(pos, comma - pos));
+        pos = comma + 1;
+      }
+    } else if(argv[i][0] == '-') {
+      usage();
+      return 1;
+    } else {
+      files.push_back(argv[i]);
+    }
+  }
+  if(files.empty()) {
+    usage();
+    return 0;
+  }
+
+  std::vector<const char *> kernels;
+  for(size_t k = 0; k < required.size(); ++k) {
+    kernels.push_back(required[k].c_str());
+  }
+
+  int status = 0;
+  for(size_t i = 0; i < files.size(); ++i) {
+    aocl_utils::AocxInfo info;
+    std::string          error;
+    if(!aocl_utils::readAocx(files[i], &info, &error)) {
+      fprintf(stderr, "ERROR: %s: %s\n", files[i], error.c_str());
+      status = 1;
+      continue;
+    }
+    if(!section.empty()) {
+      std::string data = aocl_utils::readAocxSection(files[i], info, section);
+      fwrite(data.data(), 1, data.size(), stdout);
+      continue;
+    }
+    print(files[i], info, sections);
+    if(!kernels.empty() && !aocl_utils::checkAocxKernels(files[i], kernels.data(), (unsigned)kernels.size())) {
+      status = 1;
+    }
+  }
+  return status;
+}
@@ -0,0 +1,98 @@
+// Tagged cycle counters for kernel code, backed by the BSP.
+//
+// The BSP keeps AOCL_COUNTERS counters of kernel clock cycles. Kernel code
+// starts and stops a counter by region ID around the code to be profiled;
+// each counter adds up the cycles of all of its start..stop intervals and
+// counts the stops. After the run, the host drains all counters through the
+// collector kernel (AOCL_COUNTERS_COLLECTOR, host side in
+// AOCLUtils/counters.h):
+//
+//   #include "aocl_counters.h"
+//   AOCL_COUNTERS_COLLECTOR
+//
+//   __kernel void stage(...) {
+//     aocl_counter_start(REGION_LOAD);
+//     long v = load(...);
+//     aocl_counter_stop_after(REGION_LOAD, v);  // stops once v is computed
+//     ...
+//   }
+//
+// BSP contract: four io channels of 64 bits in board_spec.xml, next to the
+// single counter of cnt_start/cnt_stop/cnt_rslt.
+//   cnt_region_start  to the BSP    bits [7:0] region ID; the rest is ignored
+//   cnt_region_stop   to the BSP    bits [7:0] region ID; the rest is ignored
+//   cnt_query         to the BSP    bits [7:0] region ID, bit 8 the field
+//                                   (0 cycles, 1 stops), bit 9 clears the
+//                                   counter after the read
+//   cnt_result        from the BSP  the field selected by the query
+// A start of a running counter restarts its interval; a stop of a counter
+// that is not running is ignored. Counters are zero after reset. Region IDs
+// of AOCL_COUNTERS and above are ignored.
+//
+// The bits that the BSP ignores carry a value the kernel has computed, so that
+// the start or stop is scheduled after it (aocl_counter_start_after,
+// aocl_counter_stop_after). io channels are point to point: the starts and
+// stops of a program must all be in one kernel, and the collector kernel is
+// the only one to use cnt_query and cnt_result.
+
+#ifndef AOCL_COUNTERS_H
+#define AOCL_COUNTERS_H
+
+#pragma OPENCL EXTENSION cl_intel_channels : enable
+
+#ifndef AOCL_COUNTERS
+#define AOCL_COUNTERS 16
+#endif
+
+#define AOCL_COUNTER_QUERY_STOPS (1UL << 8)
+#define AOCL_COUNTER_QUERY_CLEAR (1UL << 9)
+
+channel ulong aocl_counter_start_ch  __attribute__((depth(0))) __attribute__((io("cnt_region_start")));
+channel ulong aocl_counter_stop_ch   __attribute__((depth(0))) __attribute__((io("cnt_region_stop")));
+channel ulong aocl_counter_query_ch  __attribute__((depth(0))) __attribute__((io("cnt_query")));
+channel ulong aocl_counter_result_ch __attribute__((depth(0))) __attribute__((io("cnt_result")));
+
+// Starts region `id` once `after` is computed.
+inline void aocl_counter_start_after(uchar id, long after) {
+  mem_fence(CLK_GLOBAL_MEM_FENCE | CLK_CHANNEL_MEM_FENCE);
+  write_channel_intel(aocl_counter_start_ch, ((ulong)after << 8) | id);
+  mem_fence(CLK_GLOBAL_MEM_FENCE | CLK_CHANNEL_MEM_FENCE);
+}
+
+inline void aocl_counter_start(uchar id) {
+  aocl_counter_start_after(id, 0);
+}
+
+// Stops region `id` once `value` is computed; returns `value`.
+inline long aocl_counter_stop_after(uchar id, long value) {
+  mem_fence(CLK_GLOBAL_MEM_FENCE | CLK_CHANNEL_MEM_FENCE);
+  write_channel_intel(aocl_counter_stop_ch, ((ulong)value << 8) | id);
+  mem_fence(CLK_GLOBAL_MEM_FENCE | CLK_CHANNEL_MEM_FENCE);
+  return value;
+}
+
+inline void aocl_counter_stop(uchar id) {
+  aocl_counter_stop_after(id, 0);
+}
+
+inline ulong aocl_counter_query(ulong query) {
+  write_channel_intel(aocl_counter_query_ch, query);
+  mem_fence(CLK_CHANNEL_MEM_FENCE);
+  return read_channel_intel(aocl_counter_result_ch);
+}
+
+// The collector kernel: cycles[i] and stops[i] of the first `num` counters,
+// which restart from zero if `clear` is set.
+#define AOCL_COUNTERS_COLLECTOR                                                      \
+  __attribute__((max_global_work_dim(0)))                                            \
+  __kernel void aocl_counters_collect(__global ulong *restrict cycles,               \
+                                      __global ulong *restrict stops,                \
+                                      const uint num, const uint clear) {            \
+    for (uint i = 0; i < num && i < AOCL_COUNTERS; ++i) {                            \
+      cycles[i] = aocl_counter_query(i);                                             \
+      stops[i]  = aocl_counter_query(i | AOCL_COUNTER_QUERY_STOPS |                  \
+                                     (clear ? AOCL_COUNTER_QUERY_CLEAR : 0));        \
+    }                                                                                \
+  }
+
+#endif
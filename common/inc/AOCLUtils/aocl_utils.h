@@ -27,6 +27,18 @@
 #include "AOCLUtils/opencl.h"
 #include "AOCLUtils/scoped_ptrs.h"
 #include "AOCLUtils/options.h"
+#include "AOCLUtils/bitstream.h"
+#include "AOCLUtils/sweep.h"
+#include "AOCLUtils/buffer_pool.h"
+#include "AOCLUtils/session.h"
+#include "AOCLUtils/ddr_model.h"
+#include "AOCLUtils/fsm_model.h"
+#include "AOCLUtils/counter_model.h"
+#include "AOCLUtils/trace.h"
+#include "AOCLUtils/async.h"
+#include "AOCLUtils/aocx.h"
+#include "AOCLUtils/kernel_clock.h"
+#include "AOCLUtils/counters.h"
 
 #endif
 
@@ -0,0 +1,63 @@
+// AOCX introspection without the OpenCL runtime.
+//
+// An AOCX is an ELF file whose .acl.* sections describe the binary next to
+// the FPGA image itself (.acl.fpga.bin). Reading those sections tells which
+// kernels a binary has, which board it was compiled for, the compiler
+// version and the kernel clock Quartus achieved, in milliseconds and without
+// clCreateProgramWithBinary, so before the FPGA would be reconfigured:
+//
+//   .acl.board                    board name
+//   .acl.version                  compiler version
+//   .acl.target                   target family
+//   .acl.compileoptions           aoc options
+//   .acl.kernel_arg_info.xml      kernels and their arguments
+//   .acl.source                   OpenCL source (kernels, if there is no XML)
+//   .acl.quartus_report           "Actual clock freq: ..." / "Kernel fmax: ..."
+//
+// Sections that are missing leave the matching fields empty.
+
+#ifndef AOCL_UTILS_AOCX_H
+#define AOCL_UTILS_AOCX_H
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace aocl_utils {
+
+struct AocxSection {
+  std::string name;
+  uint64_t    offset;  // in the file
+  uint64_t    size;
+};
+
+struct AocxInfo {
+  std::string              board;
+  std::string              version;
+  std::string              target;
+  std::string              compile_options;
+  std::vector<std::string> kernels;
+  double                   fmax_mhz;  // 0 if unknown
+  std::vector<AocxSection> sections;
+};
+
+// Reads the sections of an AOCX. Returns false, with the reason in *error
+// (if given), if the file cannot be read or is not an ELF file.
+bool readAocx(const char *file, AocxInfo *info, std::string *error = NULL);
+
+// Returns the contents of a section of an AOCX read by readAocx, or an empty
+// string if it has no such section.
+std::string readAocxSection(const char *file, const AocxInfo &info, const std::string &name);
+
+// Checks that the AOCX has each of the kernels. Prints an error message
+// naming the missing ones and returns false if not. Files that readAocx
+// cannot read, or that list no kernels, pass.
+bool checkAocxKernels(const char *file, const char *const *kernels, unsigned num_kernels);
+
+// Prints the board, compiler version and kernel clock of an AOCX on one
+// line. Prints nothing for files that readAocx cannot read.
+void printAocxSummary(const char *file);
+
+} // ns aocl_utils
+
+#endif
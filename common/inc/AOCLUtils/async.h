@@ -0,0 +1,43 @@
+// Completion of OpenCL commands as futures, on top of clSetEventCallback.
+//
+// Instead of parking the calling thread in a blocking read or clFinish, a
+// host enqueues whole chains of commands without blocking and gets a future
+// (or runs a continuation) for the events it cares about:
+//
+//   clEnqueueNDRangeKernel(queue, kernel, 1, NULL, global, local, 0, NULL, kernel_event.out());
+//   clEnqueueReadBuffer(queue, Y_buf, CL_FALSE, 0, size, Y, 1, kernel_event.ptr(), read_event.out());
+//   std::future<cl_int> done = aocl_utils::whenComplete(read_event);
+//   ...                                 // more chains, other queues or devices
+//   aocl_utils::checkError(done.get(), "Failed to read Y");
+//
+// The value of a future is the execution status of the command: CL_COMPLETE,
+// or the negative error code of a command that terminated abnormally.
+// Continuations run on a thread of the OpenCL runtime, so they must be short
+// and must not call blocking OpenCL functions. Commands are not flushed to
+// the device by any of this; the queue has to be flushed (clFlush) before
+// waiting on a future of one of its commands.
+
+#ifndef AOCL_UTILS_ASYNC_H
+#define AOCL_UTILS_ASYNC_H
+
+#include <functional>
+#include <future>
+
+#include "CL/opencl.h"
+
+namespace aocl_utils {
+
+// Calls continuation(status) once the command of `event` has completed. The
+// event is retained until then.
+void onComplete(cl_event event, const std::function<void(cl_int)> &continuation);
+
+// Returns a future for the completion of the command of `event`.
+std::future<cl_int> whenComplete(cl_event event);
+
+// Returns a future for the completion of all of the commands, whose value is
+// CL_COMPLETE or the status of one of those that terminated abnormally.
+std::future<cl_int> whenAllComplete(const cl_event *events, unsigned num_events);
+
+} // ns aocl_utils
+
+#endif
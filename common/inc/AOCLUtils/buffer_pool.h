@@ -0,0 +1,104 @@
+// Pool of device buffers reused across tries, sweep points and tests.
+//
+// Buffers are keyed by their flags (which include the bank selected with
+// CL_CHANNEL_n_INTELFPGA) and a size class. A request is rounded up to its
+// size class, the next multiple of 1/8 of the largest power of two below the
+// size, so a reused buffer wastes at most 12.5% of device memory. acquire()
+// hands out a Lease that returns the buffer to the pool when it is released or
+// destroyed. The contents of a reused buffer are whatever its previous user
+// left in it.
+
+#ifndef AOCL_UTILS_BUFFER_POOL_H
+#define AOCL_UTILS_BUFFER_POOL_H
+
+#include <map>
+#include <utility>
+
+#include "CL/opencl.h"
+#include "AOCLUtils/scoped_ptrs.h"
+
+namespace aocl_utils {
+
+class BufferPool {
+public:
+  // A buffer checked out of the pool. Movable, not copyable.
+  class Lease {
+  public:
+    Lease() : m_pool(NULL), m_mem(NULL), m_flags(0), m_size(0) {}
+    Lease(Lease &&other);
+    Lease &operator =(Lease &&other);
+    ~Lease() { release(); }
+
+    cl_mem get() const { return m_mem; }
+    const cl_mem *ptr() const { return &m_mem; }  // for clSetKernelArg
+    operator cl_mem() const { return m_mem; }
+    cl_mem_flags flags() const { return m_flags; }
+    size_t size() const { return m_size; }  // capacity in bytes (the size class)
+
+    // Returns the buffer to the pool.
+    void release();
+
+  private:
+    friend class BufferPool;
+    Lease(BufferPool *pool, cl_mem mem, cl_mem_flags flags, size_t size)
+      : m_pool(pool), m_mem(mem), m_flags(flags), m_size(size) {}
+
+    BufferPool  *m_pool;
+    cl_mem       m_mem;
+    cl_mem_flags m_flags;
+    size_t       m_size;
+
+    Lease(const Lease &);
+    Lease &operator =(const Lease &);
+  };
+
+  struct Stats {
+    unsigned long requests;          // calls to acquire()
+    unsigned long hits;              // requests served by an idle buffer
+    size_t        device_bytes;      // bytes allocated on the device (leased and idle)
+    size_t        peak_device_bytes;
+    size_t        leased_bytes;
+
+    double hitRate() const { return requests ? double(hits) / double(requests) : 0.0; }
+  };
+
+  explicit BufferPool(cl_context context = NULL);
+  ~BufferPool();
+
+  // Releases the idle buffers and allocates from `context` from now on.
+  // All leases must have been released.
+  void setContext(cl_context context);
+
+  // Returns a buffer of at least `size` bytes. An idle buffer of the same
+  // flags and size class is reused if there is one. If the device is out of
+  // memory, idle buffers are released and the allocation is retried.
+  Lease acquire(cl_mem_flags flags, size_t size);
+
+  // Releases all idle buffers.
+  void trim();
+
+  const Stats &stats() const { return m_stats; }
+  void printStats() const;
+
+  static size_t sizeClass(size_t size);
+
+private:
+  typedef std::pair<cl_mem_flags, size_t> Key;
+  typedef std::multimap<Key, scoped_cl_mem> FreeMap;
+
+  cl_mem allocate(cl_mem_flags flags, size_t size, cl_int *status);
+  void giveBack(cl_mem mem, cl_mem_flags flags, size_t size);
+
+  cl_context    m_context;
+  FreeMap       m_free;
+  unsigned long m_leases;  // outstanding leases
+  Stats         m_stats;
+
+  // noncopyable
+  BufferPool(const BufferPool &);
+  BufferPool &operator =(const BufferPool &);
+};
+
+} // ns aocl_utils
+
+#endif
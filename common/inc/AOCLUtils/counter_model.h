@@ -0,0 +1,103 @@
+// Cycle-accurate model of wait_func.v and of the cycle counter of the BSP.
+//
+// The counter sits behind three io channels of the board. A word on
+// cnt_start restarts it, a word on cnt_stop stops it, and the cycles in
+// between go out on cnt_rslt. Each channel is an Avalon-ST handshake
+// (valid/ready, depth 0). The BSP takes a word in the edge it is offered and
+// sees it in_cycles later; the result is offered out_cycles after the stop
+// is seen. Both words take the same path, so the count is the distance
+// between the two handshakes in the kernel.
+//
+// wait_func.v takes its argument N in edge 0 and sees cycle == N in edge
+// N+1. It raises m_valid_out after edge N+2 and returns its cycle register,
+// N+2, in edge N+3 if m_ready_in is high right away. Every cycle that
+// m_ready_in stays low adds one to both.
+//
+// Where tb_wait_func places the handshakes is up to the aoc schedule. The
+// model has call_gap cycles from the cnt_start write to wait_func taking N,
+// and stop_gap cycles from wait_func returning to the cnt_stop write. The
+// defaults are not measured on a board; the sweep of the cycle_counter host
+// fits the actual overhead.
+//
+// The Verilator harness of cycle_counter/sim clocks wait_func.v against
+// CycleCounterModel. predictTbWaitFunc gives the same numbers in closed form,
+// and the mock runtime returns those.
+//
+// No OpenCL here, so that the harness can use it without the SDK.
+
+#ifndef AOCL_UTILS_COUNTER_MODEL_H
+#define AOCL_UTILS_COUNTER_MODEL_H
+
+#include <deque>
+#include <stdint.h>
+
+namespace aocl_utils {
+
+// Parameters, read from the environment (defaults in brackets).
+struct CounterConfig {
+  unsigned in_cycles;    // CNT_IN_CYCLES [2]: io channel to the counter
+  unsigned out_cycles;   // CNT_OUT_CYCLES [2]: stop seen to result offered (at least 1)
+  unsigned call_gap;     // CNT_CALL_GAP [1]: cnt_start write to wait_func taking N
+  unsigned stop_gap;     // CNT_STOP_GAP [2]: wait_func returning to cnt_stop write (at least 1)
+  unsigned ready_delay;  // CNT_READY_DELAY [0]: cycles m_ready_in stays low after m_valid_out
+
+  static CounterConfig fromEnv();
+  void print() const;
+
+  // measured - expected of tb_wait_func
+  unsigned overheadCycles() const { return call_gap + stop_gap + 1; }
+};
+
+// wait_func.v: edges from taking N to returning, and the value it returns.
+inline uint64_t waitFuncLatency(uint64_t n, unsigned ready_delay = 0) { return n + 3 + ready_delay; }
+inline uint64_t waitFuncResult(uint64_t n, unsigned ready_delay = 0) { return n + 2 + ready_delay; }
+
+// The counter of the BSP, one clock edge at a time. The sinks of cnt_start
+// and cnt_stop are always ready.
+class CycleCounterModel {
+public:
+  explicit CycleCounterModel(const CounterConfig &config);
+
+  // Channel inputs in the cycle before an edge
+  struct Inputs {
+    bool start_valid;
+    bool stop_valid;
+    bool result_ready;
+  };
+
+  // cnt_rslt in the cycle before the next edge
+  bool resultValid() const;
+  uint64_t result() const;
+
+  // Clocks one edge. Returns true if a result was taken at it.
+  bool edge(const Inputs &in);
+
+  uint64_t cycle() const { return m_cycle; }
+
+private:
+  struct Result {
+    uint64_t valid_from;
+    uint64_t cycles;
+  };
+
+  CounterConfig      m_config;
+  uint64_t           m_cycle;
+  bool               m_started;
+  uint64_t           m_start_seen;  // edge the last start reaches the counter
+  std::deque<Result> m_results;
+};
+
+// tb_wait_func(expected, measured, N) in edges: wait_func(N) once for
+// `expected`, then cnt_start, wait_func(N) again, cnt_stop and the read of
+// cnt_rslt for `measured`. kernel_cycles runs from the first call to the
+// read of the result.
+struct TbWaitFuncTiming {
+  uint64_t expected;
+  uint64_t measured;
+  uint64_t kernel_cycles;
+};
+TbWaitFuncTiming predictTbWaitFunc(const CounterConfig &config, uint64_t n);
+
+} // ns aocl_utils
+
+#endif
@@ -0,0 +1,103 @@
+// Tagged cycle counters: the host side of common/device/aocl_counters.h.
+//
+// Kernel code starts and stops the counters of the BSP per region ID; a
+// program that instantiates AOCL_COUNTERS_COLLECTOR also has the kernel
+// aocl_counters_collect, which reads them into two buffers. A
+// CounterCollector runs that kernel after the kernels being profiled:
+//
+//   aocl_utils::CounterCollector counters(context, program);
+//   counters.setName(REGION_LOAD, "load");
+//   ...                                   // run the kernels
+//   counters.drain(queue, 1, kernel_event.ptr());
+//   counters.print(kernel_mhz);
+//
+// Starting and stopping a counter costs a few cycles of channel handshake,
+// which a short region cannot tell from its own cycles. The cycle_counter
+// host fits that overhead over a sweep of wait_func lengths in tb_regions
+// (its "sweep" mode) and saves the fit to the file named by
+// AOCL_COUNTER_CALIBRATION; a CounterCollector created with that variable set
+// subtracts it from every interval it reports.
+
+#ifndef AOCL_UTILS_COUNTERS_H
+#define AOCL_UTILS_COUNTERS_H
+
+#include <string>
+#include <vector>
+
+#include "CL/opencl.h"
+#include "AOCLUtils/scoped_ptrs.h"
+
+namespace aocl_utils {
+
+// A counted interval of `cycles` cycles reads as scale * cycles + offset.
+struct CounterCalibration {
+  double   scale;
+  double   offset;        // the fixed overhead of one interval, in cycles
+  double   residual_rms;  // of the fit, in cycles
+  double   residual_max;
+  unsigned samples;
+};
+
+// One measurement of an interval whose true length is known.
+struct CounterSample {
+  double expected;
+  double measured;
+};
+
+// Least-squares fit of measured against expected. Returns false if the
+// samples do not determine a fit (fewer than two distinct lengths).
+bool fitCounterCalibration(const std::vector<CounterSample> &samples, CounterCalibration &calibration);
+
+// Returns the calibration file selected through AOCL_COUNTER_CALIBRATION, or
+// NULL if there is none.
+const char *getCounterCalibrationFile();
+bool saveCounterCalibration(const char *file, const CounterCalibration &calibration);
+bool loadCounterCalibration(const char *file, CounterCalibration &calibration);
+
+class CounterCollector {
+public:
+  // Region IDs are 8 bits wide
+  static const unsigned MAX_COUNTERS = 256;
+
+  // num_counters is AOCL_COUNTERS of the program (16 unless it was changed).
+  // Loads the calibration of getCounterCalibrationFile if there is one.
+  CounterCollector(cl_context context, cl_program program, unsigned num_counters = 16);
+
+  unsigned numCounters() const { return m_num_counters; }
+  void setName(unsigned id, const std::string &name);
+
+  // Replaces the calibration; without one, counts are reported as read.
+  void setCalibration(const CounterCalibration &calibration);
+  bool calibrated() const { return m_calibrated; }
+
+  // Runs the collector on `queue` once the given events (the kernels being
+  // profiled) have completed, and waits for the counts. Kernels of other
+  // queues that are not in the wait list must have completed already. With
+  // `clear`, the counters of the BSP restart from zero.
+  void drain(cl_command_queue queue, cl_uint num_events = 0, const cl_event *events = NULL, bool clear = true);
+
+  // Counts of the last drain: the cycles of all intervals of region `id`,
+  // corrected by the calibration, and the number of its stops.
+  double cycles(unsigned id) const;
+  cl_ulong rawCycles(unsigned id) const { return m_cycles[id]; }
+  cl_ulong stops(unsigned id) const { return m_stops[id]; }
+
+  // Prints the regions that were stopped at least once, with their times if
+  // the kernel clock is given.
+  void print(double kernel_mhz = 0) const;
+
+private:
+  unsigned                 m_num_counters;
+  bool                     m_calibrated;
+  CounterCalibration       m_calibration;
+  scoped_cl_kernel         m_kernel;
+  scoped_cl_mem            m_cycles_buf;
+  scoped_cl_mem            m_stops_buf;
+  std::vector<cl_ulong>    m_cycles;
+  std::vector<cl_ulong>    m_stops;
+  std::vector<std::string> m_names;
+};
+
+} // ns aocl_utils
+
+#endif
@@ -0,0 +1,137 @@
+// Timing model of a DDR memory behind the 512-bit Avalon-MM port of a kernel.
+//
+// DdrModel follows each 64-byte beat through a DDR channel: banks with one
+// open row each (tRCD to activate, tRP to precharge first), the CAS latency
+// (tCL for reads, tCWL for writes), a data bus that moves a column burst of
+// burst_length transfers of bus_bytes per memory clock edge, and refreshes
+// that close all banks for tRFC every tREFI. The controller and interconnect
+// add a fixed pipeline latency, it accepts at most queue_depth read bursts
+// or write beats ahead of the DRAM, and the port returns one beat per kernel
+// cycle. Times are kernel clock cycles since reset.
+//
+// The Verilator harness of the DRAM RTL modules (DRAM/sim) uses it as the
+// memory behind the port; the predict* functions run the burst FSMs of
+// DRAM_READ/DRAM_WRITE (and the latency module) against it, which is what
+// the mock runtime returns and what the hosts print next to the cycles they
+// measure.
+//
+// No OpenCL here, so that the harness can use it without the SDK.
+
+#ifndef AOCL_UTILS_DDR_MODEL_H
+#define AOCL_UTILS_DDR_MODEL_H
+
+#include <deque>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace aocl_utils {
+
+// Parameters, read from the environment (defaults in brackets: one DDR4-2400
+// 16-16-16 channel of 64 bits, as on the Arria 10 boards).
+struct DdrConfig {
+  double   kernel_mhz;     // kernel clock, from the caller
+  double   mhz;            // DDR_MHZ [1200]: memory clock (data rate / 2)
+  unsigned tcl;            // DDR_TCL [16]: read CAS latency, memory clocks
+  unsigned tcwl;           // DDR_TCWL [12]: write CAS latency
+  unsigned trcd;           // DDR_TRCD [16]: activate to CAS
+  unsigned trp;            // DDR_TRP [16]: precharge to activate
+  double   trefi_ns;       // DDR_TREFI_NS [7800]: refresh interval
+  double   trfc_ns;        // DDR_TRFC_NS [350]: refresh time
+  unsigned banks;          // DDR_BANKS [16]
+  unsigned row_bytes;      // DDR_ROW_BYTES [8192]
+  unsigned bus_bytes;      // DDR_BUS_BYTES [8]
+  unsigned burst_length;   // DDR_BURST_LENGTH [8]
+  unsigned ctrl_cycles;    // DDR_CTRL_CYCLES [100]: controller round trip, kernel cycles
+  unsigned queue_depth;    // DDR_QUEUE_DEPTH [32]: read bursts / write beats in flight
+
+  static DdrConfig fromEnv(double kernel_mhz);
+  void print() const;
+
+  // Peak bandwidth of the memory and of the 512-bit port, GB/s
+  double peakGBps() const;
+  double portGBps() const;
+};
+
+struct DdrStats {
+  uint64_t row_hits;
+  uint64_t row_misses;   // including accesses to closed banks
+  uint64_t refreshes;
+};
+
+class DdrModel {
+public:
+  static const unsigned BEAT_BYTES = 64;
+
+  explicit DdrModel(const DdrConfig &config);
+
+  const DdrConfig &config() const { return m_config; }
+  const DdrStats &stats() const { return m_stats; }
+
+  // A read of the beat at byte address `addr` accepted in cycle `now`.
+  // Returns the cycle the beat is returned in; beats are returned in the
+  // order they were accepted, one per cycle.
+  uint64_t readBeat(uint64_t now, uint64_t addr);
+
+  // Whether the controller takes a write beat in cycle `now`.
+  bool canWrite(uint64_t now);
+  // First cycle from `now` on in which canWrite holds
+  uint64_t nextWriteSlot(uint64_t now);
+  // A write of the beat at `addr` accepted in cycle `now`. Returns the cycle
+  // the data has been written to the DRAM.
+  uint64_t writeBeat(uint64_t now, uint64_t addr);
+
+  // Schedules the writeack of a burst whose last beat is written in cycle
+  // `done`; acks are given in order, one per cycle.
+  void scheduleWriteAck(uint64_t now, uint64_t done);
+  // Takes the writeack due in cycle `now`, if any.
+  bool takeWriteAck(uint64_t now);
+  // Drops acks due before `now`; returns the cycle of the next one (0 if none).
+  uint64_t nextWriteAck(uint64_t now);
+  bool pendingWriteAcks() const { return !m_acks.empty(); }
+
+private:
+  struct Bank {
+    int64_t open_row;   // -1 if precharged
+    double  ready;      // memory clocks: earliest next command
+  };
+
+  double toMemory(uint64_t cycle) const { return cycle * m_config.mhz / m_config.kernel_mhz; }
+  uint64_t toKernel(double clocks) const;
+  double access(uint64_t now, uint64_t addr, bool write);
+  double refresh(double t);
+
+  DdrConfig             m_config;
+  DdrStats              m_stats;
+  std::vector<Bank>     m_banks;
+  double                m_bus_free;       // memory clocks
+  double                m_next_refresh;   // memory clocks
+  double                m_beat_clocks;    // bus time of one beat
+  uint64_t              m_last_beat;      // cycle of the last beat returned
+  std::deque<uint64_t>  m_writes;         // cycles the buffered writes complete
+  std::deque<uint64_t>  m_acks;
+};
+
+// Cycles the DRAM bandwidth modules report, run against `ddr` from a start
+// of the call in cycle `start`.
+//  - read.v: DRAM_READ reading `beats` beats from `addr`
+//  - write.v: DRAM_WRITE writing `beats` beats to `addr`
+//  - latency read.v: one load of `addr`
+// Bursts are of (1 << maxburst_log) beats at most.
+uint64_t predictDramReadCycles(DdrModel &ddr, uint64_t start, uint64_t addr, uint64_t beats, unsigned maxburst_log = 4);
+uint64_t predictDramWriteCycles(DdrModel &ddr, uint64_t start, uint64_t addr, uint64_t beats, unsigned maxburst_log = 4);
+uint64_t predictReadLatencyCycles(DdrModel &ddr, uint64_t start, uint64_t addr);
+
+// The tb_read kernel of DRAM/latency: loads of X[index[i]], X at byte address
+// `base`, one after the other. Sets cycles[i] to what the module reports for
+// load i and returns the cycles of the whole loop: the reported cycles plus
+// LATENCY_CALL_GAP_CYCLES per load for the handshakes between calls.
+static const unsigned LATENCY_CALL_GAP_CYCLES = 4;
+uint64_t predictLatencyKernelCycles(DdrModel &ddr, uint64_t base, const int *index, size_t n, int *cycles);
+
+// Prints the predicted cycles next to the measured ones.
+void printPrediction(double measured_cycles, double predicted_cycles);
+
+} // ns aocl_utils
+
+#endif
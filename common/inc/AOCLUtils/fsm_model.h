@@ -0,0 +1,58 @@
+// Closed-form cycle counts of the DRAM_READ/DRAM_WRITE burst FSMs.
+//
+// The FSMs are deterministic, so for a memory described by a latency and a
+// sustained throughput the cycles read.v and write.v report follow from the
+// number of bursts alone:
+//
+//  - DRAM_READ accepts a burst every 2 cycles (state 1 bubble), from cycle 3
+//    after the start; the beats come back `latency` cycles after the request
+//    at min(1, throughput) beats per cycle. read.v counts to the last beat.
+//  - DRAM_WRITE sends the beats of a burst back to back with a bubble
+//    between bursts, slowed down to the throughput of the memory by
+//    waitrequest. write.v counts to the first writeack after the last beat,
+//    which is the ack of an earlier burst if the ack latency is longer than
+//    a burst.
+//
+// Unlike DdrModel, there are no banks, refreshes or queues here: this is the
+// bound the RTL reaches on an ideal memory with that latency and throughput,
+// so efficiency = bound / measured tells whether a slowdown is in the RTL
+// (both move) or in the memory (only the measurement moves).
+
+#ifndef AOCL_UTILS_FSM_MODEL_H
+#define AOCL_UTILS_FSM_MODEL_H
+
+#include <stdint.h>
+
+#include "AOCLUtils/ddr_model.h"
+
+namespace aocl_utils {
+
+struct FsmParams {
+  unsigned maxburst_log;     // MAXBURST_LOG of the FSMs [4]
+  unsigned data_width;       // DRAM_DATAWIDTH, bits [512]
+  double   kernel_mhz;
+  double   latency_cycles;   // MEM_LATENCY_CYCLES: read request to first beat
+  double   writeack_cycles;  // MEM_WRITEACK_CYCLES: last beat of a burst to its writeack
+  double   gbps;             // MEM_GBPS: sustained throughput of the memory
+
+  // Latency and throughput of an idle DDR channel as DdrModel sees it.
+  static FsmParams fromDdr(const DdrConfig &ddr);
+  // fromDdr(DdrConfig::fromEnv(kernel_mhz)), with any of the MEM_* variables
+  // above overriding, e.g. with figures measured on the board.
+  static FsmParams fromEnv(double kernel_mhz);
+  void print() const;
+
+  // Beats the memory can take or give per kernel cycle (not capped at 1)
+  double beatsPerCycle() const;
+};
+
+// Cycles read.v and write.v report for `datanum` 32-bit elements.
+uint64_t fsmReadCycles(const FsmParams &params, uint64_t datanum);
+uint64_t fsmWriteCycles(const FsmParams &params, uint64_t datanum);
+
+// Prints the bound next to the measured cycles.
+void printEfficiency(double measured_cycles, uint64_t bound_cycles);
+
+} // ns aocl_utils
+
+#endif
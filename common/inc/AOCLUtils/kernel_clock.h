@@ -0,0 +1,43 @@
+// Kernel clock calibration.
+//
+// The RTL modules count kernel clock cycles, and the hosts need the kernel
+// clock to turn them into seconds. The clock the board actually runs a
+// binary at depends on the compile and on the board, so it is measured: a
+// kernel is run for a few cycle counts it reports itself, and the cycles are
+// fitted against the CL_PROFILING_COMMAND_START..END time of each run. The
+// slope of the fit is the clock; the launch overhead in the profiling time
+// is the intercept and drops out. If no measurement is possible, the kernel
+// fmax that the compiler stored in the AOCX is used instead.
+
+#ifndef AOCL_UTILS_KERNEL_CLOCK_H
+#define AOCL_UTILS_KERNEL_CLOCK_H
+
+#include <vector>
+
+#include "CL/opencl.h"
+
+namespace aocl_utils {
+
+// One calibration run: the kernel cycles of the run and the START..END time
+// of its event.
+struct ClockSample {
+  double   cycles;
+  cl_ulong ns;
+};
+
+// Least-squares fit of cycles against time, in MHz. Returns 0 if the samples
+// do not determine a clock (fewer than two distinct cycle counts, or a slope
+// that is not positive).
+double fitKernelMhz(const std::vector<ClockSample> &samples);
+
+// Returns the kernel clock recorded in the Quartus report of an AOCX
+// ("Actual clock freq", else "Kernel fmax"), in MHz, or 0 if there is none.
+double getBinaryFmaxMhz(const char *binary_file);
+
+// Returns measured_mhz if it is positive, else the fmax of the AOCX, and
+// prints which one is used. Exits with an error message if there is neither.
+double selectKernelMhz(double measured_mhz, const char *binary_file);
+
+} // ns aocl_utils
+
+#endif
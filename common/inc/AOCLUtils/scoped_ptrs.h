@@ -28,6 +28,9 @@ namespace aocl_utils {
 
 // Interface is essentially the combination of std::auto_ptr and boost's smart pointers,
 // along with some small extensions (auto conversion to T*).
+//
+// All of them are movable but not copyable, so they can be returned from
+// factories and stored in standard containers.
 
 // scoped_ptr: assumes pointer was allocated with operator new; destroys with operator delete
 template<typename T>
@@ -37,6 +40,7 @@ public:
 
   scoped_ptr() : m_ptr(NULL) {}
   scoped_ptr(T *ptr) : m_ptr(ptr) {}
+  scoped_ptr(this_type &&other) : m_ptr(other.release()) {}
   ~scoped_ptr() { reset(); }
 
   T *get() const { return m_ptr; }
@@ -45,6 +49,7 @@ public:
   T &operator *() const { return *m_ptr; }
 
   this_type &operator =(T *ptr) { reset(ptr); return *this; }
+  this_type &operator =(this_type &&other) { reset(other.release()); return *this; }
 
   void reset(T *ptr = NULL) { delete m_ptr; m_ptr = ptr; }
   T *release() { T *ptr = m_ptr; m_ptr = NULL; return ptr; }
@@ -68,6 +73,7 @@ public:
   scoped_array() : m_ptr(NULL) {}
   scoped_array(T *ptr) : m_ptr(NULL) { reset(ptr); }
   explicit scoped_array(size_t n) : m_ptr(NULL) { reset(n); }
+  scoped_array(this_type &&other) : m_ptr(other.release()) {}
   ~scoped_array() { reset(); }
 
   T *get() const { return m_ptr; }
@@ -77,6 +83,7 @@ public:
   T &operator [](int index) const { return m_ptr[index]; }
 
   this_type &operator =(T *ptr) { reset(ptr); return *this; }
+  this_type &operator =(this_type &&other) { reset(other.release()); return *this; }
 
   void reset(T *ptr = NULL) { delete[] m_ptr; m_ptr = ptr; }
   void reset(size_t n) { reset(new T[n]); }
@@ -101,6 +108,7 @@ public:
   scoped_aligned_ptr() : m_ptr(NULL) {}
   scoped_aligned_ptr(T *ptr) : m_ptr(NULL) { reset(ptr); }
   explicit scoped_aligned_ptr(size_t n) : m_ptr(NULL) { reset(n); }
+  scoped_aligned_ptr(this_type &&other) : m_ptr(other.release()) {}
   ~scoped_aligned_ptr() { reset(); }
 
   T *get() const { return m_ptr; }
@@ -110,6 +118,7 @@ public:
   T &operator [](int index) const { return m_ptr[index]; }
 
   this_type &operator =(T *ptr) { reset(ptr); return *this; }
+  this_type &operator =(this_type &&other) { reset(other.release()); return *this; }
 
   void reset(T *ptr = NULL) { if(m_ptr) alignedFree(m_ptr); m_ptr = ptr; }
   void reset(size_t n) { reset((T*) alignedMalloc(sizeof(T) * n)); }
@@ -135,6 +144,7 @@ public:
 	scoped_SVM_aligned_ptr() : m_ptr(NULL) {}
 	scoped_SVM_aligned_ptr(T *ptr) : m_ptr(NULL) { reset(ptr); }
 	explicit scoped_SVM_aligned_ptr(cl_context ctx, size_t n) : m_ptr(NULL) { reset(ctx, n); }
+	scoped_SVM_aligned_ptr(this_type &&other) : m_ptr(NULL) { *this = static_cast<this_type &&>(other); }
 	~scoped_SVM_aligned_ptr() { reset(); }
 
 	T *get() const { return m_ptr; }
@@ -144,6 +154,7 @@ public:
 	T &operator [](int index) const { return m_ptr[index]; }
 
 	this_type &operator =(T *ptr) { reset(ptr); return *this; }
+	this_type &operator =(this_type &&other) { cl_context ctx = other.m_ctx; T *ptr = other.release(); reset(ptr); m_ctx = ctx; return *this; }
 
 	void reset(T *ptr = NULL) { if (m_ptr) clSVMFree(m_ctx, m_ptr); m_ptr = ptr; }
 	void reset(cl_context ctx, size_t n) { reset((T*)clSVMAlloc(ctx, 0, sizeof(T) * n, 0)); m_ctx = ctx; }
@@ -159,6 +170,51 @@ private:
 };
 #endif /* USE_SVM_API == 1 */
 
+// scoped_cl_handle: owns one reference to an OpenCL object; destroys with the
+// clRelease* function of its type.
+template<typename T, cl_int (CL_API_CALL *Release)(T)>
+class scoped_cl_handle {
+public:
+  typedef scoped_cl_handle<T, Release> this_type;
+
+  scoped_cl_handle() : m_handle(NULL) {}
+  scoped_cl_handle(T handle) : m_handle(handle) {}
+  scoped_cl_handle(this_type &&other) : m_handle(other.release()) {}
+  ~scoped_cl_handle() { reset(); }
+
+  T get() const { return m_handle; }
+  operator T() const { return m_handle; }
+
+  // Address of the handle, for clSetKernelArg and event wait lists.
+  const T *ptr() const { return &m_handle; }
+
+  // Releases the current object and returns the address of the handle, for
+  // an OpenCL call that returns a new object through it (e.g. the event of
+  // clEnqueue*). Reusing one handle per try this way does not leak.
+  T *out() { reset(); return &m_handle; }
+
+  this_type &operator =(T handle) { reset(handle); return *this; }
+  this_type &operator =(this_type &&other) { reset(other.release()); return *this; }
+
+  void reset(T handle = NULL) { if(m_handle) Release(m_handle); m_handle = handle; }
+  T release() { T handle = m_handle; m_handle = NULL; return handle; }
+
+private:
+  T m_handle;
+
+  // noncopyable
+  scoped_cl_handle(const this_type &);
+  this_type &operator =(const this_type &);
+};
+
+typedef scoped_cl_handle<cl_context,       clReleaseContext>      scoped_cl_context;
+typedef scoped_cl_handle<cl_command_queue, clReleaseCommandQueue> scoped_cl_command_queue;
+typedef scoped_cl_handle<cl_program,       clReleaseProgram>      scoped_cl_program;
+typedef scoped_cl_handle<cl_kernel,        clReleaseKernel>       scoped_cl_kernel;
+typedef scoped_cl_handle<cl_mem,           clReleaseMemObject>    scoped_cl_mem;
+typedef scoped_cl_handle<cl_event,         clReleaseEvent>        scoped_cl_event;
+typedef scoped_cl_handle<cl_sampler,       clReleaseSampler>      scoped_cl_sampler;
+
 } // ns aocl_utils
 
 #endif
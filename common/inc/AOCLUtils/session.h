@@ -0,0 +1,88 @@
+// Persistent OpenCL state for running many benchmark configurations.
+//
+// A session finds the platform and devices once and keeps the context,
+// program, command queue, kernels and device buffers alive between
+// configurations, so that a parameter sweep pays the initialization cost
+// only once. Device buffers come from a BufferPool, so buffers given up by one
+// configuration or test are reused by the next. Loading a different binary
+// replaces the program and its kernels but keeps the context, the queue and
+// the pooled buffers, which belong to the context. Only a load that reuses the
+// resident bitstream (see AOCLUtils/bitstream.h), or the first load after one,
+// needs a new context and releases the rest with the old one.
+
+#ifndef AOCL_UTILS_SESSION_H
+#define AOCL_UTILS_SESSION_H
+
+#include <map>
+#include <string>
+
+#include "CL/opencl.h"
+#include "AOCLUtils/scoped_ptrs.h"
+#include "AOCLUtils/buffer_pool.h"
+
+namespace aocl_utils {
+
+class Session {
+public:
+  // Finds the platform whose name contains platform_name and its devices.
+  // Exits with an error message if the platform does not exist.
+  explicit Session(const char *platform_name = "Intel(R) FPGA");
+  ~Session();
+
+  // Makes the program built from the AOCX for `prefix` (see
+  // getBoardBinaryFile) current. Does nothing if it already is.
+  void loadProgram(const std::string &prefix);
+
+  cl_platform_id platform() const { return m_platform; }
+  cl_device_id device() const { return m_devices[0]; }
+  cl_uint numDevices() const { return m_num_devices; }
+  cl_context context() const { return m_context; }
+  cl_program program() const { return m_program; }
+  const std::string &binaryFile() const { return m_binary_file; }
+
+  // Returns the in-order, profiling-enabled command queue of the first
+  // device, created on first use.
+  cl_command_queue queue();
+
+  // Returns the kernel with the given name, created on first use.
+  cl_kernel kernel(const std::string &name);
+
+  // Returns a device buffer of at least `size` bytes that is kept under `tag`
+  // across configurations. The buffer is replaced (from the pool) only if it
+  // has to grow or the flags change; `allocated` (if given) is set to whether
+  // that happened, in which case its contents are undefined.
+  cl_mem buffer(const std::string &tag, cl_mem_flags flags, size_t size, bool *allocated = NULL);
+
+  // Returns the buffers of all tags to the pool.
+  void releaseBuffers();
+
+  BufferPool &pool() { return m_pool; }
+
+  // Releases all OpenCL objects tied to the current context, including the
+  // context itself. The next loadProgram creates a new one.
+  void release();
+
+private:
+  typedef std::map<std::string, scoped_cl_kernel> KernelMap;
+  typedef std::map<std::string, BufferPool::Lease> BufferMap;
+
+  cl_platform_id             m_platform;
+  scoped_array<cl_device_id> m_devices;
+  cl_uint                    m_num_devices;
+  scoped_cl_context          m_context;
+  bool                       m_context_preloaded;  // created to reuse the resident bitstream
+  scoped_cl_program          m_program;
+  scoped_cl_command_queue    m_queue;
+  std::string                m_binary_file;
+  KernelMap                  m_kernels;
+  BufferPool                 m_pool;
+  BufferMap                  m_buffers;
+
+  // noncopyable
+  Session(const Session &);
+  Session &operator =(const Session &);
+};
+
+} // ns aocl_utils
+
+#endif
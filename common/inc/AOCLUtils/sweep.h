@@ -0,0 +1,48 @@
+// Parameter sweep specifications.
+//
+// A sweep is a list of axes, each a parameter name and a list of values:
+//
+//   datanum=4M,64M,512M; tries=20; pattern=random,sequential
+//
+// Axes are separated by ';' or newlines. Values are separated by ','. A value
+// may also be a range:
+//   lo..hi*f  geometric range (lo, lo*f, lo*f*f, ... <= hi)
+//   lo..hi+s  arithmetic range (lo, lo+s, lo+2s, ... <= hi)
+// Numbers may carry a K, M or G suffix (powers of 1024).
+//
+// The points of the sweep are the cartesian product of the axes, with the
+// first axis varying slowest.
+
+#ifndef AOCL_UTILS_SWEEP_H
+#define AOCL_UTILS_SWEEP_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace aocl_utils {
+
+typedef std::map<std::string, std::string> SweepPoint;
+
+// Parses a sweep specification and returns all of its points.
+// Exits with an error message if the specification is malformed.
+std::vector<SweepPoint> parseSweep(const std::string &spec);
+
+// Parses a number with an optional K, M or G suffix. Throws
+// std::invalid_argument if the value is not a number, is negative, or does
+// not fit a size_t.
+unsigned long long parseCount(const std::string &value);
+
+// Returns the value of `name` in the point as a number, or default_value
+// if the point does not have it. Throws like parseCount.
+unsigned long long getCount(const SweepPoint &point, const std::string &name,
+                            unsigned long long default_value);
+
+// Returns the value of `name` in the point, or default_value if the point
+// does not have it.
+std::string getString(const SweepPoint &point, const std::string &name,
+                      const std::string &default_value);
+
+} // ns aocl_utils
+
+#endif
@@ -0,0 +1,75 @@
+// Timeline of the OpenCL commands of a host, in the Chrome trace format.
+//
+// With AOCL_TRACE=<file>, every command recorded here is written to <file>
+// with its QUEUED/SUBMIT/START/END profiling timestamps, for
+// chrome://tracing or https://ui.perfetto.dev. Host threads and command
+// queues are the tracks: a command is a slice from START to END on its
+// queue, linked by an arrow to the point where a host thread enqueued it,
+// so gaps between commands and across queues show up at a glance.
+//
+// Queues have to be created with traceQueueProperties() for their events to
+// carry timestamps. A command enqueued without an event takes one from
+// traceEvent(); a command whose event the host keeps is recorded with
+// traceCommand() after it is enqueued:
+//
+//   clEnqueueWriteBuffer(queue, X_buf, CL_FALSE, 0, size, X, 0, NULL, aocl_utils::traceEvent("write X"));
+//   clEnqueueNDRangeKernel(queue, kernel, 1, NULL, global, local, 0, NULL, kernel_event.out());
+//   aocl_utils::traceCommand(kernel_event, "kernel");
+//
+// A command is written, and its event released, once it has completed: the
+// trace checks for completed commands when a TraceScope ends and every few
+// hundred commands, so a long run holds only the events still in flight.
+// traceWrite() waits for the rest and closes the file at exit.
+//
+// Device timestamps are moved to the host clock by the offset between the
+// first written command and its QUEUED time. Without AOCL_TRACE all of this
+// does nothing.
+
+#ifndef AOCL_UTILS_TRACE_H
+#define AOCL_UTILS_TRACE_H
+
+#include "CL/opencl.h"
+
+namespace aocl_utils {
+
+// Whether AOCL_TRACE is set.
+bool traceEnabled();
+
+// Returns `properties`, with CL_QUEUE_PROFILING_ENABLE if tracing.
+cl_command_queue_properties traceQueueProperties(cl_command_queue_properties properties);
+
+// Names the track of a queue ("queue <n>" by default, in order of use).
+void traceQueue(cl_command_queue queue, const char *name);
+
+// Returns where the runtime should store the event of the command about to
+// be enqueued, which is then recorded as `name`; NULL if not tracing.
+cl_event *traceEvent(const char *name);
+
+// Records the command of `event` as `name`. The event is retained until the
+// command has completed and is written.
+void traceCommand(cl_event event, const char *name);
+
+// A span of host time on the track of the calling thread. Its end also
+// writes the commands that have completed.
+class TraceScope {
+public:
+  explicit TraceScope(const char *name);
+  ~TraceScope();
+
+private:
+  const char *m_name;
+  double      m_start;
+
+  // noncopyable
+  TraceScope(const TraceScope &);
+  TraceScope &operator =(const TraceScope &);
+};
+
+// Writes the rest of the trace, waiting for the recorded commands to finish,
+// and closes it. Called at exit; hosts only need it to close the trace
+// earlier.
+void traceWrite();
+
+} // ns aocl_utils
+
+#endif
@@ -0,0 +1,111 @@
+// The intercepted OpenCL entry points: each calls the runtime behind this
+// library, looked up on first use, and records the time it took.
+
+#include "CL/opencl.h"
+#include "interpose.h"
+
+#define CL_INTERPOSE(ret, name, params, args)                                   \
+  extern "C" CL_API_ENTRY ret CL_API_CALL name params {                        \
+    typedef ret (CL_API_CALL *Real) params;                                     \
+    static Real real = (Real)cl_interpose::realFunction(#name);                 \
+    if(cl_interpose::inside_call) {                                             \
+      return real args;  /* the runtime calling itself */                       \
+    }                                                                           \
+    cl_interpose::inside_call = true;                                           \
+    uint64_t start = cl_interpose::nowNs();                                     \
+    ret result = real args;                                                     \
+    cl_interpose::record(cl_interpose::FN_##name, __builtin_return_address(0),  \
+                         cl_interpose::nowNs() - start);                        \
+    cl_interpose::inside_call = false;                                          \
+    return result;                                                              \
+  }
+
+// Buffers, queues and kernels
+/********************************************************************/
+CL_INTERPOSE(cl_mem, clCreateBuffer,
+             (cl_context context, cl_mem_flags flags, size_t size, void *host_ptr, cl_int *errcode_ret),
+             (context, flags, size, host_ptr, errcode_ret))
+
+CL_INTERPOSE(cl_int, clReleaseMemObject, (cl_mem memobj), (memobj))
+
+CL_INTERPOSE(cl_command_queue, clCreateCommandQueue,
+             (cl_context context, cl_device_id device, cl_command_queue_properties properties, cl_int *errcode_ret),
+             (context, device, properties, errcode_ret))
+
+CL_INTERPOSE(cl_kernel, clCreateKernel,
+             (cl_program program, const char *kernel_name, cl_int *errcode_ret),
+             (program, kernel_name, errcode_ret))
+
+CL_INTERPOSE(cl_int, clSetKernelArg,
+             (cl_kernel kernel, cl_uint arg_index, size_t arg_size, const void *arg_value),
+             (kernel, arg_index, arg_size, arg_value))
+
+
+// Commands
+/********************************************************************/
+CL_INTERPOSE(cl_int, clEnqueueWriteBuffer,
+             (cl_command_queue queue, cl_mem buffer, cl_bool blocking, size_t offset, size_t size, const void *ptr,
+              cl_uint num_events, const cl_event *wait_list, cl_event *event),
+             (queue, buffer, blocking, offset, size, ptr, num_events, wait_list, event))
+
+CL_INTERPOSE(cl_int, clEnqueueReadBuffer,
+             (cl_command_queue queue, cl_mem buffer, cl_bool blocking, size_t offset, size_t size, void *ptr,
+              cl_uint num_events, const cl_event *wait_list, cl_event *event),
+             (queue, buffer, blocking, offset, size, ptr, num_events, wait_list, event))
+
+CL_INTERPOSE(cl_int, clEnqueueCopyBuffer,
+             (cl_command_queue queue, cl_mem src, cl_mem dst, size_t src_offset, size_t dst_offset, size_t size,
+              cl_uint num_events, const cl_event *wait_list, cl_event *event),
+             (queue, src, dst, src_offset, dst_offset, size, num_events, wait_list, event))
+
+CL_INTERPOSE(cl_int, clEnqueueFillBuffer,
+             (cl_command_queue queue, cl_mem buffer, const void *pattern, size_t pattern_size, size_t offset, size_t size,
+              cl_uint num_events, const cl_event *wait_list, cl_event *event),
+             (queue, buffer, pattern, pattern_size, offset, size, num_events, wait_list, event))
+
+CL_INTERPOSE(void *, clEnqueueMapBuffer,
+             (cl_command_queue queue, cl_mem buffer, cl_bool blocking, cl_map_flags flags, size_t offset, size_t size,
+              cl_uint num_events, const cl_event *wait_list, cl_event *event, cl_int *errcode_ret),
+             (queue, buffer, blocking, flags, offset, size, num_events, wait_list, event, errcode_ret))
+
+CL_INTERPOSE(cl_int, clEnqueueUnmapMemObject,
+             (cl_command_queue queue, cl_mem memobj, void *mapped_ptr,
+              cl_uint num_events, const cl_event *wait_list, cl_event *event),
+             (queue, memobj, mapped_ptr, num_events, wait_list, event))
+
+CL_INTERPOSE(cl_int, clEnqueueNDRangeKernel,
+             (cl_command_queue queue, cl_kernel kernel, cl_uint work_dim, const size_t *global_offset,
+              const size_t *global_size, const size_t *local_size,
+              cl_uint num_events, const cl_event *wait_list, cl_event *event),
+             (queue, kernel, work_dim, global_offset, global_size, local_size, num_events, wait_list, event))
+
+CL_INTERPOSE(cl_int, clEnqueueTask,
+             (cl_command_queue queue, cl_kernel kernel, cl_uint num_events, const cl_event *wait_list, cl_event *event),
+             (queue, kernel, num_events, wait_list, event))
+
+CL_INTERPOSE(cl_int, clEnqueueMarkerWithWaitList,
+             (cl_command_queue queue, cl_uint num_events, const cl_event *wait_list, cl_event *event),
+             (queue, num_events, wait_list, event))
+
+CL_INTERPOSE(cl_int, clEnqueueBarrierWithWaitList,
+             (cl_command_queue queue, cl_uint num_events, const cl_event *wait_list, cl_event *event),
+             (queue, num_events, wait_list, event))
+
+
+// Synchronization and events
+/********************************************************************/
+CL_INTERPOSE(cl_int, clFlush, (cl_command_queue queue), (queue))
+
+CL_INTERPOSE(cl_int, clFinish, (cl_command_queue queue), (queue))
+
+CL_INTERPOSE(cl_int, clWaitForEvents, (cl_uint num_events, const cl_event *event_list), (num_events, event_list))
+
+CL_INTERPOSE(cl_int, clGetEventInfo,
+             (cl_event event, cl_event_info param_name, size_t param_value_size, void *param_value, size_t *param_value_size_ret),
+             (event, param_name, param_value_size, param_value, param_value_size_ret))
+
+CL_INTERPOSE(cl_int, clGetEventProfilingInfo,
+             (cl_event event, cl_profiling_info param_name, size_t param_value_size, void *param_value, size_t *param_value_size_ret),
+             (event, param_name, param_value_size, param_value, param_value_size_ret))
+
+CL_INTERPOSE(cl_int, clReleaseEvent, (cl_event event), (event))
@@ -0,0 +1,235 @@
+// OpenCL API profiler: per-thread tables and the summary written at exit.
+
+#include <algorithm>
+#include <cxxabi.h>
+#include <dlfcn.h>
+#include <map>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+#include "interpose.h"
+
+namespace cl_interpose {
+
+static const char *const function_names[NUM_FUNCTIONS] = {
+#define CL_INTERPOSE_NAME(name) #name,
+  CL_INTERPOSE_FUNCTIONS(CL_INTERPOSE_NAME)
+#undef CL_INTERPOSE_NAME
+};
+
+thread_local bool inside_call = false;
+
+// Head of the list of all thread tables; tables are only ever pushed
+static std::atomic<ThreadTable *> all_tables(NULL);
+
+static ThreadTable *newTable() {
+  // Zero-initialized: every site free, every counter 0
+  ThreadTable *table = static_cast<ThreadTable *>(calloc(1, sizeof(ThreadTable)));
+  if(table == NULL) {
+    fprintf(stderr, "cl_interpose: out of memory\n");
+    exit(1);
+  }
+  table->next = all_tables.load(std::memory_order_relaxed);
+  while(!all_tables.compare_exchange_weak(table->next, table, std::memory_order_release, std::memory_order_relaxed)) {
+  }
+  return table;
+}
+
+static unsigned bucket(uint64_t ns) {
+  unsigned b = (ns == 0) ? 0 : 64 - __builtin_clzll(ns);
+  return std::min(b, NUM_BUCKETS - 1);
+}
+
+// Single writer: plain loads and stores, no read-modify-write
+static void add(std::atomic<uint64_t> &counter, uint64_t value) {
+  counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+void record(ThreadTable &table, Function function, void *call_site, uint64_t ns) {
+  uintptr_t key = (uintptr_t)call_site ^ ((uintptr_t)function << 3);
+  unsigned  i = (unsigned)((key * 0x9e3779b97f4a7c15ull) >> 32) & (ThreadTable::CAPACITY - 1);
+  for(unsigned probe = 0; probe < ThreadTable::CAPACITY; ++probe, i = (i + 1) & (ThreadTable::CAPACITY - 1)) {
+    Site &site = table.sites[i];
+    void *occupant = site.call_site.load(std::memory_order_relaxed);
+    if(occupant == NULL) {
+      site.function.store(function, std::memory_order_relaxed);
+      site.call_site.store(call_site, std::memory_order_release);
+    } else if(occupant != call_site || site.function.load(std::memory_order_relaxed) != (uint32_t)function) {
+      continue;
+    }
+    add(site.calls, 1);
+    add(site.total_ns, ns);
+    if(ns > site.max_ns.load(std::memory_order_relaxed)) {
+      site.max_ns.store(ns, std::memory_order_relaxed);
+    }
+    add(site.histogram[bucket(ns)], 1);
+    return;
+  }
+  add(table.dropped, 1);
+}
+
+void record(Function function, void *call_site, uint64_t ns) {
+  static thread_local ThreadTable *table = NULL;
+  if(table == NULL) {
+    table = newTable();
+  }
+  record(*table, function, call_site, ns);
+}
+
+void *realFunction(const char *name) {
+  void *f = dlsym(RTLD_NEXT, name);
+  if(f == NULL) {
+    fprintf(stderr, "cl_interpose: the OpenCL runtime has no %s\n", name);
+    exit(1);
+  }
+  return f;
+}
+
+
+// Summary
+/********************************************************************/
+struct SiteTotal {
+  uint32_t function;
+  void    *call_site;
+  uint64_t calls, total_ns, max_ns;
+  uint64_t histogram[NUM_BUCKETS];
+};
+
+// Upper bound of the bucket holding the given fraction of the calls, in ns
+static double percentile(const SiteTotal &s, double fraction) {
+  uint64_t target = (uint64_t)(fraction * s.calls);
+  uint64_t seen = 0;
+  for(unsigned b = 0; b < NUM_BUCKETS; ++b) {
+    seen += s.histogram[b];
+    if(seen > target) {
+      return (b == 0) ? 0 : std::min((double)(1ull << b), (double)s.max_ns);
+    }
+  }
+  return (double)s.max_ns;
+}
+
+// "symbol+0xoffset" if the call site has a dynamic symbol, else
+// "object+0xoffset" (for addr2line -e object)
+static std::string describe(void *call_site) {
+  Dl_info info;
+  char text[512];
+  if(dladdr(call_site, &info) == 0) {
+    snprintf(text, sizeof(text), "%p", call_site);
+    return text;
+  }
+  if(info.dli_sname != NULL) {
+    int   status;
+    char *demangled = abi::__cxa_demangle(info.dli_sname, NULL, NULL, &status);
+    snprintf(text, sizeof(text), "%s+0x%lx", (status == 0) ? demangled : info.dli_sname,
+             (unsigned long)((char *)call_site - (char *)info.dli_saddr));
+    free(demangled);
+    return text;
+  }
+  const char *object = (info.dli_fname != NULL && *info.dli_fname != '\0') ? info.dli_fname : "main";
+  const char *slash = strrchr(object, '/');
+  snprintf(text, sizeof(text), "%s+0x%lx", slash ? slash + 1 : object,
+           (unsigned long)((char *)call_site - (char *)info.dli_fbase));
+  return text;
+}
+
+// Cost of the timing and recording of one call, measured on a private table
+static double overheadNs() {
+  ThreadTable *table = static_cast<ThreadTable *>(calloc(1, sizeof(ThreadTable)));
+  if(table == NULL) {
+    return 0;
+  }
+  const unsigned n = 100000;
+  uint64_t start = nowNs();
+  for(unsigned i = 0; i < n; ++i) {
+    uint64_t t = nowNs();
+    record(*table, FN_clSetKernelArg, (void *)(uintptr_t)(0x1000 + (i & 7) * 16), nowNs() - t);
+  }
+  double ns = double(nowNs() - start) / n;
+  free(table);
+  return ns;
+}
+
+static bool byTotal(const SiteTotal &a, const SiteTotal &b) {
+  return a.total_ns > b.total_ns;
+}
+
+__attribute__((destructor))
+static void writeSummary() {
+  // Merge the tables of all threads by (function, call site)
+  std::map<std::pair<uint32_t, void *>, SiteTotal> merged;
+  unsigned threads = 0;
+  uint64_t dropped = 0;
+  for(ThreadTable *table = all_tables.load(std::memory_order_acquire); table != NULL; table = table->next) {
+    ++threads;
+    dropped += table->dropped.load(std::memory_order_relaxed);
+    for(unsigned i = 0; i < ThreadTable::CAPACITY; ++i) {
+      const Site &site = table->sites[i];
+      void *call_site = site.call_site.load(std::memory_order_acquire);
+      if(call_site == NULL) {
+        continue;
+      }
+      uint32_t function = site.function.load(std::memory_order_relaxed);
+      SiteTotal &total = merged[std::make_pair(function, call_site)];
+      total.function = function;
+      total.call_site = call_site;
+      total.calls += site.calls.load(std::memory_order_relaxed);
+      total.total_ns += site.total_ns.load(std::memory_order_relaxed);
+      total.max_ns = std::max(total.max_ns, site.max_ns.load(std::memory_order_relaxed));
+      for(unsigned b = 0; b < NUM_BUCKETS; ++b) {
+        total.histogram[b] += site.histogram[b].load(std::memory_order_relaxed);
+      }
+    }
+  }
+  if(threads == 0) {
+    return;
+  }
+
+  std::vector<SiteTotal> sites;
+  uint64_t function_calls[NUM_FUNCTIONS] = {0}, function_ns[NUM_FUNCTIONS] = {0};
+  for(std::map<std::pair<uint32_t, void *>, SiteTotal>::iterator it = merged.begin(); it != merged.end(); ++it) {
+    sites.push_back(it->second);
+    function_calls[it->second.function] += it->second.calls;
+    function_ns[it->second.function] += it->second.total_ns;
+  }
+  std::sort(sites.begin(), sites.end(), byTotal);
+
+  const char *out = getenv("CL_INTERPOSE_OUT");
+  FILE *f = (out != NULL && *out != '\0') ? fopen(out, "w") : NULL;
+  if(f == NULL) {
+    f = stderr;
+  }
+
+  fprintf(f, "\nOpenCL API profile (pid %d, %u thread(s), overhead ~%.0f ns per call)\n",
+          (int)getpid(), threads, overheadNs());
+  fprintf(f, "%-30s %10s %12s %10s\n", "function", "calls", "total ms", "mean us");
+  for(unsigned fn = 0; fn < NUM_FUNCTIONS; ++fn) {
+    if(function_calls[fn] != 0) {
+      fprintf(f, "%-30s %10llu %12.3f %10.3f\n", function_names[fn], (unsigned long long)function_calls[fn],
+              function_ns[fn] * 1.0e-6, function_ns[fn] * 1.0e-3 / function_calls[fn]);
+    }
+  }
+
+  fprintf(f, "\n%-30s %-36s %10s %12s %10s %10s %10s %10s\n",
+          "function", "call site", "calls", "total ms", "mean us", "p50 us", "p99 us", "max us");
+  for(size_t i = 0; i < sites.size(); ++i) {
+    const SiteTotal &s = sites[i];
+    fprintf(f, "%-30s %-36s %10llu %12.3f %10.3f %10.3f %10.3f %10.3f\n",
+            function_names[s.function], describe(s.call_site).c_str(), (unsigned long long)s.calls,
+            s.total_ns * 1.0e-6, s.total_ns * 1.0e-3 / s.calls,
+            percentile(s, 0.5) * 1.0e-3, percentile(s, 0.99) * 1.0e-3, s.max_ns * 1.0e-3);
+  }
+  if(dropped != 0) {
+    fprintf(f, "(%llu call(s) from call sites beyond %u per thread not shown)\n",
+            (unsigned long long)dropped, ThreadTable::CAPACITY);
+  }
+  if(f != stderr) {
+    fclose(f);
+  }
+}
+
+} // ns cl_interpose
@@ -0,0 +1,80 @@
+// OpenCL API profiler, loaded with LD_PRELOAD in front of the OpenCL runtime.
+//
+// Each intercepted entry point (see CL_INTERPOSE_FUNCTIONS) times the call to
+// the runtime and records it under its call site, the return address into
+// the host. Records go to a table owned by the calling thread, so recording
+// takes no locks and no atomic read-modify-write: a table has one writer,
+// and the summary written at exit only reads. Each call site keeps a count,
+// the total and maximum time and a histogram of power-of-two buckets.
+//
+// Environment:
+//   CL_INTERPOSE_OUT  file for the summary (stderr if unset)
+
+#ifndef CL_INTERPOSE_H
+#define CL_INTERPOSE_H
+
+#include <atomic>
+#include <stdint.h>
+#include <time.h>
+
+namespace cl_interpose {
+
+// The entry points intercepted, in the order of the summary
+#define CL_INTERPOSE_FUNCTIONS(X) \
+  X(clCreateBuffer) X(clReleaseMemObject) X(clCreateCommandQueue) X(clCreateKernel) \
+  X(clSetKernelArg) X(clEnqueueWriteBuffer) X(clEnqueueReadBuffer) X(clEnqueueCopyBuffer) \
+  X(clEnqueueFillBuffer) X(clEnqueueMapBuffer) X(clEnqueueUnmapMemObject) \
+  X(clEnqueueNDRangeKernel) X(clEnqueueTask) X(clEnqueueMarkerWithWaitList) \
+  X(clEnqueueBarrierWithWaitList) X(clFlush) X(clFinish) X(clWaitForEvents) \
+  X(clGetEventInfo) X(clGetEventProfilingInfo) X(clReleaseEvent)
+
+enum Function {
+#define CL_INTERPOSE_ENUM(name) FN_##name,
+  CL_INTERPOSE_FUNCTIONS(CL_INTERPOSE_ENUM)
+#undef CL_INTERPOSE_ENUM
+  NUM_FUNCTIONS
+};
+
+// Histogram bucket b counts calls of [2^(b-1), 2^b) ns; bucket 0 is 0 ns
+static const unsigned NUM_BUCKETS = 40;
+
+struct Site {
+  std::atomic<void *>   call_site;   // NULL while the slot is free
+  std::atomic<uint32_t> function;
+  std::atomic<uint64_t> calls;
+  std::atomic<uint64_t> total_ns;
+  std::atomic<uint64_t> max_ns;
+  std::atomic<uint64_t> histogram[NUM_BUCKETS];
+};
+
+// The sites of one thread, an open-addressing hash table. Tables are never
+// freed, so that the summary still sees the threads that have exited.
+struct ThreadTable {
+  static const unsigned CAPACITY = 512;  // a power of two
+
+  Site                  sites[CAPACITY];
+  std::atomic<uint64_t> dropped;  // calls from sites that did not fit
+  ThreadTable          *next;     // all tables, for the summary
+};
+
+inline uint64_t nowNs() {
+  timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return (uint64_t)t.tv_sec * 1000000000ull + (uint64_t)t.tv_nsec;
+}
+
+// Set during an intercepted call, so that calls the runtime makes to its own
+// entry points are passed through without being recorded
+extern thread_local bool inside_call;
+
+// Records a call of `function` from `call_site` that took `ns` in the table
+// of the calling thread.
+void record(Function function, void *call_site, uint64_t ns);
+void record(ThreadTable &table, Function function, void *call_site, uint64_t ns);
+
+// The entry point of the runtime behind this library; exits if there is none.
+void *realFunction(const char *name);
+
+} // ns cl_interpose
+
+#endif
@@ -0,0 +1,29 @@
+/* Mock OpenCL runtime: the parts of the Intel(R) FPGA extensions used by the
+   hosts, for Khronos headers that do not define them. */
+
+#ifndef MOCK_OCL_CL_EXT_INTELFPGA_H
+#define MOCK_OCL_CL_EXT_INTELFPGA_H
+
+#if defined(__has_include_next)
+#if __has_include_next(<CL/cl_ext_intelfpga.h>)
+#include_next <CL/cl_ext_intelfpga.h>
+#endif
+#endif
+
+/* Memory bank of a buffer (cl_mem_flags) */
+#ifndef CL_CHANNEL_1_INTELFPGA
+#define CL_CHANNEL_AUTO_INTELFPGA (0 << 16)
+#define CL_CHANNEL_1_INTELFPGA    (1 << 16)
+#define CL_CHANNEL_2_INTELFPGA    (2 << 16)
+#define CL_CHANNEL_3_INTELFPGA    (3 << 16)
+#define CL_CHANNEL_4_INTELFPGA    (4 << 16)
+#define CL_CHANNEL_5_INTELFPGA    (5 << 16)
+#define CL_CHANNEL_6_INTELFPGA    (6 << 16)
+#define CL_CHANNEL_7_INTELFPGA    (7 << 16)
+#endif
+
+#ifndef CL_MEM_HETEROGENEOUS_INTELFPGA
+#define CL_MEM_HETEROGENEOUS_INTELFPGA (1 << 19)
+#endif
+
+#endif
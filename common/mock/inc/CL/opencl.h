@@ -0,0 +1,11 @@
+/* Mock OpenCL runtime: CL/opencl.h for building the hosts without the Intel(R)
+   FPGA SDK. Includes the Khronos OpenCL headers installed on the system and adds
+   the Intel FPGA extensions used by the hosts. */
+
+#ifndef MOCK_OCL_OPENCL_H
+#define MOCK_OCL_OPENCL_H
+
+#include_next <CL/opencl.h>
+#include "CL/cl_ext_intelfpga.h"
+
+#endif
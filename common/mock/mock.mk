@@ -0,0 +1,17 @@
+# OpenCL compile and link flags of the mock OpenCL runtime, used by the host
+# Makefiles instead of `aocl compile-config` / `aocl link-config` for MOCK=1:
+#   make MOCK=1 && make MOCK=1 run_mock
+# MOCK_LIB is a prerequisite of the host so that the runtime is built first.
+
+MOCK_DIR := $(patsubst %/,%,$(dir $(lastword $(MAKEFILE_LIST))))
+MOCK_LIB := $(MOCK_DIR)/lib/libmock_opencl.so
+
+AOCL_COMPILE_CONFIG := -I$(MOCK_DIR)/inc $(if $(OCL_INC),-isystem $(OCL_INC)) \
+                       -DCL_TARGET_OPENCL_VERSION=200 -DCL_USE_DEPRECATED_OPENCL_1_2_APIS
+AOCL_LINK_CONFIG := -L$(MOCK_DIR)/lib -Wl,-rpath,$(abspath $(MOCK_DIR)/lib) -lmock_opencl -pthread
+
+# The rule below must not become the default goal of the including Makefile
+mock_default_goal := $(.DEFAULT_GOAL)
+$(MOCK_LIB) : $(wildcard $(MOCK_DIR)/src/* $(MOCK_DIR)/inc/CL/* $(MOCK_DIR)/../*/AOCLUtils/ddr_model.* $(MOCK_DIR)/../*/AOCLUtils/counter_model.*)
+	$(MAKE) -C $(MOCK_DIR)
+.DEFAULT_GOAL := $(mock_default_goal)
@@ -0,0 +1,201 @@
+// Mock OpenCL runtime: kernel-to-kernel and I/O channels.
+
+#include <errno.h>
+#include <fcntl.h>
+#include <map>
+#include <memory>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "mock_ocl.h"
+
+namespace mock_ocl {
+
+// In-process channels
+/********************************************************************/
+class Channel {
+public:
+  explicit Channel(size_t depth) : m_depth(depth) {}
+
+  void write(const void *data, size_t size) {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cond.wait(lock, [this] { return m_depth == 0 || m_elements.size() < m_depth; });
+    m_elements.push_back(std::vector<unsigned char>(bytes, bytes + size));
+    m_cond.notify_all();
+  }
+
+  void read(void *data, size_t size) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_cond.wait(lock, [this] { return !m_elements.empty(); });
+    std::vector<unsigned char> &element = m_elements.front();
+    memcpy(data, element.data(), (element.size() < size) ? element.size() : size);
+    m_elements.pop_front();
+    m_cond.notify_all();
+  }
+
+  bool tryRead(void *data, size_t size) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_elements.empty()) {
+      return false;
+    }
+    std::vector<unsigned char> &element = m_elements.front();
+    memcpy(data, element.data(), (element.size() < size) ? element.size() : size);
+    m_elements.pop_front();
+    m_cond.notify_all();
+    return true;
+  }
+
+private:
+  size_t                                  m_depth;
+  std::mutex                              m_mutex;
+  std::condition_variable                 m_cond;
+  std::deque<std::vector<unsigned char> > m_elements;
+};
+
+// The channel of that name, created with `depth` (or MOCK_OCL_CHANNEL_DEPTH
+// if that is -1) on first use
+static Channel &channel(const std::string &name, long depth = -1) {
+  static std::mutex mutex;
+  static std::map<std::string, std::unique_ptr<Channel> > channels;
+
+  std::lock_guard<std::mutex> lock(mutex);
+  std::unique_ptr<Channel> &ch = channels[name];
+  if(!ch) {
+    const char *env = getenv("MOCK_OCL_CHANNEL_DEPTH");
+    ch.reset(new Channel((depth >= 0) ? depth : (env != NULL) ? strtoul(env, NULL, 0) : 0));
+  }
+  return *ch;
+}
+
+void channelWrite(const std::string &name, const void *data, size_t size) {
+  channel(name).write(data, size);
+}
+
+void channelRead(const std::string &name, void *data, size_t size) {
+  channel(name).read(data, size);
+}
+
+bool channelTryRead(const std::string &name, void *data, size_t size) {
+  return channel(name).tryRead(data, size);
+}
+
+void channelDeclare(const std::string &name, size_t depth) {
+  channel(name, (long)depth);
+}
+
+
+// I/O channels
+/********************************************************************/
+// Returns the I/O channel of the peer board that `io_name` is cabled to.
+static std::string linkedIo(const std::string &io_name) {
+  const char *links = getenv("MOCK_OCL_IO_LINKS");
+  if(links != NULL) {
+    // "tx0:rx1,tx1:rx0"
+    std::string list = links;
+    std::string key = io_name + ":";
+    for(size_t pos = list.find(key); pos != std::string::npos; pos = list.find(key, pos + 1)) {
+      if(pos == 0 || list[pos - 1] == ',') {
+        size_t begin = pos + key.size();
+        return list.substr(begin, list.find(',', begin) - begin);
+      }
+    }
+  }
+  unsigned n = (unsigned)strtoul(io_name.c_str() + 2, NULL, 10);
+  return "rx" + std::to_string(n ^ 1);
+}
+
+static bool ringTopology() {
+  const char *topology = getenv("MOCK_OCL_TOPOLOGY");
+  return topology != NULL && strcmp(topology, "ring") == 0;
+}
+
+static unsigned numDevices() {
+  const char *devices = getenv("MOCK_OCL_DEVICES");
+  unsigned n = (devices != NULL) ? (unsigned)strtoul(devices, NULL, 0) : 1;
+  return (n > 0) ? n : 1;
+}
+
+static unsigned peerOf(unsigned device) {
+  const char *peer = getenv("MOCK_OCL_PEER");
+  if(peer != NULL) {
+    return (unsigned)strtoul(peer, NULL, 0);
+  }
+  return ringTopology() ? (device + 1) % numDevices() : (device ^ 1);
+}
+
+unsigned ioRoundTripHops() {
+  return ringTopology() ? numDevices() : 2;
+}
+
+// Returns the named pipe for an I/O channel, opened for writing or reading.
+static int ioPipe(const std::string &dir, const std::string &key, bool for_write) {
+  static std::mutex mutex;
+  static std::map<std::string, int> pipes;
+
+  std::string path = dir + "/" + key;
+  std::string name = path + (for_write ? ">" : "<");
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::map<std::string, int>::const_iterator it = pipes.find(name);
+    if(it != pipes.end()) {
+      return it->second;
+    }
+  }
+
+  if(mkfifo(path.c_str(), 0600) != 0 && errno != EEXIST) {
+    fprintf(stderr, "mock_ocl: cannot create %s\n", path.c_str());
+    exit(1);
+  }
+  // Opening for reading blocks until the other end is opened too. The writing
+  // end is opened read-write, which does not block (Linux), so that boards in
+  // a ring can all write before they read.
+  int fd = open(path.c_str(), for_write ? O_RDWR : O_RDONLY);
+  if(fd < 0) {
+    fprintf(stderr, "mock_ocl: cannot open %s\n", path.c_str());
+    exit(1);
+  }
+  std::lock_guard<std::mutex> lock(mutex);
+  pipes[name] = fd;
+  return fd;
+}
+
+static void transfer(int fd, void *data, size_t size, bool for_write) {
+  unsigned char *bytes = static_cast<unsigned char *>(data);
+  while(size > 0) {
+    ssize_t n = for_write ? ::write(fd, bytes, size) : ::read(fd, bytes, size);
+    if(n <= 0) {
+      if(n < 0 && errno == EINTR) {
+        continue;
+      }
+      fprintf(stderr, "mock_ocl: I/O channel closed\n");
+      exit(1);
+    }
+    bytes += n;
+    size -= n;
+  }
+}
+
+void ioWrite(const KernelArgs &args, const char *io_name, const void *data, size_t size) {
+  std::string key = "board" + std::to_string(peerOf(args.deviceIndex())) + "." + linkedIo(io_name);
+  const char *dir = getenv("MOCK_OCL_IO_DIR");
+  if(dir != NULL) {
+    transfer(ioPipe(dir, key, true), const_cast<void *>(data), size, true);
+  } else {
+    channelWrite(key, data, size);
+  }
+}
+
+void ioRead(const KernelArgs &args, const char *io_name, void *data, size_t size) {
+  std::string key = "board" + std::to_string(args.deviceIndex()) + "." + io_name;
+  const char *dir = getenv("MOCK_OCL_IO_DIR");
+  if(dir != NULL) {
+    transfer(ioPipe(dir, key, false), data, size, false);
+  } else {
+    channelRead(key, data, size);
+  }
+}
+
+} // ns mock_ocl
@@ -0,0 +1,571 @@
+// Mock OpenCL runtime: the kernels of this repository as C++ functions.
+//
+// Each function does what the kernel (including its HDL library functions)
+// does to memory and channels and returns the cycles the kernel takes under
+// the timing model.
+
+#include <algorithm>
+#include <map>
+#include <mutex>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+#include "mock_ocl.h"
+
+namespace mock_ocl {
+
+// Registry
+/********************************************************************/
+typedef std::map<std::pair<std::string, unsigned>, KernelFunction> KernelMap;
+
+static KernelMap &registry() {
+  // Constructed on first use, since kernels register during static initialization
+  static KernelMap kernels;
+  return kernels;
+}
+
+void registerKernel(const char *name, unsigned num_args, KernelFunction function) {
+  registry()[std::make_pair(std::string(name), num_args)] = function;
+}
+
+KernelFunction findKernel(const std::string &name, unsigned num_args) {
+  KernelMap::const_iterator it = registry().find(std::make_pair(name, num_args));
+  return (it != registry().end()) ? it->second : NULL;
+}
+
+int maxKernelArgs(const std::string &name) {
+  int num_args = -1;
+  for(KernelMap::const_iterator it = registry().begin(); it != registry().end(); ++it) {
+    if(it->first.first == name && (int)it->first.second > num_args) {
+      num_args = it->first.second;
+    }
+  }
+  return num_args;
+}
+
+std::vector<std::string> kernelNames() {
+  std::vector<std::string> names;
+  for(KernelMap::const_iterator it = registry().begin(); it != registry().end(); ++it) {
+    if(names.empty() || names.back() != it->first.first) {
+      names.push_back(it->first.first);
+    }
+  }
+  return names;
+}
+
+
+// DRAM/bandwidth/read: tb_read(Y, X, N)
+// read.v streams X[0..N) through a 512-bit port, checks X[i] == i + 1 and
+// returns the cycles it took, or 0 if a value did not match.
+/********************************************************************/
+static const cl_int ELEMS_PER_BEAT = aocl_utils::DdrModel::BEAT_BYTES / sizeof(cl_int);
+
+static cl_ulong tbReadBandwidth(const KernelArgs &args) {
+  cl_int *Y = args.buffer<cl_int>(0);
+  const cl_int *X = args.buffer<cl_int>(1);
+  cl_int N = args.scalar<cl_int>(2);
+
+  bool match = true;
+  for(cl_int i = 0; i < N; ++i) {
+    match = match && (X[i] == i + 1);
+  }
+  aocl_utils::DdrModel memory(model().ddr);
+  cl_ulong cycles = aocl_utils::predictDramReadCycles(memory, 0, 0, (N + ELEMS_PER_BEAT - 1) / ELEMS_PER_BEAT);
+  Y[0] = match ? (cl_int)cycles : 0;
+  return cycles;
+}
+MOCK_OCL_KERNEL("tb_read", 3, tbReadBandwidth);
+
+
+// DRAM/latency/read: tb_read(Y, X, I, N)
+// Loads X[I[i]] one at a time; Y[i] is the latency of the load in cycles.
+/********************************************************************/
+static cl_ulong tbReadLatency(const KernelArgs &args) {
+  cl_int *Y = args.buffer<cl_int>(0);
+  const cl_int *I = args.buffer<cl_int>(2);
+  cl_int N = args.scalar<cl_int>(3);
+
+  aocl_utils::DdrModel memory(model().ddr);
+  return aocl_utils::predictLatencyKernelCycles(memory, 0, I, N, Y);
+}
+MOCK_OCL_KERNEL("tb_read", 4, tbReadLatency);
+
+
+// DRAM/bandwidth/write: tb_write(Y, X, N) writes Y[i] = i
+/********************************************************************/
+static cl_ulong tbWrite(const KernelArgs &args) {
+  cl_int *Y = args.buffer<cl_int>(0);
+  cl_int N = args.scalar<cl_int>(2);
+
+  for(cl_int i = 0; i < N; ++i) {
+    Y[i] = i;
+  }
+  aocl_utils::DdrModel memory(model().ddr);
+  return aocl_utils::predictDramWriteCycles(memory, 0, 0, (N + ELEMS_PER_BEAT - 1) / ELEMS_PER_BEAT);
+}
+MOCK_OCL_KERNEL("tb_write", 3, tbWrite);
+
+
+// cycle_counter: tb_wait_func(expected, measured, N)
+// wait_func.v and the counter of the BSP under the counter model (CNT_*
+// variables, see AOCLUtils/counter_model.h), as cycle_counter/sim runs them.
+/********************************************************************/
+static cl_ulong tbWaitFunc(const KernelArgs &args) {
+  cl_long *expected = args.buffer<cl_long>(0);
+  cl_long *measured = args.buffer<cl_long>(1);
+  cl_long N = args.scalar<cl_long>(2);
+
+  aocl_utils::TbWaitFuncTiming t = aocl_utils::predictTbWaitFunc(model().counter, (uint64_t)N);
+  *expected = (cl_long)t.expected;
+  *measured = (cl_long)t.measured;
+  return t.kernel_cycles;
+}
+MOCK_OCL_KERNEL("tb_wait_func", 3, tbWaitFunc);
+
+
+// cycle_counter: tb_regions(result, N) and aocl_counters_collect(cycles,
+// stops, num, clear), the tagged counters of common/device/aocl_counters.h.
+// The counters of the BSP are kept per device.
+/********************************************************************/
+struct RegionCounters {
+  cl_ulong cycles[256];
+  cl_ulong stops[256];
+};
+
+static std::mutex region_mutex;
+static std::map<unsigned, RegionCounters> region_counters;
+
+static void stopRegion(unsigned device, unsigned id, cl_ulong cycles) {
+  std::lock_guard<std::mutex> lock(region_mutex);
+  RegionCounters &counters = region_counters[device];
+  counters.cycles[id & 0xff] += cycles;
+  counters.stops[id & 0xff] += 1;
+}
+
+static cl_ulong tbRegions(const KernelArgs &args) {
+  cl_long *result = args.buffer<cl_long>(0);
+  cl_long N = args.scalar<cl_long>(1);
+  cl_ulong c = model().counter_cycles;
+  // wait_func returns the cycles it took
+  cl_ulong wait_n = aocl_utils::waitFuncResult(N, model().counter.ready_delay);
+  cl_ulong wait_n4 = aocl_utils::waitFuncResult(N >> 2, model().counter.ready_delay);
+
+  cl_ulong once = wait_n + c;
+  stopRegion(args.deviceIndex(), 1, once);
+  cl_long sum = (cl_long)wait_n;
+  cl_ulong loop = 0;
+  for(int i = 0; i < 4; ++i) {
+    stopRegion(args.deviceIndex(), 2, wait_n4 + c);
+    loop += wait_n4 + c;
+    sum += (cl_long)wait_n4;
+  }
+  cl_ulong all = once + loop + c;
+  stopRegion(args.deviceIndex(), 0, all);
+  *result = sum;
+  return all;
+}
+MOCK_OCL_KERNEL("tb_regions", 2, tbRegions);
+
+static cl_ulong aoclCountersCollect(const KernelArgs &args) {
+  cl_ulong *cycles = args.buffer<cl_ulong>(0);
+  cl_ulong *stops = args.buffer<cl_ulong>(1);
+  cl_uint num = std::min<cl_uint>(args.scalar<cl_uint>(2), 256);
+  bool clear = args.scalar<cl_uint>(3) != 0;
+
+  std::lock_guard<std::mutex> lock(region_mutex);
+  RegionCounters &counters = region_counters[args.deviceIndex()];
+  for(cl_uint i = 0; i < num; ++i) {
+    cycles[i] = counters.cycles[i];
+    stops[i] = counters.stops[i];
+    if(clear) {
+      counters.cycles[i] = counters.stops[i] = 0;
+    }
+  }
+  return 2 * (cl_ulong)num * (model().counter_cycles + 1);
+}
+MOCK_OCL_KERNEL("aocl_counters_collect", 4, aoclCountersCollect);
+
+
+// LED: led(N) writes N to the LEDs
+/********************************************************************/
+static cl_ulong led(const KernelArgs &args) {
+  if(getenv("MOCK_OCL_VERBOSE") != NULL) {
+    fprintf(stderr, "mock_ocl: LEDs of device %u set to 0x%x\n", args.deviceIndex(), args.scalar<cl_uint>(0));
+  }
+  return 1;
+}
+MOCK_OCL_KERNEL("led", 1, led);
+
+
+// hello_world(thread_id): the work-item with that id prints a message
+/********************************************************************/
+static cl_ulong helloWorld(const KernelArgs &args) {
+  cl_uint thread_id = args.scalar<cl_uint>(0);
+  if(thread_id < args.globalSize()) {
+    printf("Thread #%u: Hello from Altera's OpenCL Compiler!\n", thread_id);
+    fflush(stdout);
+  }
+  return args.globalSize();
+}
+MOCK_OCL_KERNEL("hello_world", 1, helloWorld);
+
+
+// nop and nop_arg(x)
+/********************************************************************/
+static cl_ulong nop(const KernelArgs &) {
+  return 1;
+}
+MOCK_OCL_KERNEL("nop", 0, nop);
+
+static cl_ulong nopArg(const KernelArgs &) {
+  return 1;
+}
+MOCK_OCL_KERNEL("nop_arg", 1, nopArg);
+
+
+// C_host: cl_vecadd(a, b, c, numdata)
+/********************************************************************/
+static cl_ulong clVecadd(const KernelArgs &args) {
+  const cl_uint *a = args.buffer<cl_uint>(0);
+  const cl_uint *b = args.buffer<cl_uint>(1);
+  cl_uint *c = args.buffer<cl_uint>(2);
+  cl_uint numdata = args.scalar<cl_uint>(3);
+
+  for(cl_uint i = 0; i < numdata; ++i) {
+    c[i] = a[i] + b[i];
+  }
+  // One element per cycle unless the three streams saturate memory
+  cl_ulong memory = model().burstCycles(3 * (size_t)numdata * sizeof(cl_uint));
+  return (memory > numdata) ? memory : numdata;
+}
+MOCK_OCL_KERNEL("cl_vecadd", 4, clVecadd);
+
+
+// interkernel_comm: send/recv(data, n) over channel ch0 of float8
+/********************************************************************/
+static const size_t FLOAT8_SIZE = 8 * sizeof(cl_float);
+static const size_t FLOAT16_SIZE = 16 * sizeof(cl_float);
+
+static cl_ulong sendChannel(const KernelArgs &args) {
+  const unsigned char *data = args.buffer<unsigned char>(0);
+  cl_int n = args.scalar<cl_int>(1);
+
+  for(cl_int i = 0; i < n; ++i) {
+    channelWrite("ch0", data + i * FLOAT8_SIZE, FLOAT8_SIZE);
+  }
+  return model().ddr.ctrl_cycles + n;
+}
+MOCK_OCL_KERNEL("send", 2, sendChannel);
+
+static cl_ulong recvChannel(const KernelArgs &args) {
+  unsigned char *data = args.buffer<unsigned char>(0);
+  cl_int n = args.scalar<cl_int>(1);
+
+  for(cl_int i = 0; i < n; ++i) {
+    channelRead("ch0", data + i * FLOAT8_SIZE, FLOAT8_SIZE);
+  }
+  return model().ddr.ctrl_cycles + n;
+}
+MOCK_OCL_KERNEL("recv", 2, recvChannel);
+
+
+// interkernel_comm channel sweep: send/recv_<type>_d<depth>(data, n) of
+// float<WIDTH> over a channel of that depth (depth 0 holds one element)
+/********************************************************************/
+template<unsigned WIDTH, unsigned DEPTH>
+static std::string sweepChannel() {
+  return std::string("ch_float") + ((WIDTH == 1) ? "" : std::to_string(WIDTH)) + "_d" + std::to_string(DEPTH);
+}
+
+// One value per cycle unless the memory port cannot keep up
+template<unsigned WIDTH>
+static cl_ulong sweepCycles(cl_int n) {
+  cl_ulong memory = model().burstCycles((size_t)n * WIDTH * sizeof(cl_float));
+  return model().ddr.ctrl_cycles + std::max<cl_ulong>(memory, n);
+}
+
+template<unsigned WIDTH, unsigned DEPTH>
+static cl_ulong sendSweep(const KernelArgs &args) {
+  const unsigned char *data = args.buffer<unsigned char>(0);
+  cl_int n = args.scalar<cl_int>(1);
+  std::string name = sweepChannel<WIDTH, DEPTH>();
+
+  channelDeclare(name, std::max(DEPTH, 1u));
+  for(cl_int i = 0; i < n; ++i) {
+    channelWrite(name, data + i * WIDTH * sizeof(cl_float), WIDTH * sizeof(cl_float));
+  }
+  return sweepCycles<WIDTH>(n);
+}
+
+template<unsigned WIDTH, unsigned DEPTH>
+static cl_ulong recvSweep(const KernelArgs &args) {
+  unsigned char *data = args.buffer<unsigned char>(0);
+  cl_int n = args.scalar<cl_int>(1);
+  std::string name = sweepChannel<WIDTH, DEPTH>();
+
+  channelDeclare(name, std::max(DEPTH, 1u));
+  for(cl_int i = 0; i < n; ++i) {
+    channelRead(name, data + i * WIDTH * sizeof(cl_float), WIDTH * sizeof(cl_float));
+  }
+  return sweepCycles<WIDTH>(n);
+}
+
+#define MOCK_CHANNEL_PAIR(type, width, depth)                                                       \
+  static KernelRegistrar send_##type##_d##depth##_registrar("send_" #type "_d" #depth, 2, sendSweep<width, depth>); \
+  static KernelRegistrar recv_##type##_d##depth##_registrar("recv_" #type "_d" #depth, 2, recvSweep<width, depth>)
+#define MOCK_CHANNEL_DEPTHS(type, width)                                                            \
+  MOCK_CHANNEL_PAIR(type, width, 0); MOCK_CHANNEL_PAIR(type, width, 16); MOCK_CHANNEL_PAIR(type, width, 64); \
+  MOCK_CHANNEL_PAIR(type, width, 256); MOCK_CHANNEL_PAIR(type, width, 1024)
+
+MOCK_CHANNEL_DEPTHS(float, 1);
+MOCK_CHANNEL_DEPTHS(float4, 4);
+MOCK_CHANNEL_DEPTHS(float8, 8);
+MOCK_CHANNEL_DEPTHS(float16, 16);
+
+
+// interkernel_comm fan-out and fan-in over fo<N>_ch[N] / fi<N>_ch[N] of
+// float8, depth 16: fanout_send_rr_N / fanout_send_hash_N, fanout_recv_N_k,
+// fanin_send_N_k and fanin_recv_N (data, n)
+/********************************************************************/
+static std::string fanChannel(const char *prefix, unsigned n, unsigned k) {
+  return prefix + std::to_string(n) + "_ch[" + std::to_string(k) + "]";
+}
+
+// FAN_HASH of test.cl: the worker of a value by the bits of its s0
+static unsigned fanHash(const unsigned char *value, unsigned n) {
+  cl_uint bits;
+  memcpy(&bits, value, sizeof(bits));
+  return ((cl_uint)(bits * 2654435761u) >> 16) % n;
+}
+
+template<unsigned N, bool HASH>
+static cl_ulong fanoutSend(const KernelArgs &args) {
+  const unsigned char *data = args.buffer<unsigned char>(0);
+  cl_int n = args.scalar<cl_int>(1);
+
+  for(cl_int i = 0; i < n; ++i) {
+    const unsigned char *value = data + i * FLOAT8_SIZE;
+    unsigned w = HASH ? fanHash(value, N) : i % N;
+    channelDeclare(fanChannel("fo", N, w), 16);
+    channelWrite(fanChannel("fo", N, w), value, FLOAT8_SIZE);
+  }
+  return sweepCycles<8>(n);
+}
+
+template<unsigned N, unsigned K>
+static cl_ulong fanoutRecv(const KernelArgs &args) {
+  unsigned char *data = args.buffer<unsigned char>(0);
+  cl_int n = args.scalar<cl_int>(1);
+
+  channelDeclare(fanChannel("fo", N, K), 16);
+  for(cl_int i = 0; i < n; ++i) {
+    channelRead(fanChannel("fo", N, K), data + i * FLOAT8_SIZE, FLOAT8_SIZE);
+  }
+  return sweepCycles<8>(n);
+}
+
+template<unsigned N, unsigned K>
+static cl_ulong faninSend(const KernelArgs &args) {
+  const unsigned char *data = args.buffer<unsigned char>(0);
+  cl_int n = args.scalar<cl_int>(1);
+
+  channelDeclare(fanChannel("fi", N, K), 16);
+  for(cl_int i = 0; i < n; ++i) {
+    channelWrite(fanChannel("fi", N, K), data + i * FLOAT8_SIZE, FLOAT8_SIZE);
+  }
+  return sweepCycles<8>(n);
+}
+
+// Polls the channels in turn, one per cycle, as the kernel does
+template<unsigned N>
+static cl_ulong faninRecv(const KernelArgs &args) {
+  unsigned char *data = args.buffer<unsigned char>(0);
+  cl_int n = args.scalar<cl_int>(1);
+
+  for(unsigned k = 0; k < N; ++k) {
+    channelDeclare(fanChannel("fi", N, k), 16);
+  }
+  cl_int received = 0;
+  for(unsigned c = 0; received < n; c = (c + 1) % N) {
+    if(channelTryRead(fanChannel("fi", N, c), data + received * FLOAT8_SIZE, FLOAT8_SIZE)) {
+      ++received;
+    } else if(c == N - 1) {
+      std::this_thread::yield();
+    }
+  }
+  return sweepCycles<8>(n);
+}
+
+#define MOCK_FAN_OUT_RECV(n, k) \
+  static KernelRegistrar fanout_recv_##n##_##k##_registrar("fanout_recv_" #n "_" #k, 2, fanoutRecv<n, k>)
+#define MOCK_FAN_IN_SEND(n, k) \
+  static KernelRegistrar fanin_send_##n##_##k##_registrar("fanin_send_" #n "_" #k, 2, faninSend<n, k>)
+#define MOCK_FAN(n)                                                                                 \
+  static KernelRegistrar fanout_send_rr_##n##_registrar("fanout_send_rr_" #n, 2, fanoutSend<n, false>); \
+  static KernelRegistrar fanout_send_hash_##n##_registrar("fanout_send_hash_" #n, 2, fanoutSend<n, true>); \
+  static KernelRegistrar fanin_recv_##n##_registrar("fanin_recv_" #n, 2, faninRecv<n>)
+
+MOCK_FAN(2);
+MOCK_FAN_OUT_RECV(2, 0); MOCK_FAN_OUT_RECV(2, 1);
+MOCK_FAN_IN_SEND(2, 0);  MOCK_FAN_IN_SEND(2, 1);
+MOCK_FAN(4);
+MOCK_FAN_OUT_RECV(4, 0); MOCK_FAN_OUT_RECV(4, 1); MOCK_FAN_OUT_RECV(4, 2); MOCK_FAN_OUT_RECV(4, 3);
+MOCK_FAN_IN_SEND(4, 0);  MOCK_FAN_IN_SEND(4, 1);  MOCK_FAN_IN_SEND(4, 2);  MOCK_FAN_IN_SEND(4, 3);
+MOCK_FAN(8);
+MOCK_FAN_OUT_RECV(8, 0); MOCK_FAN_OUT_RECV(8, 1); MOCK_FAN_OUT_RECV(8, 2); MOCK_FAN_OUT_RECV(8, 3);
+MOCK_FAN_OUT_RECV(8, 4); MOCK_FAN_OUT_RECV(8, 5); MOCK_FAN_OUT_RECV(8, 6); MOCK_FAN_OUT_RECV(8, 7);
+MOCK_FAN_IN_SEND(8, 0);  MOCK_FAN_IN_SEND(8, 1);  MOCK_FAN_IN_SEND(8, 2);  MOCK_FAN_IN_SEND(8, 3);
+MOCK_FAN_IN_SEND(8, 4);  MOCK_FAN_IN_SEND(8, 5);  MOCK_FAN_IN_SEND(8, 6);  MOCK_FAN_IN_SEND(8, 7);
+
+
+// interfpga_comm: send/recv(data, n, rank) of float16 over io("tx0") / io("rx1")
+/********************************************************************/
+// Words moved per I/O channel element: both ends of send/recv batch alike,
+// and a pipe then takes a few large writes instead of one per word
+static const cl_int IO_BATCH = 1024;
+
+static cl_ulong sendIo(const KernelArgs &args) {
+  const unsigned char *data = args.buffer<unsigned char>(0);
+  cl_int n = args.scalar<cl_int>(1);
+
+  for(cl_int i = 0; i < n; i += IO_BATCH) {
+    ioWrite(args, "tx0", data + i * FLOAT16_SIZE, std::min<cl_int>(IO_BATCH, n - i) * FLOAT16_SIZE);
+  }
+  return model().ddr.ctrl_cycles + model().link_cycles + model().linkCycles((size_t)n * FLOAT16_SIZE);
+}
+MOCK_OCL_KERNEL("send", 3, sendIo);
+
+static cl_ulong recvIo(const KernelArgs &args) {
+  unsigned char *data = args.buffer<unsigned char>(0);
+  cl_int n = args.scalar<cl_int>(1);
+
+  for(cl_int i = 0; i < n; i += IO_BATCH) {
+    ioRead(args, "rx1", data + i * FLOAT16_SIZE, std::min<cl_int>(IO_BATCH, n - i) * FLOAT16_SIZE);
+  }
+  return model().ddr.ctrl_cycles + model().link_cycles + model().linkCycles((size_t)n * FLOAT16_SIZE);
+}
+MOCK_OCL_KERNEL("recv", 3, recvIo);
+
+
+// interfpga_comm/pingpong.cl: ping(data, echo, words, iters, cycles) and
+// pong(words, iters) of float16 over io("tx0") / io("rx1")
+/********************************************************************/
+// A round trip: the link both ways, each message up to link_jitter cycles
+// late, and the message streamed once, as pong echoes word by word
+static cl_ulong roundTripCycles(cl_int words, std::mt19937 *jitter) {
+  const Model &m = model();
+  cl_ulong cycles = 2 * (cl_ulong)m.link_cycles + m.linkCycles((size_t)words * FLOAT16_SIZE);
+  if(jitter != NULL && m.link_jitter > 0) {
+    std::uniform_int_distribution<unsigned> late(0, m.link_jitter);
+    cycles += late(*jitter) + late(*jitter);
+  }
+  return cycles;
+}
+
+static cl_ulong ping(const KernelArgs &args) {
+  const unsigned char *data = args.buffer<unsigned char>(0);
+  unsigned char *echo = args.buffer<unsigned char>(1);
+  cl_int words = args.scalar<cl_int>(2);
+  cl_int iters = args.scalar<cl_int>(3);
+  cl_ulong *cycles = args.buffer<cl_ulong>(4);
+
+  std::mt19937 jitter(1);
+  cl_ulong total = model().ddr.ctrl_cycles;
+  for(cl_int i = 0; i < iters; ++i) {
+    for(cl_int w = 0; w < words; ++w) {
+      ioWrite(args, "tx0", data + w * FLOAT16_SIZE, FLOAT16_SIZE);
+    }
+    for(cl_int w = 0; w < words; ++w) {
+      ioRead(args, "rx1", echo + w * FLOAT16_SIZE, FLOAT16_SIZE);
+    }
+    cycles[i] = roundTripCycles(words, &jitter) + model().counter_cycles;
+    total += cycles[i] + model().counter.in_cycles + model().counter.out_cycles;
+  }
+  return total;
+}
+MOCK_OCL_KERNEL("ping", 5, ping);
+
+static cl_ulong pong(const KernelArgs &args) {
+  cl_int words = args.scalar<cl_int>(0);
+  cl_int iters = args.scalar<cl_int>(1);
+
+  unsigned char word[FLOAT16_SIZE];
+  for(cl_int i = 0; i < iters * words; ++i) {
+    ioRead(args, "rx1", word, FLOAT16_SIZE);
+    ioWrite(args, "tx0", word, FLOAT16_SIZE);
+  }
+  return model().ddr.ctrl_cycles + (cl_ulong)iters * roundTripCycles(words, NULL);
+}
+MOCK_OCL_KERNEL("pong", 2, pong);
+
+
+// interfpga_comm/ring.cl: ring(src, dst, n, origin) and allreduce.cl:
+// allreduce(data, chunk, ranks, rank), float16 over io("tx0") / io("rx1")
+// of boards cabled in a ring (MOCK_OCL_TOPOLOGY=ring)
+/********************************************************************/
+static cl_ulong ring(const KernelArgs &args) {
+  const unsigned char *src = args.buffer<unsigned char>(0);
+  unsigned char *dst = args.buffer<unsigned char>(1);
+  cl_int n = args.scalar<cl_int>(2);
+  cl_int origin = args.scalar<cl_int>(3);
+
+  if(origin) {
+    // The kernel interleaves its writes and reads; a pipe would block on either
+    std::thread writer([&] {
+      for(cl_int i = 0; i < n; ++i) {
+        ioWrite(args, "tx0", src + i * FLOAT16_SIZE, FLOAT16_SIZE);
+      }
+    });
+    for(cl_int i = 0; i < n; ++i) {
+      ioRead(args, "rx1", dst + i * FLOAT16_SIZE, FLOAT16_SIZE);
+    }
+    writer.join();
+  } else {
+    unsigned char word[FLOAT16_SIZE];
+    for(cl_int i = 0; i < n; ++i) {
+      ioRead(args, "rx1", word, FLOAT16_SIZE);
+      ioWrite(args, "tx0", word, FLOAT16_SIZE);
+    }
+  }
+  return model().ddr.ctrl_cycles + (cl_ulong)ioRoundTripHops() * model().link_cycles
+         + model().linkCycles((size_t)n * FLOAT16_SIZE);
+}
+MOCK_OCL_KERNEL("ring", 4, ring);
+
+static cl_ulong allreduce(const KernelArgs &args) {
+  cl_float *data = args.buffer<cl_float>(0);
+  cl_int chunk = args.scalar<cl_int>(1);
+  cl_int ranks = args.scalar<cl_int>(2);
+  cl_int rank = args.scalar<cl_int>(3);
+
+  const size_t words = 16;
+  cl_float v[words];
+  for(cl_int s = 0; s < ranks - 1; ++s) {
+    cl_int send = (rank - s + ranks) % ranks;
+    cl_int recv = (rank - s - 1 + ranks) % ranks;
+    for(cl_int w = 0; w < chunk; ++w) {
+      ioWrite(args, "tx0", data + (send * chunk + w) * words, FLOAT16_SIZE);
+      ioRead(args, "rx1", v, FLOAT16_SIZE);
+      for(size_t j = 0; j < words; ++j) {
+        data[(recv * chunk + w) * words + j] += v[j];
+      }
+    }
+  }
+  for(cl_int s = 0; s < ranks - 1; ++s) {
+    cl_int send = (rank + 1 - s + ranks) % ranks;
+    cl_int recv = (rank - s + ranks) % ranks;
+    for(cl_int w = 0; w < chunk; ++w) {
+      ioWrite(args, "tx0", data + (send * chunk + w) * words, FLOAT16_SIZE);
+      ioRead(args, "rx1", data + (recv * chunk + w) * words, FLOAT16_SIZE);
+    }
+  }
+  // 2 (ranks - 1) steps, each one chunk over one link
+  cl_ulong step = model().link_cycles + model().linkCycles((size_t)chunk * FLOAT16_SIZE);
+  return model().ddr.ctrl_cycles + 2 * (cl_ulong)(ranks - 1) * step;
+}
+MOCK_OCL_KERNEL("allreduce", 4, allreduce);
+
+} // ns mock_ocl
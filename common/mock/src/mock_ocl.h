@@ -0,0 +1,240 @@
+// Mock OpenCL runtime: a stand-in for the Intel(R) FPGA runtime that runs the
+// kernels of this repository as C++ functions on the host, so the hosts can be
+// built and run without an FPGA board, the SDK or the emulator.
+//
+// It implements the OpenCL entry points used by common/src/AOCLUtils and the
+// hosts (platform/device queries, contexts, in-order command queues, buffers,
+// programs from binaries, kernels, events with profiling). Any binary is
+// accepted; a program contains every kernel registered with MOCK_OCL_KERNEL.
+// Each command queue executes its commands in order on a worker thread.
+//
+// Profiling timestamps come from the timing model (see Model below) rather than
+// from the time the host CPU spent emulating a command: a transfer takes
+// latency + bytes / bandwidth, a kernel takes the launch overhead plus the
+// cycles its function reports at the modeled clock. Timestamps are on the
+// host's monotonic clock, so host-side timers and profiling info can be
+// compared. With MOCK_OCL_REALTIME=1 every command also takes its modeled
+// time in wall-clock time, so host-side pipelining can be measured.
+
+#ifndef MOCK_OCL_H
+#define MOCK_OCL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <string.h>
+
+#include "CL/opencl.h"
+#include "AOCLUtils/counter_model.h"
+#include "AOCLUtils/ddr_model.h"
+
+namespace mock_ocl {
+
+// Timing model, configured with MOCK_OCL_* environment variables; the
+// memory is the DDR model shared with the RTL simulation (DDR_* variables).
+struct Model {
+  double   fmax_mhz;              // MOCK_OCL_FMAX_MHZ: kernel clock
+  double   launch_us;             // MOCK_OCL_LAUNCH_US: overhead of a kernel launch
+  double   pcie_gbps;             // MOCK_OCL_PCIE_GBPS: host <-> device bandwidth
+  double   pcie_latency_us;       // MOCK_OCL_PCIE_LATENCY_US: overhead of a transfer
+  aocl_utils::DdrConfig ddr;      // DDR_*: one memory bank, at the kernel clock
+  aocl_utils::CounterConfig counter;  // CNT_*: wait_func and the cycle counter of the BSP
+  unsigned counter_cycles;        // MOCK_OCL_COUNTER_CYCLES: overhead of the tagged counters [that of `counter`]
+  unsigned link_cycles;           // MOCK_OCL_LINK_CYCLES: one-way latency of a board link (I/O channel)
+  unsigned link_jitter;           // MOCK_OCL_LINK_JITTER: up to that many cycles more per message, at random
+  double   link_gbps;             // MOCK_OCL_LINK_GBPS: serial rate of a board link, each way
+  bool     realtime;              // MOCK_OCL_REALTIME
+
+  Model();
+
+  cl_ulong cyclesToNs(cl_ulong cycles) const;
+  cl_ulong launchNs() const;
+  cl_ulong transferNs(size_t bytes) const;
+
+  // Cycles of a burst access to `bytes` consecutive bytes of one bank
+  // through a 512-bit port (as DRAM_READ does it).
+  cl_ulong burstCycles(size_t bytes) const;
+
+  // Cycles to stream `bytes` over a board link, at most one float16 word
+  // per cycle and at most link_gbps.
+  cl_ulong linkCycles(size_t bytes) const;
+};
+const Model &model();
+
+// Arguments of a kernel launch.
+class KernelArgs {
+public:
+  KernelArgs(cl_device_id device, size_t global_size, const std::vector<std::vector<unsigned char> > &values)
+    : m_device(device), m_global_size(global_size), m_values(values) {}
+
+  size_t count() const { return m_values.size(); }
+  cl_device_id device() const { return m_device; }
+  unsigned deviceIndex() const;
+
+  // Number of work-items (1 for the single work-item kernels)
+  size_t globalSize() const { return m_global_size; }
+
+  // Scalar argument; a value set with a smaller size is zero-extended.
+  template<typename T>
+  T scalar(unsigned i) const {
+    T value = T();
+    memcpy(&value, m_values[i].data(), m_values[i].size() < sizeof(T) ? m_values[i].size() : sizeof(T));
+    return value;
+  }
+
+  // Contents of a buffer argument.
+  template<typename T>
+  T *buffer(unsigned i) const { return static_cast<T *>(bufferData(i)); }
+  size_t bufferSize(unsigned i) const;
+
+private:
+  void *bufferData(unsigned i) const;
+
+  cl_device_id                                    m_device;
+  size_t                                          m_global_size;
+  const std::vector<std::vector<unsigned char> > &m_values;
+};
+
+// A kernel function runs all work-items of a launch to completion and returns
+// the number of cycles the launch takes on the FPGA under the timing model.
+typedef cl_ulong (*KernelFunction)(const KernelArgs &args);
+
+// Kernels are looked up by name and number of arguments, so one name can
+// stand for the different kernels of different binaries (e.g. tb_read).
+void registerKernel(const char *name, unsigned num_args, KernelFunction function);
+KernelFunction findKernel(const std::string &name, unsigned num_args);
+int maxKernelArgs(const std::string &name);  // -1 if the name is unknown
+std::vector<std::string> kernelNames();
+
+struct KernelRegistrar {
+  KernelRegistrar(const char *name, unsigned num_args, KernelFunction function) {
+    registerKernel(name, num_args, function);
+  }
+};
+#define MOCK_OCL_KERNEL(name, num_args, function) \
+  static mock_ocl::KernelRegistrar function##_registrar(name, num_args, function)
+
+// Channels between kernels. Elements are written and read whole.
+// Kernel-to-kernel channels live in the process; their depth is
+// MOCK_OCL_CHANNEL_DEPTH elements (0, the default, for unbounded) unless
+// the kernels declare it before the first write or read. channelTryRead
+// is read_channel_nb_intel: false, without waiting, if the channel is empty.
+void channelWrite(const std::string &name, const void *data, size_t size);
+void channelRead(const std::string &name, void *data, size_t size);
+bool channelTryRead(const std::string &name, void *data, size_t size);
+void channelDeclare(const std::string &name, size_t depth);
+
+// I/O channels of the board (io("txN") / io("rxN")). Writing "txN" of a
+// device delivers to "rx(N^1)" of its peer, device index ^ 1 (override the
+// peer with MOCK_OCL_PEER and the pairing with MOCK_OCL_IO_LINKS, e.g.
+// "tx0:rx1,tx1:rx0"). With MOCK_OCL_TOPOLOGY=ring the peer is the next
+// device instead, (index + 1) % MOCK_OCL_DEVICES. Within one process they are
+// in-process channels; with MOCK_OCL_IO_DIR set they are named pipes in that
+// directory, so ranks of an MPI job on one machine can talk to each other.
+void ioWrite(const KernelArgs &args, const char *io_name, const void *data, size_t size);
+void ioRead(const KernelArgs &args, const char *io_name, void *data, size_t size);
+
+// Links a message crosses to come back to its board: 2, or the ring size.
+unsigned ioRoundTripHops();
+
+// Host monotonic clock in nanoseconds, the time base of profiling info.
+cl_ulong nowNs();
+
+} // ns mock_ocl
+
+
+// OpenCL objects
+/********************************************************************/
+struct _cl_platform_id {
+};
+
+struct _cl_device_id {
+  unsigned    index;
+  std::string name;
+  cl_ulong    global_mem_size;
+  cl_ulong    max_alloc_size;
+
+  std::mutex  mutex;
+  cl_ulong    allocated;        // bytes of live buffers
+  cl_ulong    pcie_busy_until;  // transfers share the host link
+};
+
+struct _cl_context {
+  std::atomic<int>          refs;
+  std::vector<cl_device_id> devices;
+  void (CL_CALLBACK *notify)(const char *, const void *, size_t, void *);
+  void                      *user_data;
+};
+
+struct _cl_mem {
+  std::atomic<int> refs;
+  cl_context       context;
+  cl_mem_flags     flags;
+  size_t           size;
+  unsigned char    *data;
+  bool             owns_data;
+};
+
+struct _cl_program {
+  std::atomic<int>           refs;
+  cl_context                 context;
+  std::vector<cl_device_id>  devices;
+  std::vector<unsigned char> binary;
+};
+
+struct _cl_kernel {
+  std::atomic<int>                          refs;
+  cl_program                                program;
+  std::string                               name;
+  std::vector<std::vector<unsigned char> >  args;
+  std::vector<bool>                         arg_set;
+};
+
+struct _cl_event {
+  std::atomic<int>        refs;
+  cl_context              context;
+  cl_command_queue        queue;    // NULL for user events
+  cl_command_type         type;
+  bool                    profiling;
+
+  std::mutex              mutex;
+  std::condition_variable cond;
+  cl_int                  status;
+  cl_ulong                queued, submit, start, end;
+
+  struct Callback {
+    cl_int type;
+    void (CL_CALLBACK *function)(cl_event, cl_int, void *);
+    void *user_data;
+  };
+  std::vector<Callback>   callbacks;
+};
+
+struct _cl_command_queue {
+  struct Command {
+    cl_event                     event;
+    std::vector<cl_event>        wait_list;
+    bool                         transfer;  // uses the host link
+    std::function<cl_ulong()>    run;       // does the work, returns the modeled duration (ns)
+  };
+
+  std::atomic<int>            refs;
+  cl_context                  context;
+  cl_device_id                device;
+  cl_command_queue_properties properties;
+
+  std::mutex                  mutex;
+  std::condition_variable     cond;
+  std::deque<Command>         commands;
+  size_t                      pending;     // enqueued and not complete
+  bool                        stop;
+  cl_ulong                    busy_until;  // end of the last command
+  std::thread                 worker;
+};
+
+#endif
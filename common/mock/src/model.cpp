@@ -0,0 +1,61 @@
+// Mock OpenCL runtime: timing model.
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "mock_ocl.h"
+
+namespace mock_ocl {
+
+static double envDouble(const char *name, double default_value) {
+  const char *value = getenv(name);
+  return (value != NULL && *value != '\0') ? strtod(value, NULL) : default_value;
+}
+
+// The defaults are rough figures for an Arria 10 board with one DDR4 bank per
+// kernel port (see DdrConfig) and a PCIe Gen3 x8 host link.
+Model::Model()
+  : fmax_mhz(envDouble("MOCK_OCL_FMAX_MHZ", 285.0)),
+    launch_us(envDouble("MOCK_OCL_LAUNCH_US", 20.0)),
+    pcie_gbps(envDouble("MOCK_OCL_PCIE_GBPS", 6.0)),
+    pcie_latency_us(envDouble("MOCK_OCL_PCIE_LATENCY_US", 10.0)),
+    ddr(aocl_utils::DdrConfig::fromEnv(fmax_mhz)),
+    counter(aocl_utils::CounterConfig::fromEnv()),
+    counter_cycles((unsigned)envDouble("MOCK_OCL_COUNTER_CYCLES", counter.overheadCycles())),
+    link_cycles((unsigned)envDouble("MOCK_OCL_LINK_CYCLES", 160)),
+    link_jitter((unsigned)envDouble("MOCK_OCL_LINK_JITTER", 16)),
+    link_gbps(envDouble("MOCK_OCL_LINK_GBPS", 40.0)),
+    realtime(envDouble("MOCK_OCL_REALTIME", 0) != 0) {
+}
+
+const Model &model() {
+  static const Model the_model;
+  return the_model;
+}
+
+cl_ulong Model::cyclesToNs(cl_ulong cycles) const {
+  return (cl_ulong)llround(cycles * 1.0e3 / fmax_mhz);
+}
+
+cl_ulong Model::launchNs() const {
+  return (cl_ulong)llround(launch_us * 1.0e3);
+}
+
+cl_ulong Model::transferNs(size_t bytes) const {
+  // 1 GB/s is one byte per ns
+  return (cl_ulong)llround(pcie_latency_us * 1.0e3 + bytes / pcie_gbps);
+}
+
+cl_ulong Model::burstCycles(size_t bytes) const {
+  aocl_utils::DdrModel memory(ddr);
+  uint64_t beats = (bytes + aocl_utils::DdrModel::BEAT_BYTES - 1) / aocl_utils::DdrModel::BEAT_BYTES;
+  return aocl_utils::predictDramReadCycles(memory, 0, 0, beats);
+}
+
+cl_ulong Model::linkCycles(size_t bytes) const {
+  cl_ulong words = (bytes + 63) / 64;
+  cl_ulong serial = (cl_ulong)ceil(bytes * 8 / link_gbps * fmax_mhz * 1.0e-3);
+  return (serial > words) ? serial : words;
+}
+
+} // ns mock_ocl
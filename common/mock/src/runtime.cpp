@@ -0,0 +1,1366 @@
+// Mock OpenCL runtime: the OpenCL entry points.
+
+#include <algorithm>
+#include <chrono>
+#include <map>
+#include <set>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "mock_ocl.h"
+
+using namespace mock_ocl;
+
+
+// Helpers
+/********************************************************************/
+static void setError(cl_int *errcode_ret, cl_int status) {
+  if(errcode_ret != NULL) {
+    *errcode_ret = status;
+  }
+}
+
+static cl_int returnInfo(const void *value, size_t size,
+                         size_t param_value_size, void *param_value, size_t *param_value_size_ret) {
+  if(param_value != NULL) {
+    if(param_value_size < size) {
+      return CL_INVALID_VALUE;
+    }
+    memcpy(param_value, value, size);
+  }
+  if(param_value_size_ret != NULL) {
+    *param_value_size_ret = size;
+  }
+  return CL_SUCCESS;
+}
+
+#define INFO_ARGS param_value_size, param_value, param_value_size_ret
+
+template<typename T>
+static cl_int returnValue(const T &value, size_t param_value_size, void *param_value, size_t *param_value_size_ret) {
+  return returnInfo(&value, sizeof(T), INFO_ARGS);
+}
+
+static cl_int returnString(const std::string &value, size_t param_value_size, void *param_value, size_t *param_value_size_ret) {
+  return returnInfo(value.c_str(), value.size() + 1, INFO_ARGS);
+}
+
+static void *alignedAlloc(size_t size, size_t alignment) {
+  void *ptr = NULL;
+  if(posix_memalign(&ptr, std::max(alignment, sizeof(void *)), size) != 0) {
+    return NULL;
+  }
+  return ptr;
+}
+
+static unsigned envUnsigned(const char *name, unsigned default_value) {
+  const char *value = getenv(name);
+  return (value != NULL && *value != '\0') ? (unsigned)strtoul(value, NULL, 0) : default_value;
+}
+
+
+// Platform and devices
+/********************************************************************/
+static _cl_platform_id the_platform;
+
+static const char *PLATFORM_NAME = "Intel(R) FPGA SDK for OpenCL(TM) (mock)";
+static const char *VERSION       = "OpenCL 1.0 Intel(R) FPGA SDK for OpenCL(TM), Version 19.1 (mock)";
+
+static const std::vector<cl_device_id> &allDevices() {
+  // Devices live as long as the process. The board name is the part of the
+  // device name that getBoardBinaryFile uses to find an AOCX.
+  static std::vector<cl_device_id> devices;
+  static std::once_flag once;
+  std::call_once(once, [] {
+    const char *board = getenv("MOCK_OCL_BOARD");
+    if(board == NULL || *board == '\0') {
+      board = "a10pl4_dd4gb_gx115_m512";
+    }
+    cl_ulong mem_size = (cl_ulong)envUnsigned("MOCK_OCL_GLOBAL_MEM_MB", 8192) << 20;
+    unsigned count = envUnsigned("MOCK_OCL_DEVICES", 1);
+    for(unsigned i = 0; i < count; ++i) {
+      cl_device_id device = new _cl_device_id;
+      device->index = i;
+      device->name = std::string(board) + " : Mock FPGA (aclmock" + std::to_string(i) + ")";
+      device->global_mem_size = mem_size;
+      device->max_alloc_size = mem_size / 2;
+      device->allocated = 0;
+      device->pcie_busy_until = 0;
+      devices.push_back(device);
+    }
+  });
+  return devices;
+}
+
+static bool isDevice(cl_device_id device) {
+  const std::vector<cl_device_id> &devices = allDevices();
+  return device != NULL && std::find(devices.begin(), devices.end(), device) != devices.end();
+}
+
+static bool matchesType(cl_device_type device_type) {
+  return (device_type & (CL_DEVICE_TYPE_ACCELERATOR | CL_DEVICE_TYPE_DEFAULT)) != 0 || device_type == CL_DEVICE_TYPE_ALL;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clGetPlatformIDs(cl_uint num_entries, cl_platform_id *platforms, cl_uint *num_platforms) {
+  if((num_entries == 0 && platforms != NULL) || (platforms == NULL && num_platforms == NULL)) {
+    return CL_INVALID_VALUE;
+  }
+  if(platforms != NULL) {
+    platforms[0] = &the_platform;
+  }
+  if(num_platforms != NULL) {
+    *num_platforms = 1;
+  }
+  return CL_SUCCESS;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clGetPlatformInfo(cl_platform_id platform, cl_platform_info param_name,
+                  size_t param_value_size, void *param_value, size_t *param_value_size_ret) {
+  if(platform != NULL && platform != &the_platform) {
+    return CL_INVALID_PLATFORM;
+  }
+  switch(param_name) {
+    case CL_PLATFORM_PROFILE:    return returnString("EMBEDDED_PROFILE", INFO_ARGS);
+    case CL_PLATFORM_VERSION:    return returnString(VERSION, INFO_ARGS);
+    case CL_PLATFORM_NAME:       return returnString(PLATFORM_NAME, INFO_ARGS);
+    case CL_PLATFORM_VENDOR:     return returnString("Intel(R) Corporation", INFO_ARGS);
+    case CL_PLATFORM_EXTENSIONS: return returnString("cl_khr_byte_addressable_store cles_khr_int64", INFO_ARGS);
+    default:                     return CL_INVALID_VALUE;
+  }
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clGetDeviceIDs(cl_platform_id platform, cl_device_type device_type, cl_uint num_entries,
+               cl_device_id *devices, cl_uint *num_devices) {
+  if(platform != NULL && platform != &the_platform) {
+    return CL_INVALID_PLATFORM;
+  }
+  if((num_entries == 0 && devices != NULL) || (devices == NULL && num_devices == NULL)) {
+    return CL_INVALID_VALUE;
+  }
+  const std::vector<cl_device_id> &all = allDevices();
+  if(!matchesType(device_type) || all.empty()) {
+    return CL_DEVICE_NOT_FOUND;
+  }
+  for(cl_uint i = 0; devices != NULL && i < num_entries && i < all.size(); ++i) {
+    devices[i] = all[i];
+  }
+  if(num_devices != NULL) {
+    *num_devices = (cl_uint)all.size();
+  }
+  return CL_SUCCESS;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clGetDeviceInfo(cl_device_id device, cl_device_info param_name,
+                size_t param_value_size, void *param_value, size_t *param_value_size_ret) {
+  if(!isDevice(device)) {
+    return CL_INVALID_DEVICE;
+  }
+  const Model &m = model();
+  switch(param_name) {
+    case CL_DEVICE_TYPE:                         return returnValue<cl_device_type>(CL_DEVICE_TYPE_ACCELERATOR, INFO_ARGS);
+    case CL_DEVICE_VENDOR_ID:                    return returnValue<cl_uint>(0x1172, INFO_ARGS);
+    case CL_DEVICE_MAX_COMPUTE_UNITS:            return returnValue<cl_uint>(1, INFO_ARGS);
+    case CL_DEVICE_MAX_WORK_ITEM_DIMENSIONS:     return returnValue<cl_uint>(3, INFO_ARGS);
+    case CL_DEVICE_MAX_WORK_ITEM_SIZES: {
+      size_t sizes[3] = {2147483647, 2147483647, 2147483647};
+      return returnInfo(sizes, sizeof(sizes), INFO_ARGS);
+    }
+    case CL_DEVICE_MAX_WORK_GROUP_SIZE:          return returnValue<size_t>(2147483647, INFO_ARGS);
+    case CL_DEVICE_PREFERRED_VECTOR_WIDTH_CHAR:
+    case CL_DEVICE_PREFERRED_VECTOR_WIDTH_SHORT:
+    case CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT:
+    case CL_DEVICE_PREFERRED_VECTOR_WIDTH_LONG:
+    case CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT: return returnValue<cl_uint>(1, INFO_ARGS);
+    case CL_DEVICE_PREFERRED_VECTOR_WIDTH_DOUBLE:return returnValue<cl_uint>(0, INFO_ARGS);
+    case CL_DEVICE_MAX_CLOCK_FREQUENCY:          return returnValue<cl_uint>((cl_uint)m.fmax_mhz, INFO_ARGS);
+    case CL_DEVICE_ADDRESS_BITS:                 return returnValue<cl_uint>(64, INFO_ARGS);
+    case CL_DEVICE_MAX_MEM_ALLOC_SIZE:           return returnValue<cl_ulong>(device->max_alloc_size, INFO_ARGS);
+    case CL_DEVICE_IMAGE_SUPPORT:                return returnValue<cl_bool>(CL_FALSE, INFO_ARGS);
+    case CL_DEVICE_MAX_READ_IMAGE_ARGS:
+    case CL_DEVICE_MAX_WRITE_IMAGE_ARGS:         return returnValue<cl_uint>(0, INFO_ARGS);
+    case CL_DEVICE_MAX_SAMPLERS:                 return returnValue<cl_uint>(0, INFO_ARGS);
+    case CL_DEVICE_MAX_PARAMETER_SIZE:           return returnValue<size_t>(256, INFO_ARGS);
+    case CL_DEVICE_MEM_BASE_ADDR_ALIGN:          return returnValue<cl_uint>(8192, INFO_ARGS);
+    case CL_DEVICE_MIN_DATA_TYPE_ALIGN_SIZE:     return returnValue<cl_uint>(1024, INFO_ARGS);
+    case CL_DEVICE_SINGLE_FP_CONFIG:             return returnValue<cl_bitfield>(CL_FP_INF_NAN | CL_FP_ROUND_TO_NEAREST, INFO_ARGS);
+    case CL_DEVICE_GLOBAL_MEM_CACHE_TYPE:        return returnValue<cl_uint>(CL_NONE, INFO_ARGS);
+    case CL_DEVICE_GLOBAL_MEM_CACHELINE_SIZE:    return returnValue<cl_uint>(0, INFO_ARGS);
+    case CL_DEVICE_GLOBAL_MEM_CACHE_SIZE:        return returnValue<cl_ulong>(0, INFO_ARGS);
+    case CL_DEVICE_GLOBAL_MEM_SIZE:              return returnValue<cl_ulong>(device->global_mem_size, INFO_ARGS);
+    case CL_DEVICE_MAX_CONSTANT_BUFFER_SIZE:     return returnValue<cl_ulong>(16384, INFO_ARGS);
+    case CL_DEVICE_MAX_CONSTANT_ARGS:            return returnValue<cl_uint>(8, INFO_ARGS);
+    case CL_DEVICE_LOCAL_MEM_TYPE:               return returnValue<cl_uint>(CL_GLOBAL, INFO_ARGS);
+    case CL_DEVICE_LOCAL_MEM_SIZE:               return returnValue<cl_ulong>(16384, INFO_ARGS);
+    case CL_DEVICE_ERROR_CORRECTION_SUPPORT:     return returnValue<cl_bool>(CL_FALSE, INFO_ARGS);
+    case CL_DEVICE_HOST_UNIFIED_MEMORY:          return returnValue<cl_bool>(CL_FALSE, INFO_ARGS);
+    case CL_DEVICE_PROFILING_TIMER_RESOLUTION:   return returnValue<size_t>(1, INFO_ARGS);
+    case CL_DEVICE_ENDIAN_LITTLE:
+    case CL_DEVICE_AVAILABLE:                    return returnValue<cl_bool>(CL_TRUE, INFO_ARGS);
+    case CL_DEVICE_COMPILER_AVAILABLE:
+    case CL_DEVICE_LINKER_AVAILABLE:             return returnValue<cl_bool>(CL_FALSE, INFO_ARGS);
+    case CL_DEVICE_EXECUTION_CAPABILITIES:       return returnValue<cl_bitfield>(CL_EXEC_KERNEL, INFO_ARGS);
+    case CL_DEVICE_QUEUE_PROPERTIES:             return returnValue<cl_command_queue_properties>(CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE | CL_QUEUE_PROFILING_ENABLE, INFO_ARGS);
+    case CL_DEVICE_PLATFORM:                     return returnValue<cl_platform_id>(&the_platform, INFO_ARGS);
+    case CL_DEVICE_NAME:                         return returnString(device->name, INFO_ARGS);
+    case CL_DEVICE_VENDOR:                       return returnString("Intel(R) Corporation", INFO_ARGS);
+    case CL_DRIVER_VERSION:                      return returnString("19.1 (mock)", INFO_ARGS);
+    case CL_DEVICE_PROFILE:                      return returnString("EMBEDDED_PROFILE", INFO_ARGS);
+    case CL_DEVICE_VERSION:                      return returnString(VERSION, INFO_ARGS);
+    case CL_DEVICE_OPENCL_C_VERSION:             return returnString("OpenCL C 1.0", INFO_ARGS);
+    case CL_DEVICE_EXTENSIONS:                   return returnString("cl_khr_byte_addressable_store cles_khr_int64", INFO_ARGS);
+    case CL_DEVICE_BUILT_IN_KERNELS:             return returnString("", INFO_ARGS);
+    case CL_DEVICE_PRINTF_BUFFER_SIZE:           return returnValue<size_t>(65536, INFO_ARGS);
+    case CL_DEVICE_PARENT_DEVICE:                return returnValue<cl_device_id>(NULL, INFO_ARGS);
+    case CL_DEVICE_REFERENCE_COUNT:              return returnValue<cl_uint>(1, INFO_ARGS);
+    case CL_DEVICE_SVM_CAPABILITIES:             return returnValue<cl_bitfield>(0, INFO_ARGS);
+    default:                                     return CL_INVALID_VALUE;
+  }
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clRetainDevice(cl_device_id device) {
+  return isDevice(device) ? CL_SUCCESS : CL_INVALID_DEVICE;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clReleaseDevice(cl_device_id device) {
+  return isDevice(device) ? CL_SUCCESS : CL_INVALID_DEVICE;
+}
+
+
+// Contexts
+/********************************************************************/
+CL_API_ENTRY cl_context CL_API_CALL
+clCreateContext(const cl_context_properties *properties, cl_uint num_devices, const cl_device_id *devices,
+                void (CL_CALLBACK *pfn_notify)(const char *, const void *, size_t, void *),
+                void *user_data, cl_int *errcode_ret) {
+  (void)properties;  // only CL_CONTEXT_PLATFORM, and there is one platform
+  if(num_devices == 0 || devices == NULL || (pfn_notify == NULL && user_data != NULL)) {
+    setError(errcode_ret, CL_INVALID_VALUE);
+    return NULL;
+  }
+  for(cl_uint i = 0; i < num_devices; ++i) {
+    if(!isDevice(devices[i])) {
+      setError(errcode_ret, CL_INVALID_DEVICE);
+      return NULL;
+    }
+  }
+
+  cl_context context = new _cl_context;
+  context->refs = 1;
+  context->devices.assign(devices, devices + num_devices);
+  context->notify = pfn_notify;
+  context->user_data = user_data;
+  setError(errcode_ret, CL_SUCCESS);
+  return context;
+}
+
+CL_API_ENTRY cl_context CL_API_CALL
+clCreateContextFromType(const cl_context_properties *properties, cl_device_type device_type,
+                        void (CL_CALLBACK *pfn_notify)(const char *, const void *, size_t, void *),
+                        void *user_data, cl_int *errcode_ret) {
+  const std::vector<cl_device_id> &devices = allDevices();
+  if(!matchesType(device_type) || devices.empty()) {
+    setError(errcode_ret, CL_DEVICE_NOT_FOUND);
+    return NULL;
+  }
+  return clCreateContext(properties, (cl_uint)devices.size(), devices.data(), pfn_notify, user_data, errcode_ret);
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clRetainContext(cl_context context) {
+  if(context == NULL) {
+    return CL_INVALID_CONTEXT;
+  }
+  ++context->refs;
+  return CL_SUCCESS;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clReleaseContext(cl_context context) {
+  if(context == NULL) {
+    return CL_INVALID_CONTEXT;
+  }
+  if(--context->refs == 0) {
+    delete context;
+  }
+  return CL_SUCCESS;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clGetContextInfo(cl_context context, cl_context_info param_name,
+                 size_t param_value_size, void *param_value, size_t *param_value_size_ret) {
+  if(context == NULL) {
+    return CL_INVALID_CONTEXT;
+  }
+  switch(param_name) {
+    case CL_CONTEXT_REFERENCE_COUNT: return returnValue<cl_uint>(context->refs, INFO_ARGS);
+    case CL_CONTEXT_NUM_DEVICES:     return returnValue<cl_uint>((cl_uint)context->devices.size(), INFO_ARGS);
+    case CL_CONTEXT_DEVICES:         return returnInfo(context->devices.data(), context->devices.size() * sizeof(cl_device_id), INFO_ARGS);
+    case CL_CONTEXT_PROPERTIES:      return returnInfo(NULL, 0, INFO_ARGS);
+    default:                         return CL_INVALID_VALUE;
+  }
+}
+
+
+// Events
+/********************************************************************/
+static cl_event newEvent(cl_context context, cl_command_queue queue, cl_command_type type) {
+  // Events do not hold references to their queue or context, so that the
+  // worker of a queue never releases the queue itself.
+  cl_event event = new _cl_event;
+  event->refs = 1;
+  event->context = context;
+  event->queue = queue;
+  event->type = type;
+  event->profiling = (queue != NULL && (queue->properties & CL_QUEUE_PROFILING_ENABLE) != 0);
+  event->status = CL_SUBMITTED;
+  event->queued = event->submit = nowNs();
+  event->start = event->end = 0;
+  return event;
+}
+
+static void setStatus(cl_event event, cl_int status) {
+  std::vector<_cl_event::Callback> ready, waiting;
+  {
+    std::lock_guard<std::mutex> lock(event->mutex);
+    event->status = status;
+    for(size_t i = 0; i < event->callbacks.size(); ++i) {
+      (status <= event->callbacks[i].type ? ready : waiting).push_back(event->callbacks[i]);
+    }
+    event->callbacks.swap(waiting);
+  }
+  event->cond.notify_all();
+  for(size_t i = 0; i < ready.size(); ++i) {
+    ready[i].function(event, status, ready[i].user_data);
+  }
+}
+
+static cl_int waitEvent(cl_event event) {
+  std::unique_lock<std::mutex> lock(event->mutex);
+  event->cond.wait(lock, [event] { return event->status <= CL_COMPLETE; });
+  return event->status;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clRetainEvent(cl_event event) {
+  if(event == NULL) {
+    return CL_INVALID_EVENT;
+  }
+  ++event->refs;
+  return CL_SUCCESS;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clReleaseEvent(cl_event event) {
+  if(event == NULL) {
+    return CL_INVALID_EVENT;
+  }
+  if(--event->refs == 0) {
+    delete event;
+  }
+  return CL_SUCCESS;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clWaitForEvents(cl_uint num_events, const cl_event *event_list) {
+  if(num_events == 0 || event_list == NULL) {
+    return CL_INVALID_VALUE;
+  }
+  cl_int status = CL_SUCCESS;
+  for(cl_uint i = 0; i < num_events; ++i) {
+    if(event_list[i] == NULL) {
+      return CL_INVALID_EVENT;
+    }
+    if(waitEvent(event_list[i]) < 0) {
+      status = CL_EXEC_STATUS_ERROR_FOR_EVENTS_IN_WAIT_LIST;
+    }
+  }
+  return status;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clGetEventInfo(cl_event event, cl_event_info param_name,
+               size_t param_value_size, void *param_value, size_t *param_value_size_ret) {
+  if(event == NULL) {
+    return CL_INVALID_EVENT;
+  }
+  switch(param_name) {
+    case CL_EVENT_COMMAND_QUEUE:  return returnValue<cl_command_queue>(event->queue, INFO_ARGS);
+    case CL_EVENT_CONTEXT:        return returnValue<cl_context>(event->context, INFO_ARGS);
+    case CL_EVENT_COMMAND_TYPE:   return returnValue<cl_command_type>(event->type, INFO_ARGS);
+    case CL_EVENT_REFERENCE_COUNT:return returnValue<cl_uint>(event->refs, INFO_ARGS);
+    case CL_EVENT_COMMAND_EXECUTION_STATUS: {
+      std::lock_guard<std::mutex> lock(event->mutex);
+      return returnValue<cl_int>(event->status, INFO_ARGS);
+    }
+    default:                      return CL_INVALID_VALUE;
+  }
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clGetEventProfilingInfo(cl_event event, cl_profiling_info param_name,
+                        size_t param_value_size, void *param_value, size_t *param_value_size_ret) {
+  if(event == NULL) {
+    return CL_INVALID_EVENT;
+  }
+  // As in the real runtime: only for commands of a profiling queue that have completed.
+  {
+    std::lock_guard<std::mutex> lock(event->mutex);
+    if(!event->profiling || event->status != CL_COMPLETE) {
+      return CL_PROFILING_INFO_NOT_AVAILABLE;
+    }
+  }
+  switch(param_name) {
+    case CL_PROFILING_COMMAND_QUEUED:   return returnValue<cl_ulong>(event->queued, INFO_ARGS);
+    case CL_PROFILING_COMMAND_SUBMIT:   return returnValue<cl_ulong>(event->submit, INFO_ARGS);
+    case CL_PROFILING_COMMAND_START:    return returnValue<cl_ulong>(event->start, INFO_ARGS);
+    case CL_PROFILING_COMMAND_END:
+    case CL_PROFILING_COMMAND_COMPLETE: return returnValue<cl_ulong>(event->end, INFO_ARGS);
+    default:                            return CL_INVALID_VALUE;
+  }
+}
+
+CL_API_ENTRY cl_event CL_API_CALL
+clCreateUserEvent(cl_context context, cl_int *errcode_ret) {
+  if(context == NULL) {
+    setError(errcode_ret, CL_INVALID_CONTEXT);
+    return NULL;
+  }
+  setError(errcode_ret, CL_SUCCESS);
+  return newEvent(context, NULL, CL_COMMAND_USER);
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clSetUserEventStatus(cl_event event, cl_int execution_status) {
+  if(event == NULL || event->type != CL_COMMAND_USER) {
+    return CL_INVALID_EVENT;
+  }
+  if(execution_status > CL_COMPLETE) {
+    return CL_INVALID_VALUE;
+  }
+  {
+    std::lock_guard<std::mutex> lock(event->mutex);
+    if(event->status <= CL_COMPLETE) {
+      return CL_INVALID_OPERATION;
+    }
+  }
+  event->start = event->end = nowNs();
+  setStatus(event, execution_status);
+  return CL_SUCCESS;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clSetEventCallback(cl_event event, cl_int command_exec_callback_type,
+                   void (CL_CALLBACK *pfn_notify)(cl_event, cl_int, void *), void *user_data) {
+  if(event == NULL) {
+    return CL_INVALID_EVENT;
+  }
+  if(pfn_notify == NULL || (command_exec_callback_type != CL_COMPLETE &&
+                            command_exec_callback_type != CL_RUNNING &&
+                            command_exec_callback_type != CL_SUBMITTED)) {
+    return CL_INVALID_VALUE;
+  }
+  cl_int status;
+  {
+    std::lock_guard<std::mutex> lock(event->mutex);
+    status = event->status;
+    if(status > command_exec_callback_type) {
+      _cl_event::Callback callback = {command_exec_callback_type, pfn_notify, user_data};
+      event->callbacks.push_back(callback);
+      return CL_SUCCESS;
+    }
+  }
+  // The state has been reached already
+  pfn_notify(event, status, user_data);
+  return CL_SUCCESS;
+}
+
+
+// Command queues
+/********************************************************************/
+static void runQueue(cl_command_queue queue) {
+  const Model &m = model();
+  for(;;) {
+    _cl_command_queue::Command command;
+    {
+      std::unique_lock<std::mutex> lock(queue->mutex);
+      queue->cond.wait(lock, [queue] { return queue->stop || !queue->commands.empty(); });
+      if(queue->commands.empty()) {
+        return;
+      }
+      command = std::move(queue->commands.front());
+      queue->commands.pop_front();
+    }
+
+    // A command starts when it has been submitted, the previous command of
+    // the queue has finished and the commands it waits for have finished.
+    cl_event event = command.event;
+    cl_int status = CL_COMPLETE;
+    cl_ulong start = std::max(event->submit, queue->busy_until);
+    for(size_t i = 0; i < command.wait_list.size(); ++i) {
+      if(waitEvent(command.wait_list[i]) < 0) {
+        status = CL_EXEC_STATUS_ERROR_FOR_EVENTS_IN_WAIT_LIST;
+      }
+      start = std::max(start, command.wait_list[i]->end);
+      clReleaseEvent(command.wait_list[i]);
+    }
+    if(m.realtime) {
+      start = std::max(start, nowNs());
+    }
+
+    setStatus(event, CL_RUNNING);
+    cl_ulong duration = (status == CL_COMPLETE) ? command.run() : 0;
+    if(command.transfer) {
+      // Transfers of all queues of a device share its host link
+      std::lock_guard<std::mutex> lock(queue->device->mutex);
+      start = std::max(start, queue->device->pcie_busy_until);
+      queue->device->pcie_busy_until = start + duration;
+    }
+    cl_ulong end = start + duration;
+    if(m.realtime) {
+      cl_ulong now = nowNs();
+      if(end > now) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(end - now));
+      }
+      end = std::max(end, nowNs());
+    }
+
+    queue->busy_until = end;
+    event->start = start;
+    event->end = end;
+    setStatus(event, status);
+    clReleaseEvent(event);
+
+    {
+      std::lock_guard<std::mutex> lock(queue->mutex);
+      --queue->pending;
+    }
+    queue->cond.notify_all();
+  }
+}
+
+CL_API_ENTRY cl_command_queue CL_API_CALL
+clCreateCommandQueue(cl_context context, cl_device_id device, cl_command_queue_properties properties, cl_int *errcode_ret) {
+  if(context == NULL) {
+    setError(errcode_ret, CL_INVALID_CONTEXT);
+    return NULL;
+  }
+  if(std::find(context->devices.begin(), context->devices.end(), device) == context->devices.end()) {
+    setError(errcode_ret, CL_INVALID_DEVICE);
+    return NULL;
+  }
+  // Out-of-order queues are accepted and run in order
+  if((properties & ~(cl_command_queue_properties)(CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE | CL_QUEUE_PROFILING_ENABLE)) != 0) {
+    setError(errcode_ret, CL_INVALID_QUEUE_PROPERTIES);
+    return NULL;
+  }
+
+  cl_command_queue queue = new _cl_command_queue;
+  queue->refs = 1;
+  queue->context = context;
+  queue->device = device;
+  queue->properties = properties;
+  queue->pending = 0;
+  queue->stop = false;
+  queue->busy_until = 0;
+  queue->worker = std::thread(runQueue, queue);
+  clRetainContext(context);
+  setError(errcode_ret, CL_SUCCESS);
+  return queue;
+}
+
+CL_API_ENTRY cl_command_queue CL_API_CALL
+clCreateCommandQueueWithProperties(cl_context context, cl_device_id device, const cl_queue_properties *properties, cl_int *errcode_ret) {
+  cl_command_queue_properties queue_properties = 0;
+  for(const cl_queue_properties *p = properties; p != NULL && p[0] != 0; p += 2) {
+    if(p[0] == CL_QUEUE_PROPERTIES) {
+      queue_properties = (cl_command_queue_properties)p[1];
+    }
+  }
+  return clCreateCommandQueue(context, device, queue_properties, errcode_ret);
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clRetainCommandQueue(cl_command_queue queue) {
+  if(queue == NULL) {
+    return CL_INVALID_COMMAND_QUEUE;
+  }
+  ++queue->refs;
+  return CL_SUCCESS;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clReleaseCommandQueue(cl_command_queue queue) {
+  if(queue == NULL) {
+    return CL_INVALID_COMMAND_QUEUE;
+  }
+  if(--queue->refs == 0) {
+    // The worker finishes the enqueued commands first
+    {
+      std::lock_guard<std::mutex> lock(queue->mutex);
+      queue->stop = true;
+    }
+    queue->cond.notify_all();
+    queue->worker.join();
+    clReleaseContext(queue->context);
+    delete queue;
+  }
+  return CL_SUCCESS;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clGetCommandQueueInfo(cl_command_queue queue, cl_command_queue_info param_name,
+                      size_t param_value_size, void *param_value, size_t *param_value_size_ret) {
+  if(queue == NULL) {
+    return CL_INVALID_COMMAND_QUEUE;
+  }
+  switch(param_name) {
+    case CL_QUEUE_CONTEXT:         return returnValue<cl_context>(queue->context, INFO_ARGS);
+    case CL_QUEUE_DEVICE:          return returnValue<cl_device_id>(queue->device, INFO_ARGS);
+    case CL_QUEUE_REFERENCE_COUNT: return returnValue<cl_uint>(queue->refs, INFO_ARGS);
+    case CL_QUEUE_PROPERTIES:      return returnValue<cl_command_queue_properties>(queue->properties, INFO_ARGS);
+    default:                       return CL_INVALID_VALUE;
+  }
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clFlush(cl_command_queue queue) {
+  // Commands are submitted as they are enqueued
+  return (queue == NULL) ? CL_INVALID_COMMAND_QUEUE : CL_SUCCESS;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clFinish(cl_command_queue queue) {
+  if(queue == NULL) {
+    return CL_INVALID_COMMAND_QUEUE;
+  }
+  std::unique_lock<std::mutex> lock(queue->mutex);
+  queue->cond.wait(lock, [queue] { return queue->pending == 0; });
+  return CL_SUCCESS;
+}
+
+// Adds a command to the queue. `run` is called by the worker of the queue
+// and returns the modeled duration in ns.
+static cl_int enqueue(cl_command_queue queue, cl_command_type type,
+                      cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event,
+                      bool blocking, bool transfer, const std::function<cl_ulong()> &run) {
+  if((num_events_in_wait_list == 0) != (event_wait_list == NULL)) {
+    return CL_INVALID_EVENT_WAIT_LIST;
+  }
+  for(cl_uint i = 0; i < num_events_in_wait_list; ++i) {
+    if(event_wait_list[i] == NULL) {
+      return CL_INVALID_EVENT_WAIT_LIST;
+    }
+  }
+
+  _cl_command_queue::Command command;
+  command.event = newEvent(queue->context, queue, type);
+  command.transfer = transfer;
+  command.run = run;
+  for(cl_uint i = 0; i < num_events_in_wait_list; ++i) {
+    clRetainEvent(event_wait_list[i]);
+    command.wait_list.push_back(event_wait_list[i]);
+  }
+
+  cl_event e = command.event;
+  clRetainEvent(e);  // for the caller, released below if not wanted
+  {
+    std::lock_guard<std::mutex> lock(queue->mutex);
+    queue->commands.push_back(std::move(command));
+    ++queue->pending;
+  }
+  queue->cond.notify_all();
+
+  cl_int status = CL_SUCCESS;
+  if(blocking && waitEvent(e) < 0) {
+    status = CL_EXEC_STATUS_ERROR_FOR_EVENTS_IN_WAIT_LIST;
+  }
+  if(event != NULL) {
+    *event = e;
+  } else {
+    clReleaseEvent(e);
+  }
+  return status;
+}
+
+
+// Buffers
+/********************************************************************/
+// Live buffers, to find the buffer arguments of a kernel launch
+static std::mutex buffers_mutex;
+static std::set<cl_mem> buffers;
+
+static bool isBuffer(cl_mem mem) {
+  std::lock_guard<std::mutex> lock(buffers_mutex);
+  return buffers.count(mem) != 0;
+}
+
+CL_API_ENTRY cl_mem CL_API_CALL
+clCreateBuffer(cl_context context, cl_mem_flags flags, size_t size, void *host_ptr, cl_int *errcode_ret) {
+  if(context == NULL) {
+    setError(errcode_ret, CL_INVALID_CONTEXT);
+    return NULL;
+  }
+  bool use_host_ptr = (flags & CL_MEM_USE_HOST_PTR) != 0;
+  bool copy_host_ptr = (flags & CL_MEM_COPY_HOST_PTR) != 0;
+  if((host_ptr != NULL) != (use_host_ptr || copy_host_ptr)) {
+    setError(errcode_ret, CL_INVALID_HOST_PTR);
+    return NULL;
+  }
+  // Buffers are allocated in the first device of the context
+  cl_device_id device = context->devices[0];
+  if(size == 0 || size > device->max_alloc_size) {
+    setError(errcode_ret, CL_INVALID_BUFFER_SIZE);
+    return NULL;
+  }
+  {
+    std::lock_guard<std::mutex> lock(device->mutex);
+    if(device->allocated + size > device->global_mem_size) {
+      setError(errcode_ret, CL_MEM_OBJECT_ALLOCATION_FAILURE);
+      return NULL;
+    }
+    device->allocated += size;
+  }
+
+  unsigned char *data = use_host_ptr ? static_cast<unsigned char *>(host_ptr)
+                                     : static_cast<unsigned char *>(alignedAlloc(size, 64));
+  if(data == NULL) {
+    std::lock_guard<std::mutex> lock(device->mutex);
+    device->allocated -= size;
+    setError(errcode_ret, CL_OUT_OF_HOST_MEMORY);
+    return NULL;
+  }
+  if(copy_host_ptr) {
+    memcpy(data, host_ptr, size);
+  }
+
+  cl_mem mem = new _cl_mem;
+  mem->refs = 1;
+  mem->context = context;
+  mem->flags = flags;
+  mem->size = size;
+  mem->data = data;
+  mem->owns_data = !use_host_ptr;
+  clRetainContext(context);
+  {
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    buffers.insert(mem);
+  }
+  setError(errcode_ret, CL_SUCCESS);
+  return mem;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clRetainMemObject(cl_mem mem) {
+  if(mem == NULL) {
+    return CL_INVALID_MEM_OBJECT;
+  }
+  ++mem->refs;
+  return CL_SUCCESS;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clReleaseMemObject(cl_mem mem) {
+  if(mem == NULL) {
+    return CL_INVALID_MEM_OBJECT;
+  }
+  if(--mem->refs == 0) {
+    {
+      std::lock_guard<std::mutex> lock(buffers_mutex);
+      buffers.erase(mem);
+    }
+    cl_device_id device = mem->context->devices[0];
+    {
+      std::lock_guard<std::mutex> lock(device->mutex);
+      device->allocated -= mem->size;
+    }
+    if(mem->owns_data) {
+      free(mem->data);
+    }
+    clReleaseContext(mem->context);
+    delete mem;
+  }
+  return CL_SUCCESS;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clGetMemObjectInfo(cl_mem mem, cl_mem_info param_name,
+                   size_t param_value_size, void *param_value, size_t *param_value_size_ret) {
+  if(mem == NULL) {
+    return CL_INVALID_MEM_OBJECT;
+  }
+  switch(param_name) {
+    case CL_MEM_TYPE:            return returnValue<cl_mem_object_type>(CL_MEM_OBJECT_BUFFER, INFO_ARGS);
+    case CL_MEM_FLAGS:           return returnValue<cl_mem_flags>(mem->flags, INFO_ARGS);
+    case CL_MEM_SIZE:            return returnValue<size_t>(mem->size, INFO_ARGS);
+    case CL_MEM_HOST_PTR:        return returnValue<void *>(mem->owns_data ? NULL : mem->data, INFO_ARGS);
+    case CL_MEM_MAP_COUNT:       return returnValue<cl_uint>(0, INFO_ARGS);
+    case CL_MEM_REFERENCE_COUNT: return returnValue<cl_uint>(mem->refs, INFO_ARGS);
+    case CL_MEM_CONTEXT:         return returnValue<cl_context>(mem->context, INFO_ARGS);
+    case CL_MEM_OFFSET:          return returnValue<size_t>(0, INFO_ARGS);
+    default:                     return CL_INVALID_VALUE;
+  }
+}
+
+CL_API_ENTRY void * CL_API_CALL
+clSVMAlloc(cl_context context, cl_svm_mem_flags flags, size_t size, cl_uint alignment) {
+  (void)flags;
+  if(context == NULL || size == 0) {
+    return NULL;
+  }
+  return alignedAlloc(size, std::max<size_t>(alignment, 64));
+}
+
+CL_API_ENTRY void CL_API_CALL
+clSVMFree(cl_context context, void *svm_pointer) {
+  (void)context;
+  free(svm_pointer);
+}
+
+
+// Transfers
+/********************************************************************/
+static bool inRange(cl_mem mem, size_t offset, size_t size) {
+  return offset <= mem->size && size <= mem->size - offset;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clEnqueueReadBuffer(cl_command_queue queue, cl_mem buffer, cl_bool blocking_read, size_t offset, size_t size, void *ptr,
+                    cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event) {
+  if(queue == NULL) {
+    return CL_INVALID_COMMAND_QUEUE;
+  }
+  if(buffer == NULL) {
+    return CL_INVALID_MEM_OBJECT;
+  }
+  if(ptr == NULL || !inRange(buffer, offset, size)) {
+    return CL_INVALID_VALUE;
+  }
+  clRetainMemObject(buffer);
+  return enqueue(queue, CL_COMMAND_READ_BUFFER, num_events_in_wait_list, event_wait_list, event, blocking_read, true,
+                 [=] {
+                   memcpy(ptr, buffer->data + offset, size);
+                   clReleaseMemObject(buffer);
+                   return model().transferNs(size);
+                 });
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clEnqueueWriteBuffer(cl_command_queue queue, cl_mem buffer, cl_bool blocking_write, size_t offset, size_t size, const void *ptr,
+                     cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event) {
+  if(queue == NULL) {
+    return CL_INVALID_COMMAND_QUEUE;
+  }
+  if(buffer == NULL) {
+    return CL_INVALID_MEM_OBJECT;
+  }
+  if(ptr == NULL || !inRange(buffer, offset, size)) {
+    return CL_INVALID_VALUE;
+  }
+  clRetainMemObject(buffer);
+  return enqueue(queue, CL_COMMAND_WRITE_BUFFER, num_events_in_wait_list, event_wait_list, event, blocking_write, true,
+                 [=] {
+                   memcpy(buffer->data + offset, ptr, size);
+                   clReleaseMemObject(buffer);
+                   return model().transferNs(size);
+                 });
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clEnqueueCopyBuffer(cl_command_queue queue, cl_mem src_buffer, cl_mem dst_buffer,
+                    size_t src_offset, size_t dst_offset, size_t size,
+                    cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event) {
+  if(queue == NULL) {
+    return CL_INVALID_COMMAND_QUEUE;
+  }
+  if(src_buffer == NULL || dst_buffer == NULL) {
+    return CL_INVALID_MEM_OBJECT;
+  }
+  if(size == 0 || !inRange(src_buffer, src_offset, size) || !inRange(dst_buffer, dst_offset, size)) {
+    return CL_INVALID_VALUE;
+  }
+  clRetainMemObject(src_buffer);
+  clRetainMemObject(dst_buffer);
+  return enqueue(queue, CL_COMMAND_COPY_BUFFER, num_events_in_wait_list, event_wait_list, event, false, false,
+                 [=] {
+                   memmove(dst_buffer->data + dst_offset, src_buffer->data + src_offset, size);
+                   clReleaseMemObject(src_buffer);
+                   clReleaseMemObject(dst_buffer);
+                   // read and write through the same memory
+                   return model().cyclesToNs(2 * model().burstCycles(size));
+                 });
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clEnqueueFillBuffer(cl_command_queue queue, cl_mem buffer, const void *pattern, size_t pattern_size,
+                    size_t offset, size_t size,
+                    cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event) {
+  if(queue == NULL) {
+    return CL_INVALID_COMMAND_QUEUE;
+  }
+  if(buffer == NULL) {
+    return CL_INVALID_MEM_OBJECT;
+  }
+  if(pattern == NULL || pattern_size == 0 || offset % pattern_size != 0 || size % pattern_size != 0 ||
+     !inRange(buffer, offset, size)) {
+    return CL_INVALID_VALUE;
+  }
+  std::vector<unsigned char> value(static_cast<const unsigned char *>(pattern),
+                                   static_cast<const unsigned char *>(pattern) + pattern_size);
+  clRetainMemObject(buffer);
+  return enqueue(queue, CL_COMMAND_FILL_BUFFER, num_events_in_wait_list, event_wait_list, event, false, false,
+                 [=] {
+                   for(size_t i = 0; i < size; i += value.size()) {
+                     memcpy(buffer->data + offset + i, value.data(), value.size());
+                   }
+                   clReleaseMemObject(buffer);
+                   return model().cyclesToNs(model().burstCycles(size));
+                 });
+}
+
+CL_API_ENTRY void * CL_API_CALL
+clEnqueueMapBuffer(cl_command_queue queue, cl_mem buffer, cl_bool blocking_map, cl_map_flags map_flags,
+                   size_t offset, size_t size,
+                   cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event, cl_int *errcode_ret) {
+  if(queue == NULL) {
+    setError(errcode_ret, CL_INVALID_COMMAND_QUEUE);
+    return NULL;
+  }
+  if(buffer == NULL) {
+    setError(errcode_ret, CL_INVALID_MEM_OBJECT);
+    return NULL;
+  }
+  if(size == 0 || !inRange(buffer, offset, size)) {
+    setError(errcode_ret, CL_INVALID_VALUE);
+    return NULL;
+  }
+  // The contents of a buffer are host memory, so mapping is zero-copy; the
+  // time is that of the transfer a real device does for a read mapping.
+  size_t bytes = (map_flags & CL_MAP_READ) ? size : 0;
+  cl_int status = enqueue(queue, CL_COMMAND_MAP_BUFFER, num_events_in_wait_list, event_wait_list, event, blocking_map, true,
+                          [=] { return model().transferNs(bytes); });
+  setError(errcode_ret, status);
+  return (status == CL_SUCCESS) ? buffer->data + offset : NULL;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clEnqueueUnmapMemObject(cl_command_queue queue, cl_mem memobj, void *mapped_ptr,
+                        cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event) {
+  if(queue == NULL) {
+    return CL_INVALID_COMMAND_QUEUE;
+  }
+  if(memobj == NULL) {
+    return CL_INVALID_MEM_OBJECT;
+  }
+  unsigned char *ptr = static_cast<unsigned char *>(mapped_ptr);
+  if(ptr < memobj->data || ptr >= memobj->data + memobj->size) {
+    return CL_INVALID_VALUE;
+  }
+  // Charged as writing back the mapped part
+  size_t bytes = memobj->size - (ptr - memobj->data);
+  return enqueue(queue, CL_COMMAND_UNMAP_MEM_OBJECT, num_events_in_wait_list, event_wait_list, event, false, true,
+                 [=] { return model().transferNs(bytes); });
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clEnqueueMarkerWithWaitList(cl_command_queue queue,
+                            cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event) {
+  if(queue == NULL) {
+    return CL_INVALID_COMMAND_QUEUE;
+  }
+  return enqueue(queue, CL_COMMAND_MARKER, num_events_in_wait_list, event_wait_list, event, false, false,
+                 [] { return (cl_ulong)0; });
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clEnqueueBarrierWithWaitList(cl_command_queue queue,
+                             cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event) {
+  if(queue == NULL) {
+    return CL_INVALID_COMMAND_QUEUE;
+  }
+  return enqueue(queue, CL_COMMAND_BARRIER, num_events_in_wait_list, event_wait_list, event, false, false,
+                 [] { return (cl_ulong)0; });
+}
+
+
+// Programs
+/********************************************************************/
+CL_API_ENTRY cl_program CL_API_CALL
+clCreateProgramWithBinary(cl_context context, cl_uint num_devices, const cl_device_id *device_list,
+                          const size_t *lengths, const unsigned char **binaries,
+                          cl_int *binary_status, cl_int *errcode_ret) {
+  if(context == NULL) {
+    setError(errcode_ret, CL_INVALID_CONTEXT);
+    return NULL;
+  }
+  if(num_devices == 0 || device_list == NULL || lengths == NULL || binaries == NULL) {
+    setError(errcode_ret, CL_INVALID_VALUE);
+    return NULL;
+  }
+  for(cl_uint i = 0; i < num_devices; ++i) {
+    if(std::find(context->devices.begin(), context->devices.end(), device_list[i]) == context->devices.end()) {
+      setError(errcode_ret, CL_INVALID_DEVICE);
+      return NULL;
+    }
+    if(lengths[i] == 0 || binaries[i] == NULL) {
+      setError(errcode_ret, CL_INVALID_VALUE);
+      return NULL;
+    }
+  }
+
+  // Any binary will do: every registered kernel is in every program.
+  cl_program program = new _cl_program;
+  program->refs = 1;
+  program->context = context;
+  program->devices.assign(device_list, device_list + num_devices);
+  program->binary.assign(binaries[0], binaries[0] + lengths[0]);
+  clRetainContext(context);
+  for(cl_uint i = 0; binary_status != NULL && i < num_devices; ++i) {
+    binary_status[i] = CL_SUCCESS;
+  }
+  setError(errcode_ret, CL_SUCCESS);
+  return program;
+}
+
+CL_API_ENTRY cl_program CL_API_CALL
+clCreateProgramWithSource(cl_context context, cl_uint count, const char **strings, const size_t *lengths, cl_int *errcode_ret) {
+  (void)count; (void)strings; (void)lengths;
+  // Like the FPGA runtime, there is no online compiler.
+  setError(errcode_ret, (context == NULL) ? CL_INVALID_CONTEXT : CL_INVALID_OPERATION);
+  return NULL;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clBuildProgram(cl_program program, cl_uint num_devices, const cl_device_id *device_list, const char *options,
+               void (CL_CALLBACK *pfn_notify)(cl_program, void *), void *user_data) {
+  (void)num_devices; (void)device_list; (void)options;
+  if(program == NULL) {
+    return CL_INVALID_PROGRAM;
+  }
+  if(pfn_notify != NULL) {
+    pfn_notify(program, user_data);
+  }
+  return CL_SUCCESS;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clRetainProgram(cl_program program) {
+  if(program == NULL) {
+    return CL_INVALID_PROGRAM;
+  }
+  ++program->refs;
+  return CL_SUCCESS;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clReleaseProgram(cl_program program) {
+  if(program == NULL) {
+    return CL_INVALID_PROGRAM;
+  }
+  if(--program->refs == 0) {
+    clReleaseContext(program->context);
+    delete program;
+  }
+  return CL_SUCCESS;
+}
+
+static std::string kernelNameList() {
+  std::vector<std::string> names = kernelNames();
+  std::string list;
+  for(size_t i = 0; i < names.size(); ++i) {
+    list += (i == 0 ? "" : ";") + names[i];
+  }
+  return list;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clGetProgramInfo(cl_program program, cl_program_info param_name,
+                 size_t param_value_size, void *param_value, size_t *param_value_size_ret) {
+  if(program == NULL) {
+    return CL_INVALID_PROGRAM;
+  }
+  size_t num_devices = program->devices.size();
+  switch(param_name) {
+    case CL_PROGRAM_REFERENCE_COUNT: return returnValue<cl_uint>(program->refs, INFO_ARGS);
+    case CL_PROGRAM_CONTEXT:         return returnValue<cl_context>(program->context, INFO_ARGS);
+    case CL_PROGRAM_NUM_DEVICES:     return returnValue<cl_uint>((cl_uint)num_devices, INFO_ARGS);
+    case CL_PROGRAM_DEVICES:         return returnInfo(program->devices.data(), num_devices * sizeof(cl_device_id), INFO_ARGS);
+    case CL_PROGRAM_SOURCE:          return returnString("", INFO_ARGS);
+    case CL_PROGRAM_BINARY_SIZES: {
+      std::vector<size_t> sizes(num_devices, program->binary.size());
+      return returnInfo(sizes.data(), num_devices * sizeof(size_t), INFO_ARGS);
+    }
+    case CL_PROGRAM_BINARIES: {
+      // param_value is an array of buffers allocated by the caller
+      if(param_value != NULL) {
+        if(param_value_size < num_devices * sizeof(unsigned char *)) {
+          return CL_INVALID_VALUE;
+        }
+        unsigned char **binaries = static_cast<unsigned char **>(param_value);
+        for(size_t i = 0; i < num_devices; ++i) {
+          if(binaries[i] != NULL) {
+            memcpy(binaries[i], program->binary.data(), program->binary.size());
+          }
+        }
+      }
+      if(param_value_size_ret != NULL) {
+        *param_value_size_ret = num_devices * sizeof(unsigned char *);
+      }
+      return CL_SUCCESS;
+    }
+    case CL_PROGRAM_NUM_KERNELS:     return returnValue<size_t>(kernelNames().size(), INFO_ARGS);
+    case CL_PROGRAM_KERNEL_NAMES:    return returnString(kernelNameList(), INFO_ARGS);
+    default:                         return CL_INVALID_VALUE;
+  }
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clGetProgramBuildInfo(cl_program program, cl_device_id device, cl_program_build_info param_name,
+                      size_t param_value_size, void *param_value, size_t *param_value_size_ret) {
+  if(program == NULL) {
+    return CL_INVALID_PROGRAM;
+  }
+  if(std::find(program->devices.begin(), program->devices.end(), device) == program->devices.end()) {
+    return CL_INVALID_DEVICE;
+  }
+  switch(param_name) {
+    case CL_PROGRAM_BUILD_STATUS:  return returnValue<cl_build_status>(CL_BUILD_SUCCESS, INFO_ARGS);
+    case CL_PROGRAM_BUILD_OPTIONS: return returnString("", INFO_ARGS);
+    case CL_PROGRAM_BUILD_LOG:     return returnString("", INFO_ARGS);
+    case CL_PROGRAM_BINARY_TYPE:   return returnValue<cl_uint>(CL_PROGRAM_BINARY_TYPE_EXECUTABLE, INFO_ARGS);
+    default:                       return CL_INVALID_VALUE;
+  }
+}
+
+
+// Kernels
+/********************************************************************/
+CL_API_ENTRY cl_kernel CL_API_CALL
+clCreateKernel(cl_program program, const char *kernel_name, cl_int *errcode_ret) {
+  if(program == NULL) {
+    setError(errcode_ret, CL_INVALID_PROGRAM);
+    return NULL;
+  }
+  if(kernel_name == NULL) {
+    setError(errcode_ret, CL_INVALID_VALUE);
+    return NULL;
+  }
+  int num_args = maxKernelArgs(kernel_name);
+  if(num_args < 0) {
+    setError(errcode_ret, CL_INVALID_KERNEL_NAME);
+    return NULL;
+  }
+
+  cl_kernel kernel = new _cl_kernel;
+  kernel->refs = 1;
+  kernel->program = program;
+  kernel->name = kernel_name;
+  kernel->args.resize(num_args);
+  kernel->arg_set.resize(num_args, false);
+  clRetainProgram(program);
+  setError(errcode_ret, CL_SUCCESS);
+  return kernel;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clCreateKernelsInProgram(cl_program program, cl_uint num_kernels, cl_kernel *kernels, cl_uint *num_kernels_ret) {
+  if(program == NULL) {
+    return CL_INVALID_PROGRAM;
+  }
+  std::vector<std::string> names = kernelNames();
+  if(kernels != NULL && num_kernels < names.size()) {
+    return CL_INVALID_VALUE;
+  }
+  for(size_t i = 0; kernels != NULL && i < names.size(); ++i) {
+    kernels[i] = clCreateKernel(program, names[i].c_str(), NULL);
+  }
+  if(num_kernels_ret != NULL) {
+    *num_kernels_ret = (cl_uint)names.size();
+  }
+  return CL_SUCCESS;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clRetainKernel(cl_kernel kernel) {
+  if(kernel == NULL) {
+    return CL_INVALID_KERNEL;
+  }
+  ++kernel->refs;
+  return CL_SUCCESS;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clReleaseKernel(cl_kernel kernel) {
+  if(kernel == NULL) {
+    return CL_INVALID_KERNEL;
+  }
+  if(--kernel->refs == 0) {
+    clReleaseProgram(kernel->program);
+    delete kernel;
+  }
+  return CL_SUCCESS;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clSetKernelArg(cl_kernel kernel, cl_uint arg_index, size_t arg_size, const void *arg_value) {
+  if(kernel == NULL) {
+    return CL_INVALID_KERNEL;
+  }
+  if(arg_index >= kernel->args.size()) {
+    return CL_INVALID_ARG_INDEX;
+  }
+  if(arg_size == 0) {
+    return CL_INVALID_ARG_SIZE;
+  }
+  // A NULL value is a __local argument, which takes no data
+  std::vector<unsigned char> &value = kernel->args[arg_index];
+  if(arg_value != NULL) {
+    value.assign(static_cast<const unsigned char *>(arg_value), static_cast<const unsigned char *>(arg_value) + arg_size);
+  } else {
+    value.clear();
+  }
+  kernel->arg_set[arg_index] = true;
+  return CL_SUCCESS;
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clGetKernelInfo(cl_kernel kernel, cl_kernel_info param_name,
+                size_t param_value_size, void *param_value, size_t *param_value_size_ret) {
+  if(kernel == NULL) {
+    return CL_INVALID_KERNEL;
+  }
+  switch(param_name) {
+    case CL_KERNEL_FUNCTION_NAME:   return returnString(kernel->name, INFO_ARGS);
+    case CL_KERNEL_NUM_ARGS:        return returnValue<cl_uint>((cl_uint)kernel->args.size(), INFO_ARGS);
+    case CL_KERNEL_REFERENCE_COUNT: return returnValue<cl_uint>(kernel->refs, INFO_ARGS);
+    case CL_KERNEL_CONTEXT:         return returnValue<cl_context>(kernel->program->context, INFO_ARGS);
+    case CL_KERNEL_PROGRAM:         return returnValue<cl_program>(kernel->program, INFO_ARGS);
+    case CL_KERNEL_ATTRIBUTES:      return returnString("", INFO_ARGS);
+    default:                        return CL_INVALID_VALUE;
+  }
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clGetKernelWorkGroupInfo(cl_kernel kernel, cl_device_id device, cl_kernel_work_group_info param_name,
+                         size_t param_value_size, void *param_value, size_t *param_value_size_ret) {
+  (void)device;
+  if(kernel == NULL) {
+    return CL_INVALID_KERNEL;
+  }
+  switch(param_name) {
+    case CL_KERNEL_WORK_GROUP_SIZE:                    return returnValue<size_t>(1, INFO_ARGS);
+    case CL_KERNEL_COMPILE_WORK_GROUP_SIZE: {
+      size_t sizes[3] = {1, 1, 1};
+      return returnInfo(sizes, sizeof(sizes), INFO_ARGS);
+    }
+    case CL_KERNEL_PREFERRED_WORK_GROUP_SIZE_MULTIPLE: return returnValue<size_t>(1, INFO_ARGS);
+    case CL_KERNEL_LOCAL_MEM_SIZE:
+    case CL_KERNEL_PRIVATE_MEM_SIZE:                   return returnValue<cl_ulong>(0, INFO_ARGS);
+    default:                                           return CL_INVALID_VALUE;
+  }
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clEnqueueNDRangeKernel(cl_command_queue queue, cl_kernel kernel, cl_uint work_dim,
+                       const size_t *global_work_offset, const size_t *global_work_size, const size_t *local_work_size,
+                       cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event) {
+  (void)global_work_offset; (void)local_work_size;
+  if(queue == NULL) {
+    return CL_INVALID_COMMAND_QUEUE;
+  }
+  if(kernel == NULL) {
+    return CL_INVALID_KERNEL;
+  }
+  if(work_dim < 1 || work_dim > 3) {
+    return CL_INVALID_WORK_DIMENSION;
+  }
+  if(global_work_size == NULL) {
+    return CL_INVALID_GLOBAL_WORK_SIZE;
+  }
+
+  // The variant of a name is chosen by the number of arguments set.
+  unsigned num_args = 0;
+  while(num_args < kernel->arg_set.size() && kernel->arg_set[num_args]) {
+    ++num_args;
+  }
+  KernelFunction function = findKernel(kernel->name, num_args);
+  if(function == NULL) {
+    return CL_INVALID_KERNEL_ARGS;
+  }
+
+  // Arguments are captured at enqueue time; buffers are kept alive until the kernel has run.
+  std::vector<std::vector<unsigned char> > values(kernel->args.begin(), kernel->args.begin() + num_args);
+  std::vector<cl_mem> mems;
+  for(size_t i = 0; i < values.size(); ++i) {
+    cl_mem mem = NULL;
+    if(values[i].size() == sizeof(cl_mem)) {
+      memcpy(&mem, values[i].data(), sizeof(cl_mem));
+      if(mem != NULL && isBuffer(mem)) {
+        clRetainMemObject(mem);
+        mems.push_back(mem);
+      }
+    }
+  }
+
+  size_t global_size = 1;
+  for(cl_uint d = 0; d < work_dim; ++d) {
+    global_size *= global_work_size[d];
+  }
+  cl_device_id device = queue->device;
+  return enqueue(queue, CL_COMMAND_NDRANGE_KERNEL, num_events_in_wait_list, event_wait_list, event, false, false,
+                 [=] {
+                   cl_ulong cycles = function(KernelArgs(device, global_size, values));
+                   for(size_t i = 0; i < mems.size(); ++i) {
+                     clReleaseMemObject(mems[i]);
+                   }
+                   return model().launchNs() + model().cyclesToNs(cycles);
+                 });
+}
+
+CL_API_ENTRY cl_int CL_API_CALL
+clEnqueueTask(cl_command_queue queue, cl_kernel kernel,
+              cl_uint num_events_in_wait_list, const cl_event *event_wait_list, cl_event *event) {
+  const size_t size = 1;
+  return clEnqueueNDRangeKernel(queue, kernel, 1, NULL, &size, &size, num_events_in_wait_list, event_wait_list, event);
+}
+
+CL_API_ENTRY void * CL_API_CALL
+clGetExtensionFunctionAddressForPlatform(cl_platform_id platform, const char *func_name) {
+  (void)platform; (void)func_name;
+  return NULL;
+}
+
+
+namespace mock_ocl {
+
+unsigned KernelArgs::deviceIndex() const {
+  return m_device->index;
+}
+
+void *KernelArgs::bufferData(unsigned i) const {
+  cl_mem mem = NULL;
+  if(i < m_values.size() && m_values[i].size() == sizeof(cl_mem)) {
+    memcpy(&mem, m_values[i].data(), sizeof(cl_mem));
+  }
+  return (mem != NULL) ? mem->data : NULL;
+}
+
+size_t KernelArgs::bufferSize(unsigned i) const {
+  cl_mem mem = NULL;
+  if(i < m_values.size() && m_values[i].size() == sizeof(cl_mem)) {
+    memcpy(&mem, m_values[i].data(), sizeof(cl_mem));
+  }
+  return (mem != NULL) ? mem->size : 0;
+}
+
+cl_ulong nowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // ns mock_ocl
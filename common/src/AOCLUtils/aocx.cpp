@@ -0,0 +1,256 @@
+// AOCX introspection: the ELF section table and the .acl.* metadata.
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "AOCLUtils/aocx.h"
+
+namespace aocl_utils {
+
+// Metadata sections larger than this are not read
+static const uint64_t MAX_METADATA_BYTES = 64 << 20;
+
+static uint64_t readLe(const unsigned char *p, unsigned bytes) {
+  uint64_t v = 0;
+  for(unsigned i = 0; i < bytes; ++i) {
+    v |= (uint64_t)p[i] << (8 * i);
+  }
+  return v;
+}
+
+static bool readAt(FILE *f, uint64_t offset, void *data, size_t size) {
+  return fseeko(f, (off_t)offset, SEEK_SET) == 0 && fread(data, 1, size, f) == size;
+}
+
+static bool fail(std::string *error, const std::string &reason) {
+  if(error != NULL) {
+    *error = reason;
+  }
+  return false;
+}
+
+// Without trailing NULs and white space
+static std::string trim(const std::string &s) {
+  size_t end = s.size();
+  while(end > 0 && (s[end - 1] == '\0' || isspace((unsigned char)s[end - 1]))) {
+    --end;
+  }
+  size_t begin = 0;
+  while(begin < end && isspace((unsigned char)s[begin])) {
+    ++begin;
+  }
+  return s.substr(begin, end - begin);
+}
+
+static std::string readSection(FILE *f, const AocxSection &section) {
+  if(section.size > MAX_METADATA_BYTES) {
+    return "";
+  }
+  std::string data((size_t)section.size, '\0');
+  if(!data.empty() && !readAt(f, section.offset, &data[0], data.size())) {
+    return "";
+  }
+  return data;
+}
+
+static const AocxSection *findSection(const AocxInfo &info, const std::string &name) {
+  for(size_t i = 0; i < info.sections.size(); ++i) {
+    if(info.sections[i].name == name) {
+      return &info.sections[i];
+    }
+  }
+  return NULL;
+}
+
+// The number after the first `key` in `text`, or 0
+static double numberAfter(const std::string &text, const char *key) {
+  size_t pos = text.find(key);
+  return (pos == std::string::npos) ? 0 : strtod(text.c_str() + pos + strlen(key), NULL);
+}
+
+static bool isIdentifier(char c) {
+  return isalnum((unsigned char)c) || c == '_';
+}
+
+// <kernel name="..."> elements of .acl.kernel_arg_info.xml
+static void kernelsFromXml(const std::string &xml, std::vector<std::string> &kernels) {
+  const char *key = "<kernel name=\"";
+  for(size_t pos = xml.find(key); pos != std::string::npos; pos = xml.find(key, pos)) {
+    pos += strlen(key);
+    size_t end = xml.find('"', pos);
+    if(end == std::string::npos) {
+      break;
+    }
+    kernels.push_back(xml.substr(pos, end - pos));
+  }
+}
+
+// "[__]kernel void <name>" in the OpenCL source
+static void kernelsFromSource(const std::string &source, std::vector<std::string> &kernels) {
+  for(size_t pos = source.find("kernel"); pos != std::string::npos; pos = source.find("kernel", pos + 1)) {
+    size_t before = pos;
+    if(before >= 2 && source.compare(before - 2, 2, "__") == 0) {
+      before -= 2;
+    }
+    if(before > 0 && isIdentifier(source[before - 1])) {
+      continue;
+    }
+    size_t p = pos + strlen("kernel");
+    if(p >= source.size() || !isspace((unsigned char)source[p])) {
+      continue;
+    }
+    while(p < source.size() && isspace((unsigned char)source[p])) ++p;
+    if(source.compare(p, 4, "void") != 0 || p + 4 >= source.size() || !isspace((unsigned char)source[p + 4])) {
+      continue;
+    }
+    p += 4;
+    while(p < source.size() && isspace((unsigned char)source[p])) ++p;
+    size_t end = p;
+    while(end < source.size() && isIdentifier(source[end])) ++end;
+    if(end > p) {
+      kernels.push_back(source.substr(p, end - p));
+    }
+  }
+}
+
+
+// Reading
+/********************************************************************/
+bool readAocx(const char *file, AocxInfo *info, std::string *error) {
+  *info = AocxInfo();
+  info->fmax_mhz = 0;
+
+  FILE *f = fopen(file, "rb");
+  if(f == NULL) {
+    return fail(error, std::string("cannot open ") + file);
+  }
+  unsigned char header[64];
+  size_t got = fread(header, 1, sizeof(header), f);
+  if(got < 52 || memcmp(header, "\177ELF", 4) != 0) {
+    fclose(f);
+    return fail(error, "not an ELF file");
+  }
+  bool elf64 = header[4] == 2;
+  if((header[4] != 1 && header[4] != 2) || header[5] != 1 || (elf64 && got < 64)) {
+    fclose(f);
+    return fail(error, "not a little-endian ELF32/ELF64 file");
+  }
+
+  uint64_t shoff     = elf64 ? readLe(header + 0x28, 8) : readLe(header + 0x20, 4);
+  unsigned shentsize = (unsigned)readLe(header + (elf64 ? 0x3A : 0x2E), 2);
+  unsigned shnum     = (unsigned)readLe(header + (elf64 ? 0x3C : 0x30), 2);
+  unsigned shstrndx  = (unsigned)readLe(header + (elf64 ? 0x3E : 0x32), 2);
+  if(shnum == 0 || shstrndx >= shnum || shentsize < (elf64 ? 64u : 40u)) {
+    fclose(f);
+    return fail(error, "no section table");
+  }
+  std::vector<unsigned char> table((size_t)shentsize * shnum);
+  if(!readAt(f, shoff, table.data(), table.size())) {
+    fclose(f);
+    return fail(error, "truncated section table");
+  }
+
+  std::vector<uint32_t> name_offsets(shnum);
+  info->sections.resize(shnum);
+  for(unsigned i = 0; i < shnum; ++i) {
+    const unsigned char *sh = &table[(size_t)i * shentsize];
+    name_offsets[i]           = (uint32_t)readLe(sh, 4);
+    info->sections[i].offset  = elf64 ? readLe(sh + 24, 8) : readLe(sh + 16, 4);
+    info->sections[i].size    = elf64 ? readLe(sh + 32, 8) : readLe(sh + 20, 4);
+  }
+  std::string names = readSection(f, info->sections[shstrndx]);
+  for(unsigned i = 0; i < shnum; ++i) {
+    if(name_offsets[i] < names.size()) {
+      info->sections[i].name = names.c_str() + name_offsets[i];
+    }
+  }
+
+  const AocxSection *s;
+  if((s = findSection(*info, ".acl.board")) != NULL)          info->board = trim(readSection(f, *s));
+  if((s = findSection(*info, ".acl.version")) != NULL)        info->version = trim(readSection(f, *s));
+  if((s = findSection(*info, ".acl.target")) != NULL)         info->target = trim(readSection(f, *s));
+  if((s = findSection(*info, ".acl.compileoptions")) != NULL) info->compile_options = trim(readSection(f, *s));
+  if((s = findSection(*info, ".acl.kernel_arg_info.xml")) != NULL) {
+    kernelsFromXml(readSection(f, *s), info->kernels);
+  }
+  if(info->kernels.empty() && (s = findSection(*info, ".acl.source")) != NULL) {
+    kernelsFromSource(readSection(f, *s), info->kernels);
+  }
+  if((s = findSection(*info, ".acl.quartus_report")) != NULL) {
+    std::string report = readSection(f, *s);
+    info->fmax_mhz = numberAfter(report, "Actual clock freq:");
+    if(info->fmax_mhz <= 0) {
+      info->fmax_mhz = numberAfter(report, "Kernel fmax:");
+    }
+    if(info->fmax_mhz < 0) {
+      info->fmax_mhz = 0;
+    }
+  }
+  fclose(f);
+  return true;
+}
+
+std::string readAocxSection(const char *file, const AocxInfo &info, const std::string &name) {
+  const AocxSection *section = findSection(info, name);
+  if(section == NULL) {
+    return "";
+  }
+  FILE *f = fopen(file, "rb");
+  if(f == NULL) {
+    return "";
+  }
+  std::string data((size_t)section->size, '\0');
+  if(!data.empty() && !readAt(f, section->offset, &data[0], data.size())) {
+    data.clear();
+  }
+  fclose(f);
+  return data;
+}
+
+
+// Checks
+/********************************************************************/
+bool checkAocxKernels(const char *file, const char *const *kernels, unsigned num_kernels) {
+  AocxInfo info;
+  if(!readAocx(file, &info) || info.kernels.empty()) {
+    return true;
+  }
+  std::string missing;
+  for(unsigned i = 0; i < num_kernels; ++i) {
+    bool found = false;
+    for(size_t k = 0; k < info.kernels.size() && !found; ++k) {
+      found = info.kernels[k] == kernels[i];
+    }
+    if(!found) {
+      missing += missing.empty() ? "" : ", ";
+      missing += kernels[i];
+    }
+  }
+  if(!missing.empty()) {
+    std::string present;
+    for(size_t k = 0; k < info.kernels.size(); ++k) {
+      present += (k == 0 ? "" : ", ") + info.kernels[k];
+    }
+    printf("ERROR: %s has no kernel %s (it has %s).\n", file, missing.c_str(), present.c_str());
+    return false;
+  }
+  return true;
+}
+
+void printAocxSummary(const char *file) {
+  AocxInfo info;
+  if(!readAocx(file, &info)) {
+    return;
+  }
+  printf("AOCX: board %s, compiler %s, %u kernel(s)",
+         info.board.empty() ? "?" : info.board.c_str(), info.version.empty() ? "?" : info.version.c_str(),
+         (unsigned)info.kernels.size());
+  if(info.fmax_mhz > 0) {
+    printf(", kernel clock %.3f MHz", info.fmax_mhz);
+  }
+  printf("\n");
+}
+
+} // ns aocl_utils
@@ -0,0 +1,68 @@
+// Completion of OpenCL commands as futures.
+
+#include <atomic>
+#include <memory>
+
+#include "AOCLUtils/opencl.h"
+#include "AOCLUtils/async.h"
+
+namespace aocl_utils {
+
+struct Continuation {
+  cl_event                    event;
+  std::function<void(cl_int)> function;
+};
+
+static void CL_CALLBACK runContinuation(cl_event, cl_int status, void *user_data) {
+  Continuation *c = static_cast<Continuation *>(user_data);
+  c->function(status);
+  clReleaseEvent(c->event);
+  delete c;
+}
+
+void onComplete(cl_event event, const std::function<void(cl_int)> &continuation) {
+  Continuation *c = new Continuation;
+  c->event = event;
+  c->function = continuation;
+  clRetainEvent(event);
+  cl_int status = clSetEventCallback(event, CL_COMPLETE, runContinuation, c);
+  checkError(status, "Failed to set event callback");
+}
+
+std::future<cl_int> whenComplete(cl_event event) {
+  std::shared_ptr<std::promise<cl_int> > promise(new std::promise<cl_int>);
+  onComplete(event, [promise](cl_int status) { promise->set_value(status); });
+  return promise->get_future();
+}
+
+// What the commands of whenAllComplete share
+struct AllComplete {
+  std::promise<cl_int> promise;
+  std::atomic<unsigned> remaining;
+  std::atomic<cl_int>   status;
+};
+
+std::future<cl_int> whenAllComplete(const cl_event *events, unsigned num_events) {
+  std::shared_ptr<AllComplete> all(new AllComplete);
+  all->remaining.store(num_events);
+  all->status.store(CL_COMPLETE);
+  std::future<cl_int> future = all->promise.get_future();
+  if(num_events == 0) {
+    all->promise.set_value(CL_COMPLETE);
+    return future;
+  }
+  for(unsigned i = 0; i < num_events; ++i) {
+    onComplete(events[i], [all](cl_int status) {
+      if(status < 0) {
+        cl_int expected = CL_COMPLETE;
+        all->status.compare_exchange_strong(expected, status);
+      }
+      if(--all->remaining == 0) {
+        all->promise.set_value(all->status.load());
+      }
+    });
+  }
+  return future;
+}
+
+} // ns aocl_utils
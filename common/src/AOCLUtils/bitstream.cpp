@@ -0,0 +1,158 @@
+// Bitstream residency tracking.
+
+#include "AOCLUtils/aocl_utils.h"
+#include <fstream>
+#include <map>
+#include <stdint.h>
+#include <stdlib.h>
+
+namespace aocl_utils {
+
+// Environment variable read by the runtime at context creation. Mode 3 makes
+// the runtime use the bitstream already on the board instead of the AOCX.
+static const char *const COMPILER_MODE_ENV  = "CL_CONTEXT_COMPILER_MODE_INTELFPGA";
+static const char *const PRELOADED_MODE     = "3";
+static const char *const STATE_FILE_ENV     = "AOCL_BITSTREAM_STATE";
+
+// Set when prepareBinaryLoad changed the compiler mode, so that a later
+// load of a different binary in the same process restores it.
+static bool compiler_mode_overridden = false;
+
+typedef std::map<std::string, std::string> HashMap;  // device name -> hash
+
+static void setCompilerMode(const char *mode) {
+#ifdef _WIN32 // Windows
+  _putenv_s(COMPILER_MODE_ENV, mode != NULL ? mode : "");
+#else         // Linux
+  if(mode != NULL) {
+    setenv(COMPILER_MODE_ENV, mode, 1);
+  }
+  else {
+    unsetenv(COMPILER_MODE_ENV);
+  }
+#endif
+}
+
+static HashMap readStateFile(const char *state_file) {
+  HashMap hashes;
+  std::ifstream ifs(state_file);
+  std::string line;
+  while(std::getline(ifs, line)) {
+    // Each line is "<hash> <device name>".
+    size_t sep = line.find(' ');
+    if(sep == std::string::npos || sep == 0) {
+      continue;
+    }
+    hashes[line.substr(sep + 1)] = line.substr(0, sep);
+  }
+  return hashes;
+}
+
+static void writeStateFile(const char *state_file, const HashMap &hashes) {
+  // Write to a temporary file and rename so that an interrupted run never
+  // leaves a truncated state file behind.
+  std::string tmp_file = std::string(state_file) + ".tmp";
+  {
+    std::ofstream ofs(tmp_file.c_str());
+    for(HashMap::const_iterator it = hashes.begin(); it != hashes.end(); ++it) {
+      ofs << it->second << ' ' << it->first << '\n';
+    }
+    if(!ofs) {
+      printf("Failed to write bitstream state file '%s'\n", tmp_file.c_str());
+      return;
+    }
+  }
+  if(rename(tmp_file.c_str(), state_file) != 0) {
+    printf("Failed to update bitstream state file '%s'\n", state_file);
+  }
+}
+
+std::string hashBinaryFile(const char *file_name) {
+  FILE *fp = fopen(file_name, "rb");
+  if(fp == NULL) {
+    return std::string();
+  }
+
+  uint64_t hash = 14695981039346656037ULL;  // FNV-1a offset basis
+  unsigned char buf[1 << 16];
+  size_t n;
+  while((n = fread(buf, 1, sizeof(buf), fp)) > 0) {
+    for(size_t i = 0; i < n; ++i) {
+      hash ^= buf[i];
+      hash *= 1099511628211ULL;  // FNV-1a prime
+    }
+  }
+  bool failed = ferror(fp) != 0;
+  fclose(fp);
+  if(failed) {
+    return std::string();
+  }
+
+  char str[17];
+  snprintf(str, sizeof(str), "%016llx", (unsigned long long) hash);
+  return str;
+}
+
+const char *getBitstreamStateFile() {
+  const char *state_file = getenv(STATE_FILE_ENV);
+  return (state_file != NULL && state_file[0] != '\0') ? state_file : NULL;
+}
+
+bool prepareBinaryLoad(const char *state_file, const char *binary_file_name,
+                       const cl_device_id *devices, unsigned num_devices) {
+  bool resident = false;
+
+  if(state_file != NULL && state_file[0] != '\0') {
+    std::string hash = hashBinaryFile(binary_file_name);
+    HashMap hashes = readStateFile(state_file);
+
+    resident = !hash.empty() && num_devices > 0;
+    for(unsigned i = 0; i < num_devices && resident; ++i) {
+      HashMap::const_iterator it = hashes.find(getDeviceName(devices[i]));
+      resident = (it != hashes.end() && it->second == hash);
+    }
+  }
+
+  if(resident) {
+    setCompilerMode(PRELOADED_MODE);
+    compiler_mode_overridden = true;
+  }
+  else if(compiler_mode_overridden) {
+    setCompilerMode(NULL);
+    compiler_mode_overridden = false;
+  }
+
+  return resident;
+}
+
+cl_program loadProgramFromBinary(cl_context context, const char *binary_file_name,
+                                 const cl_device_id *devices, unsigned num_devices,
+                                 bool resident, const char *state_file) {
+  const double start = getCurrentTimestamp();
+
+  cl_program program = createProgramFromBinary(context, binary_file_name, devices, num_devices);
+  cl_int status = clBuildProgram(program, 0, NULL, "", NULL, NULL);
+  checkError(status, "Failed to build program");
+
+  const double end = getCurrentTimestamp();
+
+  if(resident) {
+    printf("Reconfiguration: skipped, resident bitstream reused (%.3f sec)\n", end - start);
+  }
+  else {
+    printf("Reconfiguration: done (%.3f sec)\n", end - start);
+  }
+
+  if(state_file != NULL && state_file[0] != '\0' && !resident) {
+    std::string hash = hashBinaryFile(binary_file_name);
+    HashMap hashes = readStateFile(state_file);
+    for(unsigned i = 0; i < num_devices; ++i) {
+      hashes[getDeviceName(devices[i])] = hash;
+    }
+    writeStateFile(state_file, hashes);
+  }
+
+  return program;
+}
+
+} // ns aocl_utils
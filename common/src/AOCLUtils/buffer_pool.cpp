@@ -0,0 +1,132 @@
+// Pool of device buffers reused across tries, sweep points and tests.
+
+#include "AOCLUtils/aocl_utils.h"
+#include <stdio.h>
+
+namespace aocl_utils {
+
+static const size_t MIN_SIZE_CLASS = 4096;
+
+BufferPool::Lease::Lease(Lease &&other)
+  : m_pool(other.m_pool), m_mem(other.m_mem), m_flags(other.m_flags), m_size(other.m_size) {
+  other.m_pool = NULL;
+  other.m_mem  = NULL;
+}
+
+BufferPool::Lease &BufferPool::Lease::operator =(Lease &&other) {
+  if(this != &other) {
+    release();
+    m_pool  = other.m_pool;
+    m_mem   = other.m_mem;
+    m_flags = other.m_flags;
+    m_size  = other.m_size;
+    other.m_pool = NULL;
+    other.m_mem  = NULL;
+  }
+  return *this;
+}
+
+void BufferPool::Lease::release() {
+  if(m_mem != NULL) {
+    m_pool->giveBack(m_mem, m_flags, m_size);
+  }
+  m_pool = NULL;
+  m_mem  = NULL;
+}
+
+BufferPool::BufferPool(cl_context context)
+  : m_context(context), m_leases(0) {
+  m_stats.requests          = 0;
+  m_stats.hits              = 0;
+  m_stats.device_bytes      = 0;
+  m_stats.peak_device_bytes = 0;
+  m_stats.leased_bytes      = 0;
+}
+
+BufferPool::~BufferPool() {
+  trim();
+}
+
+void BufferPool::setContext(cl_context context) {
+  if(m_leases != 0) {
+    printf("ERROR: %lu buffer(s) still leased from the pool.\n", m_leases);
+    exit(1);
+  }
+  trim();
+  m_context = context;
+}
+
+size_t BufferPool::sizeClass(size_t size) {
+  if(size <= MIN_SIZE_CLASS) {
+    return MIN_SIZE_CLASS;
+  }
+  size_t power = MIN_SIZE_CLASS;
+  while(power <= (size - 1) / 2) {
+    power <<= 1;
+  }
+  size_t step = power / 8;
+  return (size + step - 1) / step * step;
+}
+
+cl_mem BufferPool::allocate(cl_mem_flags flags, size_t size, cl_int *status) {
+  cl_mem mem = clCreateBuffer(m_context, flags, size, NULL, status);
+  if(*status != CL_SUCCESS) {
+    return NULL;
+  }
+  m_stats.device_bytes += size;
+  if(m_stats.device_bytes > m_stats.peak_device_bytes) {
+    m_stats.peak_device_bytes = m_stats.device_bytes;
+  }
+  return mem;
+}
+
+BufferPool::Lease BufferPool::acquire(cl_mem_flags flags, size_t size) {
+  size_t size_class = sizeClass(size);
+  ++m_stats.requests;
+
+  cl_mem mem = NULL;
+  FreeMap::iterator it = m_free.find(Key(flags, size_class));
+  if(it != m_free.end()) {
+    mem = it->second.release();
+    m_free.erase(it);
+    ++m_stats.hits;
+  } else {
+    cl_int status;
+    mem = allocate(flags, size_class, &status);
+    if(mem == NULL && !m_free.empty()) {
+      trim();
+      mem = allocate(flags, size_class, &status);
+    }
+    if(mem == NULL && size_class != size) {
+      // The rounding itself may exceed the bank or CL_DEVICE_MAX_MEM_ALLOC_SIZE.
+      size_class = size;
+      mem = allocate(flags, size_class, &status);
+    }
+    checkError(status, "Failed to create buffer of %lu bytes", (unsigned long)size);
+  }
+
+  ++m_leases;
+  m_stats.leased_bytes += size_class;
+  return Lease(this, mem, flags, size_class);
+}
+
+void BufferPool::giveBack(cl_mem mem, cl_mem_flags flags, size_t size) {
+  --m_leases;
+  m_stats.leased_bytes -= size;
+  m_free.insert(std::make_pair(Key(flags, size), scoped_cl_mem(mem)));
+}
+
+void BufferPool::trim() {
+  for(FreeMap::iterator it = m_free.begin(); it != m_free.end(); ++it) {
+    m_stats.device_bytes -= it->first.second;
+  }
+  m_free.clear();
+}
+
+void BufferPool::printStats() const {
+  printf("Buffer pool: %lu request(s), %lu hit(s) (%.1f%%), peak device memory %.1f MiB\n",
+      m_stats.requests, m_stats.hits, m_stats.hitRate() * 100.0,
+      double(m_stats.peak_device_bytes) / (1024.0 * 1024.0));
+}
+
+} // ns aocl_utils
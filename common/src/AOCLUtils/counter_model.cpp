@@ -0,0 +1,89 @@
+// Cycle-accurate model of wait_func.v and of the cycle counter of the BSP.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "AOCLUtils/counter_model.h"
+
+namespace aocl_utils {
+
+static unsigned envUnsigned(const char *name, unsigned default_value) {
+  const char *value = getenv(name);
+  return (value != NULL && *value != '\0') ? (unsigned)strtoul(value, NULL, 0) : default_value;
+}
+
+// Configuration
+/********************************************************************/
+CounterConfig CounterConfig::fromEnv() {
+  CounterConfig c;
+  c.in_cycles   = envUnsigned("CNT_IN_CYCLES", 2);
+  c.out_cycles  = envUnsigned("CNT_OUT_CYCLES", 2);
+  c.call_gap    = envUnsigned("CNT_CALL_GAP", 1);
+  c.stop_gap    = envUnsigned("CNT_STOP_GAP", 2);
+  c.ready_delay = envUnsigned("CNT_READY_DELAY", 0);
+
+  if(c.out_cycles == 0 || c.stop_gap == 0) {
+    printf("ERROR: Invalid cycle counter model parameters.\n");
+    exit(1);
+  }
+  return c;
+}
+
+void CounterConfig::print() const {
+  printf("Counter model: channel in %u, result out %u, call gap %u, stop gap %u, ready delay %u cycles\n",
+         in_cycles, out_cycles, call_gap, stop_gap, ready_delay);
+}
+
+
+// Counter
+/********************************************************************/
+CycleCounterModel::CycleCounterModel(const CounterConfig &config)
+  : m_config(config), m_cycle(0), m_started(false), m_start_seen(0) {
+}
+
+bool CycleCounterModel::resultValid() const {
+  return !m_results.empty() && m_results.front().valid_from <= m_cycle;
+}
+
+uint64_t CycleCounterModel::result() const {
+  return resultValid() ? m_results.front().cycles : 0;
+}
+
+bool CycleCounterModel::edge(const Inputs &in) {
+  bool taken = in.result_ready && resultValid();
+  if(taken) {
+    m_results.pop_front();
+  }
+  // Both words reach the counter in_cycles after their handshake, so the
+  // count is known at the stop handshake already
+  if(in.start_valid) {
+    m_started = true;
+    m_start_seen = m_cycle + m_config.in_cycles;
+  }
+  if(in.stop_valid && m_started) {
+    uint64_t stop_seen = m_cycle + m_config.in_cycles;
+    Result r = { stop_seen + m_config.out_cycles, stop_seen - m_start_seen };
+    m_results.push_back(r);
+    m_started = false;
+  }
+  ++m_cycle;
+  return taken;
+}
+
+
+// tb_wait_func
+/********************************************************************/
+TbWaitFuncTiming predictTbWaitFunc(const CounterConfig &config, uint64_t n) {
+  // wait_func is ready again in the edge after it returns
+  uint64_t start  = waitFuncLatency(n, config.ready_delay) + 1;
+  uint64_t call   = start + config.call_gap;
+  uint64_t stop   = call + waitFuncLatency(n, config.ready_delay) + config.stop_gap;
+
+  TbWaitFuncTiming t;
+  t.expected      = waitFuncResult(n, config.ready_delay);
+  t.measured      = stop - start;
+  t.kernel_cycles = stop + config.in_cycles + config.out_cycles;
+  return t;
+}
+
+} // ns aocl_utils
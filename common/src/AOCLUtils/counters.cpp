@@ -0,0 +1,168 @@
+// Tagged cycle counters: the host side of common/device/aocl_counters.h.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "AOCLUtils/opencl.h"
+#include "AOCLUtils/counters.h"
+
+namespace aocl_utils {
+
+static const char *CALIBRATION_FILE_ENV = "AOCL_COUNTER_CALIBRATION";
+
+bool fitCounterCalibration(const std::vector<CounterSample> &samples, CounterCalibration &calibration) {
+  size_t n = samples.size();
+  if(n < 2) {
+    return false;
+  }
+  double mean_x = 0, mean_y = 0;
+  for(size_t i = 0; i < n; ++i) {
+    mean_x += samples[i].expected;
+    mean_y += samples[i].measured;
+  }
+  mean_x /= n;
+  mean_y /= n;
+  double sxy = 0, sxx = 0;
+  for(size_t i = 0; i < n; ++i) {
+    double dx = samples[i].expected - mean_x;
+    sxy += dx * (samples[i].measured - mean_y);
+    sxx += dx * dx;
+  }
+  if(sxx <= 0 || sxy <= 0) {
+    return false;
+  }
+  calibration.scale = sxy / sxx;
+  calibration.offset = mean_y - calibration.scale * mean_x;
+  calibration.samples = (unsigned)n;
+
+  double sum_sq = 0, max_abs = 0;
+  for(size_t i = 0; i < n; ++i) {
+    double r = samples[i].measured - (calibration.scale * samples[i].expected + calibration.offset);
+    sum_sq += r * r;
+    max_abs = fabs(r) > max_abs ? fabs(r) : max_abs;
+  }
+  calibration.residual_rms = sqrt(sum_sq / n);
+  calibration.residual_max = max_abs;
+  return true;
+}
+
+const char *getCounterCalibrationFile() {
+  const char *file = getenv(CALIBRATION_FILE_ENV);
+  return (file != NULL && file[0] != '\0') ? file : NULL;
+}
+
+bool saveCounterCalibration(const char *file, const CounterCalibration &calibration) {
+  FILE *fp = fopen(file, "w");
+  if(fp == NULL) {
+    printf("ERROR: Unable to write the counter calibration to %s\n", file);
+    return false;
+  }
+  fprintf(fp, "# scale offset residual_rms residual_max samples\n");
+  fprintf(fp, "%.9g %.9g %.9g %.9g %u\n", calibration.scale, calibration.offset,
+          calibration.residual_rms, calibration.residual_max, calibration.samples);
+  fclose(fp);
+  return true;
+}
+
+bool loadCounterCalibration(const char *file, CounterCalibration &calibration) {
+  FILE *fp = fopen(file, "r");
+  if(fp == NULL) {
+    return false;
+  }
+  char line[256];
+  bool ok = false;
+  while(!ok && fgets(line, sizeof(line), fp) != NULL) {
+    if(line[0] == '#') {
+      continue;
+    }
+    ok = sscanf(line, "%lf %lf %lf %lf %u", &calibration.scale, &calibration.offset,
+                &calibration.residual_rms, &calibration.residual_max, &calibration.samples) == 5 &&
+         calibration.scale > 0;
+  }
+  fclose(fp);
+  return ok;
+}
+
+CounterCollector::CounterCollector(cl_context context, cl_program program, unsigned num_counters)
+  : m_num_counters(num_counters), m_calibrated(false), m_calibration(), m_cycles(num_counters), m_stops(num_counters), m_names(num_counters) {
+  if(num_counters == 0 || num_counters > MAX_COUNTERS) {
+    printf("ERROR: %u counters requested, at most %u are possible\n", num_counters, MAX_COUNTERS);
+    exit(1);
+  }
+  cl_int status;
+  m_kernel = clCreateKernel(program, "aocl_counters_collect", &status);
+  checkError(status, "Failed to create the counter collector (is AOCL_COUNTERS_COLLECTOR in the program?)");
+  m_cycles_buf = clCreateBuffer(context, CL_MEM_WRITE_ONLY, num_counters * sizeof(cl_ulong), NULL, &status);
+  checkError(status, "Failed to create buffer for the counter cycles");
+  m_stops_buf = clCreateBuffer(context, CL_MEM_WRITE_ONLY, num_counters * sizeof(cl_ulong), NULL, &status);
+  checkError(status, "Failed to create buffer for the counter stops");
+
+  const char *file = getCounterCalibrationFile();
+  CounterCalibration calibration;
+  if(file != NULL && loadCounterCalibration(file, calibration)) {
+    printf("Counter calibration: %.2f cycles per interval, scale %.6f (%s)\n", calibration.offset, calibration.scale, file);
+    setCalibration(calibration);
+  }
+}
+
+void CounterCollector::setCalibration(const CounterCalibration &calibration) {
+  m_calibration = calibration;
+  m_calibrated = true;
+}
+
+double CounterCollector::cycles(unsigned id) const {
+  if(!m_calibrated) {
+    return (double)m_cycles[id];
+  }
+  double cycles = (m_cycles[id] - m_stops[id] * m_calibration.offset) / m_calibration.scale;
+  return cycles > 0 ? cycles : 0;
+}
+
+void CounterCollector::setName(unsigned id, const std::string &name) {
+  if(id < m_num_counters) {
+    m_names[id] = name;
+  }
+}
+
+void CounterCollector::drain(cl_command_queue queue, cl_uint num_events, const cl_event *events, bool clear) {
+  cl_uint num = m_num_counters;
+  cl_uint clear_arg = clear ? 1 : 0;
+  cl_int status;
+  unsigned argi = 0;
+  status = clSetKernelArg(m_kernel, argi++, sizeof(cl_mem), m_cycles_buf.ptr()); checkError(status, "Failed to set argument cycles");
+  status = clSetKernelArg(m_kernel, argi++, sizeof(cl_mem), m_stops_buf.ptr());  checkError(status, "Failed to set argument stops");
+  status = clSetKernelArg(m_kernel, argi++, sizeof(cl_uint), &num);             checkError(status, "Failed to set argument num");
+  status = clSetKernelArg(m_kernel, argi++, sizeof(cl_uint), &clear_arg);       checkError(status, "Failed to set argument clear");
+
+  scoped_cl_event collect_event;
+  status = clEnqueueTask(queue, m_kernel, num_events, events, collect_event.out());
+  checkError(status, "Failed to launch the counter collector");
+  status = clEnqueueReadBuffer(queue, m_cycles_buf, CL_FALSE, 0, num * sizeof(cl_ulong), m_cycles.data(), 1, collect_event.ptr(), NULL);
+  checkError(status, "Failed to read the counter cycles");
+  status = clEnqueueReadBuffer(queue, m_stops_buf, CL_TRUE, 0, num * sizeof(cl_ulong), m_stops.data(), 1, collect_event.ptr(), NULL);
+  checkError(status, "Failed to read the counter stops");
+}
+
+void CounterCollector::print(double kernel_mhz) const {
+  printf("%-6s %-16s %10s %14s %14s", "region", "name", "stops", m_calibrated ? "cycles (cal.)" : "cycles", "cycles/stop");
+  if(kernel_mhz > 0) {
+    printf(" %12s %12s", "total us", "us/stop");
+  }
+  printf("\n");
+  for(unsigned id = 0; id < m_num_counters; ++id) {
+    if(m_stops[id] == 0) {
+      continue;
+    }
+    double total = cycles(id);
+    double per_stop = total / m_stops[id];
+    printf("%-6u %-16s %10llu %14.1f %14.1f", id, m_names[id].c_str(),
+           (unsigned long long)m_stops[id], total, per_stop);
+    if(kernel_mhz > 0) {
+      printf(" %12.3f %12.3f", total / kernel_mhz, per_stop / kernel_mhz);
+    }
+    printf("\n");
+  }
+}
+
+} // ns aocl_utils
@@ -0,0 +1,265 @@
+// Timing model of a DDR memory behind the 512-bit Avalon-MM port of a kernel.
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "AOCLUtils/ddr_model.h"
+
+namespace aocl_utils {
+
+static double envDouble(const char *name, double default_value) {
+  const char *value = getenv(name);
+  return (value != NULL && *value != '\0') ? strtod(value, NULL) : default_value;
+}
+
+// Configuration
+/********************************************************************/
+DdrConfig DdrConfig::fromEnv(double kernel_mhz) {
+  DdrConfig c;
+  c.kernel_mhz   = kernel_mhz;
+  c.mhz          = envDouble("DDR_MHZ", 1200);
+  c.tcl          = (unsigned)envDouble("DDR_TCL", 16);
+  c.tcwl         = (unsigned)envDouble("DDR_TCWL", 12);
+  c.trcd         = (unsigned)envDouble("DDR_TRCD", 16);
+  c.trp          = (unsigned)envDouble("DDR_TRP", 16);
+  c.trefi_ns     = envDouble("DDR_TREFI_NS", 7800);
+  c.trfc_ns      = envDouble("DDR_TRFC_NS", 350);
+  c.banks        = (unsigned)envDouble("DDR_BANKS", 16);
+  c.row_bytes    = (unsigned)envDouble("DDR_ROW_BYTES", 8192);
+  c.bus_bytes    = (unsigned)envDouble("DDR_BUS_BYTES", 8);
+  c.burst_length = (unsigned)envDouble("DDR_BURST_LENGTH", 8);
+  c.ctrl_cycles  = (unsigned)envDouble("DDR_CTRL_CYCLES", 100);
+  c.queue_depth  = (unsigned)envDouble("DDR_QUEUE_DEPTH", 32);
+
+  if(c.kernel_mhz <= 0 || c.mhz <= 0 || c.banks == 0 || c.row_bytes < DdrModel::BEAT_BYTES ||
+     c.bus_bytes == 0 || c.burst_length < 2 || c.queue_depth == 0 || c.trefi_ns <= c.trfc_ns) {
+    printf("ERROR: Invalid DDR model parameters.\n");
+    exit(1);
+  }
+  return c;
+}
+
+void DdrConfig::print() const {
+  printf("DDR model: %.0f MT/s x %u bytes, CL-tRCD-tRP %u-%u-%u, CWL %u, BL%u, %u banks x %u-byte rows\n",
+         2 * mhz, bus_bytes, tcl, trcd, trp, tcwl, burst_length, banks, row_bytes);
+  printf("           tREFI %.0f ns, tRFC %.0f ns, controller %u cycles, queue %u, kernel clock %.2f MHz\n",
+         trefi_ns, trfc_ns, ctrl_cycles, queue_depth, kernel_mhz);
+}
+
+double DdrConfig::peakGBps() const {
+  return 2 * mhz * bus_bytes * 1.0e-3;
+}
+
+double DdrConfig::portGBps() const {
+  return DdrModel::BEAT_BYTES * kernel_mhz * 1.0e-3;
+}
+
+
+// DRAM
+/********************************************************************/
+DdrModel::DdrModel(const DdrConfig &config)
+  : m_config(config),
+    m_bus_free(0),
+    m_last_beat(0) {
+  m_stats = DdrStats();
+  Bank closed = { -1, 0 };
+  m_banks.assign(config.banks, closed);
+  m_next_refresh = config.trefi_ns * config.mhz * 1.0e-3;
+
+  // A beat takes whole column bursts of burst_length transfers, two per clock
+  unsigned burst_bytes = config.bus_bytes * config.burst_length;
+  unsigned bursts = (BEAT_BYTES + burst_bytes - 1) / burst_bytes;
+  m_beat_clocks = bursts * config.burst_length / 2.0;
+}
+
+uint64_t DdrModel::toKernel(double clocks) const {
+  return (uint64_t)ceil(clocks * m_config.kernel_mhz / m_config.mhz - 1e-9);
+}
+
+// Returns the time from which a command can be issued at `t`, after any
+// refresh due by then.
+double DdrModel::refresh(double t) {
+  if(t < m_next_refresh) {
+    return t;
+  }
+  double trefi = m_config.trefi_ns * m_config.mhz * 1.0e-3;
+  double trfc = m_config.trfc_ns * m_config.mhz * 1.0e-3;
+
+  // Skip the refreshes of an idle period; only the last one can matter
+  uint64_t skipped = (uint64_t)((t - m_next_refresh) / trefi);
+  m_next_refresh += skipped * trefi;
+  m_stats.refreshes += skipped + 1;
+
+  double end = m_next_refresh + trfc;
+  for(unsigned b = 0; b < m_banks.size(); ++b) {
+    m_banks[b].open_row = -1;
+    m_banks[b].ready = std::max(m_banks[b].ready, end);
+  }
+  m_next_refresh += trefi;
+  return std::max(t, end);
+}
+
+// Returns when the data of the beat has crossed the bus, in memory clocks.
+double DdrModel::access(uint64_t now, uint64_t addr, bool write) {
+  uint64_t row_index = addr / m_config.row_bytes;
+  Bank &bank = m_banks[row_index % m_config.banks];
+  int64_t row = (int64_t)(row_index / m_config.banks);
+
+  double t = refresh(std::max(toMemory(now), bank.ready));
+  if(bank.open_row == row) {
+    ++m_stats.row_hits;
+  } else {
+    if(bank.open_row >= 0) {
+      t += m_config.trp;
+    }
+    t += m_config.trcd;
+    bank.open_row = row;
+    ++m_stats.row_misses;
+  }
+
+  // The CAS is issued so that the data finds the bus free
+  unsigned latency = write ? m_config.tcwl : m_config.tcl;
+  double data = std::max(t + latency, m_bus_free);
+  m_bus_free = data + m_beat_clocks;
+  bank.ready = data - latency + m_beat_clocks;
+  return data + m_beat_clocks;
+}
+
+uint64_t DdrModel::readBeat(uint64_t now, uint64_t addr) {
+  uint64_t ready = toKernel(access(now, addr, false)) + m_config.ctrl_cycles;
+  ready = std::max(ready, std::max(now, m_last_beat) + 1);
+  m_last_beat = ready;
+  return ready;
+}
+
+bool DdrModel::canWrite(uint64_t now) {
+  while(!m_writes.empty() && m_writes.front() <= now) {
+    m_writes.pop_front();
+  }
+  return m_writes.size() < m_config.queue_depth;
+}
+
+uint64_t DdrModel::nextWriteSlot(uint64_t now) {
+  return canWrite(now) ? now : m_writes.front();
+}
+
+uint64_t DdrModel::writeBeat(uint64_t now, uint64_t addr) {
+  // Data leaves the bus in order, so the buffer drains in order
+  uint64_t done = std::max(toKernel(access(now, addr, true)), now + 1);
+  m_writes.push_back(done);
+  return done;
+}
+
+void DdrModel::scheduleWriteAck(uint64_t now, uint64_t done) {
+  uint64_t ack = std::max(done + m_config.ctrl_cycles / 2, now + 1);
+  if(!m_acks.empty()) {
+    ack = std::max(ack, m_acks.back() + 1);
+  }
+  m_acks.push_back(ack);
+}
+
+bool DdrModel::takeWriteAck(uint64_t now) {
+  if(!m_acks.empty() && m_acks.front() <= now) {
+    m_acks.pop_front();
+    return true;
+  }
+  return false;
+}
+
+uint64_t DdrModel::nextWriteAck(uint64_t now) {
+  while(!m_acks.empty() && m_acks.front() < now) {
+    m_acks.pop_front();
+  }
+  return m_acks.empty() ? 0 : m_acks.front();
+}
+
+
+// The RTL modules
+/********************************************************************/
+// Cycles are counted from the rising edge at which the module accepts its
+// arguments (cycle `start`). DRAM_READ issues a burst two cycles after the
+// previous one was accepted; read.v stops counting at the last beat.
+uint64_t predictDramReadCycles(DdrModel &ddr, uint64_t start, uint64_t addr, uint64_t beats, unsigned maxburst_log) {
+  if(beats == 0) {
+    return 0;
+  }
+  uint64_t maxburst = 1ULL << maxburst_log;
+  uint64_t bursts = (beats + maxburst - 1) / maxburst;
+
+  std::deque<uint64_t> pending;  // cycles of the last beats of outstanding bursts
+  uint64_t t = start + 3;
+  uint64_t last = start;
+  for(uint64_t k = 0; k < bursts; ++k) {
+    uint64_t count = (k + 1 == bursts) ? beats - k * maxburst : maxburst;
+    for(;;) {
+      while(!pending.empty() && pending.front() <= t) {
+        pending.pop_front();
+      }
+      if(pending.size() < ddr.config().queue_depth) {
+        break;
+      }
+      t = pending.front();
+    }
+    uint64_t burst_addr = addr + k * maxburst * DdrModel::BEAT_BYTES;
+    for(uint64_t i = 0; i < count; ++i) {
+      last = ddr.readBeat(t, burst_addr + i * DdrModel::BEAT_BYTES);
+    }
+    pending.push_back(last);
+    t += 2;
+  }
+  return last - start;
+}
+
+// DRAM_WRITE sends the beats of a burst back to back and starts the next
+// burst two cycles after the last beat; write.v stops counting at the first
+// writeack after the last beat.
+uint64_t predictDramWriteCycles(DdrModel &ddr, uint64_t start, uint64_t addr, uint64_t beats, unsigned maxburst_log) {
+  if(beats == 0) {
+    return 0;
+  }
+  uint64_t maxburst = 1ULL << maxburst_log;
+  uint64_t bursts = (beats + maxburst - 1) / maxburst;
+
+  uint64_t t = start + 3;
+  uint64_t last = t;
+  for(uint64_t k = 0; k < bursts; ++k) {
+    uint64_t count = (k + 1 == bursts) ? beats - k * maxburst : maxburst;
+    uint64_t burst_addr = addr + k * maxburst * DdrModel::BEAT_BYTES;
+    uint64_t done = 0;
+    for(uint64_t i = 0; i < count; ++i) {
+      last = ddr.nextWriteSlot(t);
+      done = ddr.writeBeat(last, burst_addr + i * DdrModel::BEAT_BYTES);
+      t = last + 1;
+    }
+    ddr.scheduleWriteAck(last, done);
+    t = last + 2;
+  }
+  uint64_t ack = ddr.nextWriteAck(last + 1);
+  ddr.takeWriteAck(ack);
+  return ack - 1 - start;
+}
+
+// The latency module issues its read in the cycle after the start and stops
+// counting at the beat.
+uint64_t predictReadLatencyCycles(DdrModel &ddr, uint64_t start, uint64_t addr) {
+  return ddr.readBeat(start + 1, addr) - 1 - start;
+}
+
+uint64_t predictLatencyKernelCycles(DdrModel &ddr, uint64_t base, const int *index, size_t n, int *cycles) {
+  uint64_t t = 0;
+  for(size_t i = 0; i < n; ++i) {
+    uint64_t latency = predictReadLatencyCycles(ddr, t, base + (uint64_t)index[i] * sizeof(int));
+    cycles[i] = (int)latency;
+    t += latency + LATENCY_CALL_GAP_CYCLES;
+  }
+  return t;
+}
+
+void printPrediction(double measured_cycles, double predicted_cycles) {
+  printf("Predicted cycles: %.9g (DDR model; measured / predicted = %.3f)\n",
+         predicted_cycles, (predicted_cycles > 0) ? measured_cycles / predicted_cycles : 0.0);
+}
+
+} // ns aocl_utils
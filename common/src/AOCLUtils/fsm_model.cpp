@@ -0,0 +1,110 @@
+// Closed-form cycle counts of the DRAM_READ/DRAM_WRITE burst FSMs.
+
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "AOCLUtils/fsm_model.h"
+
+namespace aocl_utils {
+
+static double envDouble(const char *name, double default_value) {
+  const char *value = getenv(name);
+  return (value != NULL && *value != '\0') ? strtod(value, NULL) : default_value;
+}
+
+// Parameters
+/********************************************************************/
+FsmParams FsmParams::fromDdr(const DdrConfig &ddr) {
+  FsmParams p;
+  p.maxburst_log = 4;
+  p.data_width   = DdrModel::BEAT_BYTES * 8;
+  p.kernel_mhz   = ddr.kernel_mhz;
+
+  // As DdrModel times the first access to a closed bank
+  double ratio = ddr.kernel_mhz / ddr.mhz;
+  unsigned burst_bytes = ddr.bus_bytes * ddr.burst_length;
+  double beat_clocks = ((DdrModel::BEAT_BYTES + burst_bytes - 1) / burst_bytes) * ddr.burst_length / 2.0;
+  p.latency_cycles  = ddr.ctrl_cycles + ceil((ddr.trcd + ddr.tcl + beat_clocks) * ratio);
+  p.writeack_cycles = ddr.ctrl_cycles / 2 + ceil((ddr.trcd + ddr.tcwl + beat_clocks) * ratio);
+
+  // Peak bandwidth less the time spent refreshing
+  p.gbps = ddr.peakGBps() * (1.0 - ddr.trfc_ns / ddr.trefi_ns);
+  return p;
+}
+
+FsmParams FsmParams::fromEnv(double kernel_mhz) {
+  FsmParams p = fromDdr(DdrConfig::fromEnv(kernel_mhz));
+  p.latency_cycles  = envDouble("MEM_LATENCY_CYCLES", p.latency_cycles);
+  p.writeack_cycles = envDouble("MEM_WRITEACK_CYCLES", p.writeack_cycles);
+  p.gbps            = envDouble("MEM_GBPS", p.gbps);
+  if(p.latency_cycles < 1 || p.writeack_cycles < 1 || p.gbps <= 0) {
+    printf("ERROR: Invalid memory latency or throughput.\n");
+    exit(1);
+  }
+  return p;
+}
+
+void FsmParams::print() const {
+  printf("FSM model: bursts of %u x %u bits, memory latency %.0f cycles, writeack %.0f cycles, %.2f GB/s, kernel clock %.2f MHz\n",
+         1u << maxburst_log, data_width, latency_cycles, writeack_cycles, gbps, kernel_mhz);
+}
+
+double FsmParams::beatsPerCycle() const {
+  return gbps * 1.0e3 / (kernel_mhz * (data_width / 8));
+}
+
+
+// Cycle counts
+/********************************************************************/
+static uint64_t beatCount(const FsmParams &params, uint64_t datanum) {
+  uint64_t elems_per_beat = params.data_width / 32;
+  return (datanum + elems_per_beat - 1) / elems_per_beat;
+}
+
+uint64_t fsmReadCycles(const FsmParams &params, uint64_t datanum) {
+  uint64_t beats = beatCount(params, datanum);
+  if(beats == 0) {
+    return 0;
+  }
+  uint64_t maxburst = 1ULL << params.maxburst_log;
+  uint64_t bursts = (beats + maxburst - 1) / maxburst;
+  uint64_t last_burstcount = beats - (bursts - 1) * maxburst;
+  double rate = std::min(1.0, params.beatsPerCycle());
+
+  // The last beat is limited either by the data of all bursts or by when
+  // the last burst is requested, one every 2 cycles
+  double data_bound  = 3 + params.latency_cycles + (beats - 1) / rate;
+  double issue_bound = 3 + 2.0 * (bursts - 1) + params.latency_cycles + (last_burstcount - 1) / rate;
+  return (uint64_t)ceil(std::max(data_bound, issue_bound) - 1e-9);
+}
+
+uint64_t fsmWriteCycles(const FsmParams &params, uint64_t datanum) {
+  uint64_t beats = beatCount(params, datanum);
+  if(beats == 0) {
+    return 0;
+  }
+  uint64_t maxburst = 1ULL << params.maxburst_log;
+  uint64_t bursts = (beats + maxburst - 1) / maxburst;
+  double rate = std::min(1.0, params.beatsPerCycle());
+
+  // The last beat goes out after all beats and the bubbles between bursts,
+  // or as fast as the memory takes them
+  double last = 3 + std::max(double(beats + bursts - 2), (beats - 1) / rate);
+  double period = std::max(double(maxburst + 1), maxburst / rate);
+
+  // Acks come one burst period apart; the count stops at the first one
+  // after the last beat
+  uint64_t earlier = (uint64_t)floor((params.writeack_cycles - 1) / period);
+  earlier = std::min(earlier, bursts - 1);
+  double ack = last + params.writeack_cycles - earlier * period;
+  return (uint64_t)ceil(ack - 1 - 1e-9);
+}
+
+void printEfficiency(double measured_cycles, uint64_t bound_cycles) {
+  printf("FSM bound: %llu cycles (efficiency %.1f %%)\n", (unsigned long long)bound_cycles,
+         (measured_cycles > 0) ? 100.0 * bound_cycles / measured_cycles : 0.0);
+}
+
+} // ns aocl_utils
@@ -0,0 +1,101 @@
+// Kernel clock calibration.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+#include "AOCLUtils/aocx.h"
+#include "AOCLUtils/kernel_clock.h"
+
+namespace aocl_utils {
+
+double fitKernelMhz(const std::vector<ClockSample> &samples) {
+  size_t n = samples.size();
+  if(n < 2) {
+    return 0;
+  }
+  // Fit cycles = mhz * us + c
+  double mean_us = 0, mean_cycles = 0;
+  for(size_t i = 0; i < n; ++i) {
+    mean_us += samples[i].ns * 1.0e-3;
+    mean_cycles += samples[i].cycles;
+  }
+  mean_us /= n;
+  mean_cycles /= n;
+  double sxy = 0, sxx = 0;
+  for(size_t i = 0; i < n; ++i) {
+    double dx = samples[i].ns * 1.0e-3 - mean_us;
+    sxy += dx * (samples[i].cycles - mean_cycles);
+    sxx += dx * dx;
+  }
+  if(sxx <= 0) {
+    return 0;
+  }
+  double mhz = sxy / sxx;
+  return (mhz > 0 && isfinite(mhz)) ? mhz : 0;
+}
+
+// Returns the number after the first occurrence of `key` in the file, or 0
+static double findNumberAfter(const char *binary_file, const char *key) {
+  FILE *f = fopen(binary_file, "rb");
+  if(f == NULL) {
+    return 0;
+  }
+  // Read in chunks that overlap by the key and the number after it
+  const size_t chunk = 1 << 20, overlap = strlen(key) + 32;
+  std::string buffer;
+  std::vector<char> data(chunk);
+  double value = 0;
+  for(;;) {
+    size_t got = fread(data.data(), 1, chunk, f);
+    buffer.append(data.data(), got);
+    size_t pos = buffer.find(key);
+    if(pos != std::string::npos && (got == 0 || pos + overlap <= buffer.size())) {
+      value = strtod(buffer.c_str() + pos + strlen(key), NULL);
+      break;
+    }
+    if(got == 0) {
+      break;
+    }
+    if(buffer.size() > overlap) {
+      buffer.erase(0, buffer.size() - overlap);
+    }
+  }
+  fclose(f);
+  return value;
+}
+
+double getBinaryFmaxMhz(const char *binary_file) {
+  // The report section of the ELF file, else anywhere in the file
+  AocxInfo info;
+  if(readAocx(binary_file, &info) && info.fmax_mhz > 0) {
+    return info.fmax_mhz;
+  }
+  double mhz = findNumberAfter(binary_file, "Actual clock freq:");
+  if(mhz <= 0) {
+    mhz = findNumberAfter(binary_file, "Kernel fmax:");
+  }
+  return (mhz > 0) ? mhz : 0;
+}
+
+double selectKernelMhz(double measured_mhz, const char *binary_file) {
+  double fmax = getBinaryFmaxMhz(binary_file);
+  if(measured_mhz > 0) {
+    if(fmax > 0) {
+      printf("Kernel clock: %.3f MHz (measured; fmax of the AOCX %.3f MHz)\n", measured_mhz, fmax);
+    } else {
+      printf("Kernel clock: %.3f MHz (measured)\n", measured_mhz);
+    }
+    return measured_mhz;
+  }
+  if(fmax > 0) {
+    printf("Kernel clock: %.3f MHz (fmax of the AOCX; the measurement failed)\n", fmax);
+    return fmax;
+  }
+  printf("ERROR: Unable to determine the kernel clock; give the frequency in MHz instead of auto.\n");
+  exit(1);
+}
+
+} // ns aocl_utils
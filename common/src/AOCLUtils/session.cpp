@@ -0,0 +1,122 @@
+// Persistent OpenCL state for running many benchmark configurations.
+
+#include "AOCLUtils/aocl_utils.h"
+
+namespace aocl_utils {
+
+Session::Session(const char *platform_name)
+  : m_platform(NULL), m_num_devices(0), m_context_preloaded(false) {
+  m_platform = findPlatform(platform_name);
+  if(m_platform == NULL) {
+    printf("ERROR: Unable to find %s OpenCL platform.\n", platform_name);
+    exit(1);
+  }
+
+  m_devices.reset(getDevices(m_platform, CL_DEVICE_TYPE_ALL, &m_num_devices));
+  printf("Platform: %s\n", getPlatformName(m_platform).c_str());
+  printf("Using %d device(s)\n", m_num_devices);
+  for(unsigned i = 0; i < m_num_devices; ++i) {
+    printf("  %s\n", getDeviceName(m_devices[i]).c_str());
+  }
+}
+
+Session::~Session() {
+  release();
+}
+
+void Session::loadProgram(const std::string &prefix) {
+  std::string binary_file = getBoardBinaryFile(prefix.c_str(), m_devices[0]);
+  if(m_program != NULL && binary_file == m_binary_file) {
+    return;
+  }
+
+  // Kernels belong to the program; the queue and the buffers belong to the
+  // context and stay.
+  if(m_queue != NULL) {
+    clFinish(m_queue);
+  }
+  m_kernels.clear();
+  m_program.reset();
+  m_binary_file.clear();
+
+  printf("Using AOCX: %s\n", binary_file.c_str());
+  printAocxSummary(binary_file.c_str());
+  const char *state_file = getBitstreamStateFile();
+  bool resident = prepareBinaryLoad(state_file, binary_file.c_str(), m_devices, m_num_devices);
+
+  // The runtime reads the compiler mode when the context is created, so
+  // reusing the resident bitstream, or leaving a context that did, takes a
+  // new context. Otherwise the new program reconfigures the FPGA within the
+  // current context and the pooled buffers carry over.
+  if(m_context == NULL || resident || m_context_preloaded) {
+    release();
+    cl_int status;
+    m_context = clCreateContext(NULL, m_num_devices, m_devices, &oclContextCallback, NULL, &status);
+    checkError(status, "Failed to create context");
+    m_pool.setContext(m_context);
+  }
+  m_context_preloaded = resident;
+
+  m_program = loadProgramFromBinary(m_context, binary_file.c_str(), m_devices, m_num_devices, resident, state_file);
+  m_binary_file = binary_file;
+}
+
+cl_command_queue Session::queue() {
+  if(m_queue == NULL) {
+    cl_int status;
+    m_queue = clCreateCommandQueue(m_context, m_devices[0], CL_QUEUE_PROFILING_ENABLE, &status);
+    checkError(status, "Failed to create command queue");
+    traceQueue(m_queue, "session queue");
+  }
+  return m_queue;
+}
+
+cl_kernel Session::kernel(const std::string &name) {
+  KernelMap::iterator it = m_kernels.find(name);
+  if(it != m_kernels.end()) {
+    return it->second;
+  }
+
+  cl_int status;
+  scoped_cl_kernel &kernel = m_kernels[name];
+  kernel = clCreateKernel(m_program, name.c_str(), &status);
+  checkError(status, "Failed to create kernel %s", name.c_str());
+  return kernel;
+}
+
+cl_mem Session::buffer(const std::string &tag, cl_mem_flags flags, size_t size, bool *allocated) {
+  BufferPool::Lease &buf = m_buffers[tag];
+  bool reuse = (buf.get() != NULL && buf.flags() == flags && buf.size() >= size);
+  if(!reuse) {
+    // Give the old buffer back first so that the pool can reuse or trim it.
+    buf.release();
+    buf = m_pool.acquire(flags, size);
+  }
+  if(allocated != NULL) {
+    *allocated = !reuse;
+  }
+  return buf.get();
+}
+
+void Session::releaseBuffers() {
+  if(m_queue != NULL) {
+    clFinish(m_queue);
+  }
+  m_buffers.clear();
+}
+
+void Session::release() {
+  if(m_queue != NULL) {
+    clFinish(m_queue);
+  }
+  m_buffers.clear();
+  m_pool.trim();
+  m_kernels.clear();
+  m_queue.reset();
+  m_program.reset();
+  m_context.reset();
+  m_context_preloaded = false;
+  m_binary_file.clear();
+}
+
+} // ns aocl_utils
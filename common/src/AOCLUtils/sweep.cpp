@@ -0,0 +1,161 @@
+// Parameter sweep specifications.
+
+#include "AOCLUtils/aocl_utils.h"
+#include <errno.h>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <stdlib.h>
+
+namespace aocl_utils {
+
+static std::string trim(const std::string &s) {
+  size_t begin = s.find_first_not_of(" \t\r\n");
+  if(begin == std::string::npos) {
+    return std::string();
+  }
+  size_t end = s.find_last_not_of(" \t\r\n");
+  return s.substr(begin, end - begin + 1);
+}
+
+static std::vector<std::string> split(const std::string &s, const std::string &separators) {
+  std::vector<std::string> fields;
+  size_t begin = 0;
+  while(begin <= s.size()) {
+    size_t end = s.find_first_of(separators, begin);
+    if(end == std::string::npos) {
+      end = s.size();
+    }
+    std::string field = trim(s.substr(begin, end - begin));
+    if(!field.empty()) {
+      fields.push_back(field);
+    }
+    begin = end + 1;
+  }
+  return fields;
+}
+
+static void errorMalformed(const std::string &what) {
+  throw std::invalid_argument("malformed axis or range '" + what + "'");
+}
+
+static void errorNumber(const std::string &what) {
+  throw std::invalid_argument("not a count '" + what + "'");
+}
+
+unsigned long long parseCount(const std::string &value) {
+  const char *str = value.c_str();
+  // strtoull would negate a leading '-' into a huge count
+  if(trim(value).compare(0, 1, "-") == 0) {
+    errorNumber(value);
+  }
+  char *end;
+  errno = 0;
+  unsigned long long n = strtoull(str, &end, 0);
+  if(end == str || errno == ERANGE) {
+    errorNumber(value);
+  }
+  unsigned shift = 0;
+  switch(*end) {
+    case 'K': case 'k': shift = 10; ++end; break;
+    case 'M': case 'm': shift = 20; ++end; break;
+    case 'G': case 'g': shift = 30; ++end; break;
+    default: break;
+  }
+  if(*end != '\0' || n > (std::numeric_limits<size_t>::max() >> shift)) {
+    errorNumber(value);
+  }
+  return n << shift;
+}
+
+// Expands a value that may be a range into the list of values.
+static void expandValue(const std::string &value, std::vector<std::string> &values) {
+  size_t dots = value.find("..");
+  if(dots == std::string::npos) {
+    values.push_back(value);
+    return;
+  }
+
+  size_t op = value.find_first_of("*+", dots + 2);
+  if(op == std::string::npos) {
+    errorMalformed(value);
+  }
+  unsigned long long lo   = parseCount(value.substr(0, dots));
+  unsigned long long hi   = parseCount(value.substr(dots + 2, op - dots - 2));
+  unsigned long long step = parseCount(value.substr(op + 1));
+  bool geometric = (value[op] == '*');
+  if((geometric && (step < 2 || lo == 0)) || (!geometric && step == 0)) {
+    errorMalformed(value);
+  }
+
+  for(unsigned long long v = lo; v <= hi; v = geometric ? v * step : v + step) {
+    std::stringstream ss;
+    ss << v;
+    values.push_back(ss.str());
+    // Stop before the next step passes hi, so a hi near the top of the
+    // range cannot wrap v around.
+    if(geometric ? v > hi / step : step > hi - v) {
+      break;
+    }
+  }
+}
+
+// Throws std::invalid_argument if the specification is malformed.
+static std::vector<SweepPoint> expandSweep(const std::string &spec) {
+  std::vector<SweepPoint> points(1);
+
+  std::vector<std::string> axes = split(spec, ";\n");
+  for(size_t a = 0; a < axes.size(); ++a) {
+    size_t eq = axes[a].find('=');
+    if(eq == std::string::npos || eq == 0) {
+      errorMalformed(axes[a]);
+    }
+    std::string name = trim(axes[a].substr(0, eq));
+
+    std::vector<std::string> values;
+    std::vector<std::string> fields = split(axes[a].substr(eq + 1), ",");
+    for(size_t i = 0; i < fields.size(); ++i) {
+      expandValue(fields[i], values);
+    }
+    if(values.empty()) {
+      errorMalformed(axes[a]);
+    }
+
+    // Later axes vary fastest.
+    std::vector<SweepPoint> product;
+    product.reserve(points.size() * values.size());
+    for(size_t p = 0; p < points.size(); ++p) {
+      for(size_t v = 0; v < values.size(); ++v) {
+        product.push_back(points[p]);
+        product.back()[name] = values[v];
+      }
+    }
+    points.swap(product);
+  }
+
+  return points;
+}
+
+std::vector<SweepPoint> parseSweep(const std::string &spec) {
+  try {
+    return expandSweep(spec);
+  } catch(const std::invalid_argument &e) {
+    std::cerr << "Malformed sweep specification: " << e.what() << "\n";
+    exit(1);
+  }
+}
+
+unsigned long long getCount(const SweepPoint &point, const std::string &name,
+                            unsigned long long default_value) {
+  SweepPoint::const_iterator it = point.find(name);
+  return (it != point.end()) ? parseCount(it->second) : default_value;
+}
+
+std::string getString(const SweepPoint &point, const std::string &name,
+                      const std::string &default_value) {
+  SweepPoint::const_iterator it = point.find(name);
+  return (it != point.end()) ? it->second : default_value;
+}
+
+} // ns aocl_utils
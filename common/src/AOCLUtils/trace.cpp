@@ -0,0 +1,306 @@
+// Timeline of the OpenCL commands of a host, in the Chrome trace format.
+
+#include <list>
+#include <map>
+#include <mutex>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+
+#include "AOCLUtils/opencl.h"
+#include "AOCLUtils/trace.h"
+
+namespace aocl_utils {
+
+// Commands are written to the trace, and their events released, once they
+// have completed: when a TraceScope ends, every DRAIN_PENDING recorded
+// commands, and at traceWrite().
+static const size_t DRAIN_PENDING = 256;
+
+struct TracedCommand {
+  std::string name;
+  cl_event    event;
+  int         thread;
+  double      host;   // when the host enqueued it, seconds
+};
+
+struct TraceState {
+  std::mutex                               mutex;
+  std::string                              file;
+  FILE                                    *out;
+  bool                                     registered;
+  bool                                     written;
+  double                                   origin;      // of the timestamps, seconds
+  bool                                     has_offset;
+  double                                   offset_us;   // host - device
+  unsigned                                 count;       // commands written
+  std::list<TracedCommand>                 pending;     // stable addresses for traceEvent
+  std::map<std::thread::id, int>           threads;
+  std::map<cl_command_queue, int>          queues;
+  std::map<cl_command_queue, std::string>  queue_names;
+};
+
+// Never destroyed, so that it outlives everything that runs at exit
+static TraceState &trace() {
+  static TraceState *t = NULL;
+  static std::once_flag once;
+  std::call_once(once, [] {
+    t = new TraceState;
+    const char *file = getenv("AOCL_TRACE");
+    t->file = (file != NULL) ? file : "";
+    t->out = NULL;
+    t->registered = false;
+    t->written = false;
+    t->origin = getCurrentTimestamp();
+    t->has_offset = false;
+    t->offset_us = 0;
+    t->count = 0;
+  });
+  return *t;
+}
+
+static void writeAtExit() {
+  traceWrite();
+}
+
+// Called with the mutex held
+static int threadIndex(TraceState &t) {
+  if(!t.registered) {
+    atexit(writeAtExit);
+    t.registered = true;
+  }
+  std::map<std::thread::id, int>::iterator it = t.threads.find(std::this_thread::get_id());
+  if(it != t.threads.end()) {
+    return it->second;
+  }
+  int index = (int)t.threads.size();
+  t.threads[std::this_thread::get_id()] = index;
+  return index;
+}
+
+static std::string quote(const std::string &s) {
+  std::string q = "\"";
+  for(size_t i = 0; i < s.size(); ++i) {
+    if(s[i] == '"' || s[i] == '\\') {
+      q += '\\';
+    }
+    q += s[i];
+  }
+  return q + "\"";
+}
+
+static const char *category(cl_command_type type) {
+  switch(type) {
+    case CL_COMMAND_NDRANGE_KERNEL:
+    case CL_COMMAND_TASK:           return "kernel";
+    case CL_COMMAND_WRITE_BUFFER:   return "write";
+    case CL_COMMAND_READ_BUFFER:    return "read";
+    case CL_COMMAND_COPY_BUFFER:    return "copy";
+    case CL_COMMAND_MARKER:         return "marker";
+    default:                        return "command";
+  }
+}
+
+// Output, called with the mutex held
+/********************************************************************/
+// Returns the trace file, opened and started on first use; NULL if it cannot
+// be opened.
+static FILE *output(TraceState &t) {
+  if(t.out == NULL && !t.written) {
+    t.out = fopen(t.file.c_str(), "w");
+    if(t.out == NULL) {
+      printf("ERROR: Unable to open trace file %s.\n", t.file.c_str());
+      t.written = true;  // record nothing more
+      return NULL;
+    }
+    fprintf(t.out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(t.out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Host\"}},\n");
+    fprintf(t.out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":2,\"args\":{\"name\":\"Device\"}}");
+  }
+  return t.out;
+}
+
+// Writes a completed command and releases its event.
+static void writeCommand(TraceState &t, const TracedCommand &c) {
+  FILE *f = output(t);
+  cl_command_queue queue = NULL;
+  cl_command_type  type = 0;
+  clGetEventInfo(c.event, CL_EVENT_COMMAND_QUEUE, sizeof(queue), &queue, NULL);
+  clGetEventInfo(c.event, CL_EVENT_COMMAND_TYPE, sizeof(type), &type, NULL);
+
+  // Not available if the queue was created without profiling
+  cl_ulong stamps[4];
+  const cl_profiling_info info[4] = { CL_PROFILING_COMMAND_QUEUED, CL_PROFILING_COMMAND_SUBMIT,
+                                      CL_PROFILING_COMMAND_START, CL_PROFILING_COMMAND_END };
+  bool profiled = true;
+  for(int k = 0; k < 4 && profiled; ++k) {
+    profiled = clGetEventProfilingInfo(c.event, info[k], sizeof(cl_ulong), &stamps[k], NULL) == CL_SUCCESS;
+  }
+  clReleaseEvent(c.event);
+  if(f == NULL) {
+    return;
+  }
+
+  double host_us = (c.host - t.origin) * 1.0e6;
+  fprintf(f, ",\n{\"name\":%s,\"cat\":\"enqueue\",\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":%d,\"ts\":%.3f}",
+          quote("enqueue " + c.name).c_str(), c.thread, host_us);
+  if(!profiled) {
+    return;
+  }
+  if(t.queues.find(queue) == t.queues.end()) {
+    int index = (int)t.queues.size();
+    t.queues[queue] = index;
+  }
+  if(!t.has_offset) {
+    t.offset_us = host_us - stamps[0] * 1.0e-3;
+    t.has_offset = true;
+  }
+  double queued = stamps[0] * 1.0e-3 + t.offset_us, submit = stamps[1] * 1.0e-3 + t.offset_us;
+  double start  = stamps[2] * 1.0e-3 + t.offset_us, end    = stamps[3] * 1.0e-3 + t.offset_us;
+  int    track  = t.queues[queue];
+  fprintf(f, ",\n{\"name\":%s,\"cat\":\"%s\",\"ph\":\"X\",\"pid\":2,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f,"
+             "\"args\":{\"queued_us\":%.3f,\"submit_us\":%.3f,\"start_us\":%.3f,\"end_us\":%.3f,\"wait_us\":%.3f}}",
+          quote(c.name).c_str(), category(type), track, start, end - start, queued, submit, start, end, start - queued);
+  // The arrow from the enqueue to the command
+  fprintf(f, ",\n{\"name\":\"enqueue\",\"cat\":\"flow\",\"ph\":\"s\",\"id\":%u,\"pid\":1,\"tid\":%d,\"ts\":%.3f}",
+          t.count, c.thread, host_us);
+  fprintf(f, ",\n{\"name\":\"enqueue\",\"cat\":\"flow\",\"ph\":\"f\",\"bp\":\"e\",\"id\":%u,\"pid\":2,\"tid\":%d,\"ts\":%.3f}",
+          t.count, track, start);
+  ++t.count;
+}
+
+// Writes the pending commands that have completed, or all of them after
+// waiting for them with `wait`.
+static void drain(TraceState &t, bool wait) {
+  std::list<TracedCommand>::iterator it = t.pending.begin();
+  while(it != t.pending.end()) {
+    if(it->event == NULL) {
+      // Either the enqueue failed, or another thread is still in it
+      it = wait ? t.pending.erase(it) : ++it;
+      continue;
+    }
+    if(wait) {
+      clWaitForEvents(1, &it->event);
+    } else {
+      cl_int status = CL_COMPLETE;
+      clGetEventInfo(it->event, CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof(status), &status, NULL);
+      if(status > CL_COMPLETE) {
+        ++it;
+        continue;
+      }
+    }
+    writeCommand(t, *it);
+    it = t.pending.erase(it);
+  }
+}
+
+// Records a command, and every DRAIN_PENDING of them writes those done
+static void record(TraceState &t, const TracedCommand &command) {
+  if(t.pending.size() >= DRAIN_PENDING && t.pending.size() % DRAIN_PENDING == 0) {
+    drain(t, false);
+  }
+  t.pending.push_back(command);
+}
+
+// Recording
+/********************************************************************/
+bool traceEnabled() {
+  return !trace().file.empty();
+}
+
+cl_command_queue_properties traceQueueProperties(cl_command_queue_properties properties) {
+  return traceEnabled() ? (properties | CL_QUEUE_PROFILING_ENABLE) : properties;
+}
+
+void traceQueue(cl_command_queue queue, const char *name) {
+  if(!traceEnabled()) {
+    return;
+  }
+  TraceState &t = trace();
+  std::lock_guard<std::mutex> lock(t.mutex);
+  t.queue_names[queue] = name;
+}
+
+cl_event *traceEvent(const char *name) {
+  if(!traceEnabled()) {
+    return NULL;
+  }
+  TraceState &t = trace();
+  std::lock_guard<std::mutex> lock(t.mutex);
+  if(t.written) {
+    return NULL;
+  }
+  TracedCommand command = { name, NULL, threadIndex(t), getCurrentTimestamp() };
+  record(t, command);
+  return &t.pending.back().event;
+}
+
+void traceCommand(cl_event event, const char *name) {
+  if(!traceEnabled() || event == NULL) {
+    return;
+  }
+  TraceState &t = trace();
+  std::lock_guard<std::mutex> lock(t.mutex);
+  if(t.written) {
+    return;
+  }
+  clRetainEvent(event);
+  TracedCommand command = { name, event, threadIndex(t), getCurrentTimestamp() };
+  record(t, command);
+}
+
+TraceScope::TraceScope(const char *name)
+  : m_name(name),
+    m_start(traceEnabled() ? getCurrentTimestamp() : 0) {
+}
+
+TraceScope::~TraceScope() {
+  if(!traceEnabled()) {
+    return;
+  }
+  double end = getCurrentTimestamp();
+  TraceState &t = trace();
+  std::lock_guard<std::mutex> lock(t.mutex);
+  int thread = threadIndex(t);
+  FILE *f = output(t);
+  if(f != NULL) {
+    fprintf(f, ",\n{\"name\":%s,\"cat\":\"host\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+            quote(m_name).c_str(), thread, (m_start - t.origin) * 1.0e6, (end - m_start) * 1.0e6);
+  }
+  drain(t, false);
+}
+
+void traceWrite() {
+  if(!traceEnabled()) {
+    return;
+  }
+  TraceState &t = trace();
+  std::lock_guard<std::mutex> lock(t.mutex);
+  drain(t, true);
+  FILE *f = output(t);
+  if(f == NULL) {
+    return;
+  }
+  t.written = true;
+
+  // The names of the tracks, once all are known
+  for(std::map<std::thread::id, int>::iterator it = t.threads.begin(); it != t.threads.end(); ++it) {
+    fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"thread %d\"}}",
+            it->second, it->second);
+  }
+  for(std::map<cl_command_queue, int>::iterator it = t.queues.begin(); it != t.queues.end(); ++it) {
+    std::map<cl_command_queue, std::string>::iterator name = t.queue_names.find(it->first);
+    char default_name[32];
+    snprintf(default_name, sizeof(default_name), "queue %d", it->second);
+    fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":2,\"tid\":%d,\"args\":{\"name\":%s}}",
+            it->second, quote(name != t.queue_names.end() ? name->second : default_name).c_str());
+  }
+  fprintf(f, "\n]}\n");
+  fclose(f);
+  t.out = NULL;
+
+  printf("Trace: %u command(s) written to %s\n", t.count, t.file.c_str());
+}
+
+} // ns aocl_utils
@@ -0,0 +1,30 @@
+// Three regions of the tagged cycle counters (common/device/aocl_counters.h)
+// around wait_func: the whole kernel, one call of N cycles, and four calls
+// of N/4 cycles that add up under one region ID.
+
+#include "aocl_counters.h"
+
+#define REGION_ALL  0
+#define REGION_ONCE 1
+#define REGION_LOOP 2
+
+long wait_func(const long);
+
+AOCL_COUNTERS_COLLECTOR
+
+__attribute__((reqd_work_group_size(1,1,1)))
+__kernel void tb_regions(__global long *restrict result,
+                         const long N)
+{
+  aocl_counter_start(REGION_ALL);
+
+  aocl_counter_start(REGION_ONCE);
+  long sum = aocl_counter_stop_after(REGION_ONCE, wait_func(N));
+
+  for (int i = 0; i < 4; ++i) {
+    aocl_counter_start_after(REGION_LOOP, sum);
+    sum += aocl_counter_stop_after(REGION_LOOP, wait_func(N >> 2));
+  }
+
+  *result = aocl_counter_stop_after(REGION_ALL, sum);
+}
@@ -24,6 +24,10 @@
 // latency of memory load access
 //
 // Verification is performed on the RTL module on FPGA.
+//
+// With "sweep" for <datanum>, wait_func is run for a range of lengths and
+// the counted cycles are fitted against them (see sweep()). Only the fit of
+// tb_regions is saved, as only the tagged counters subtract it.
 ///////////////////////////////////////////////////////////////////////////////////
 
 #include <iostream>
@@ -46,17 +50,18 @@ static const int WIDTH = 512;
 // OpenCL runtime configuration
 /********************************************************************/
 cl_uint                                num_devices   = 0;
-cl_context                             context       = NULL;
-cl_command_queue                       command_queue = NULL;
-cl_program                             program       = NULL;
-cl_kernel                              kernel        = NULL;
+aocl_utils::scoped_cl_context          context;
+aocl_utils::scoped_cl_command_queue    command_queue;
+aocl_utils::scoped_cl_program          program;
+aocl_utils::scoped_cl_kernel           kernel;
 cl_platform_id                         platform      = NULL;
 cl_int                                 status;
-cl_event                               write_event[2], kernel_event, finish_event[2];
-cl_mem                                 E_buf;  // memory object for write
-cl_mem                                 M_buf;  // memory object for read
-cl_mem                                 C_buf;  // memory object for read
+aocl_utils::scoped_cl_event            write_event[2], kernel_event, finish_event[2];
+aocl_utils::scoped_cl_mem              E_buf;  // memory object for write
+aocl_utils::scoped_cl_mem              M_buf;  // memory object for read
+aocl_utils::scoped_cl_mem              C_buf;  // memory object for read
 aocl_utils::scoped_array<cl_device_id> device_id;
+aocl_utils::scoped_ptr<aocl_utils::CounterCollector> counters;  // tb_regions only
 
 
 // Application data on the host PC
@@ -64,9 +69,12 @@ aocl_utils::scoped_array<cl_device_id> device_id;
 aocl_utils::scoped_aligned_ptr<long> Y;        // an array to receive the computation results from the FPGA
 aocl_utils::scoped_aligned_ptr<long> X;        // an array to contain integer data sent to the FPGA
 size_t                              datanum;  // the number of integer values
+unsigned                            repeats;  // sweep: runs per length
 long                                expected_cycles;
 long                                measured_cycles;
 std::string                         mode;
+bool                                regions;  // tb_regions: the tagged counters instead of tb_wait_func
+double                              kernel_mhz;
 // size_t try_num;                         // the number of tries
 float  frequency;                       // the operating frequency (assuming MHz)
 
@@ -84,16 +92,20 @@ void run();
 void readbuf();
 void verify();
 void cleanup();
+void sweep();
 
 
 /********************************************************************/
 int main(int argc, char *argv[]) {
 
   // check command line arguments
-  if (argc == 1) { std::cout << "usage: ./host <name> <datanum>" << std::endl; exit(0); }
-  if (argc != 3) { std::cerr << "Error! The number of arguments is wrong." << std::endl; exit(1); }
+  if (argc == 1) { std::cout << "usage: ./host <name> <datanum>|sweep [repeats]" << std::endl; exit(0); }
+  if (argc != 3 && argc != 4) { std::cerr << "Error! The number of arguments is wrong." << std::endl; exit(1); }
   name      = argv[1];
-  datanum   = std::stoull(std::string(argv[2]));
+  bool sweeping = std::string(argv[2]) == "sweep";
+  datanum   = sweeping ? 1 : std::stoull(std::string(argv[2]));
+  repeats   = (argc == 4) ? std::stoul(std::string(argv[3])) : 10;
+  regions   = std::string(name) == "tb_regions";
   // datanum   = (1 << (std::stoull(std::string(argv[2]))));
   // mode      = argv[3];
   // frequency = std::stof(std::string(argv[4]));
@@ -103,6 +115,12 @@ int main(int argc, char *argv[]) {
   // init_data();
   init_opencl();
 
+  if (sweeping) {
+    sweep();
+    cleanup();
+    return 0;
+  }
+
   // kernel running
   run();
   
@@ -179,19 +197,27 @@ void init_opencl() {
   std::cout << "Using " << num_devices << " device(s)" << std::endl;
   std::cout << " " << aocl_utils::getDeviceName(device_id[0]).c_str() << std::endl;
   
+  // Select the binary for all device. Use the first device as the
+  // representative device (assuming all device are of the same type).
+  // Whether the bitstream is already resident must be known before the
+  // context is created.
+  std::string binary_file = aocl_utils::getBoardBinaryFile(name, device_id[0]);
+  std::cout << "Using AOCX: " << binary_file.c_str() << std::endl;
+  // Without touching the device: what the AOCX holds, and whether it has the kernel
+  aocl_utils::printAocxSummary(binary_file.c_str());
+  const char *kernel_names[] = {name, "aocl_counters_collect"};
+  if (!aocl_utils::checkAocxKernels(binary_file.c_str(), kernel_names, regions ? 2 : 1)) exit(1);
+  kernel_mhz = aocl_utils::getBinaryFmaxMhz(binary_file.c_str());
+  const char *state_file = aocl_utils::getBitstreamStateFile();
+  bool resident = aocl_utils::prepareBinaryLoad(state_file, binary_file.c_str(), device_id, num_devices);
+
   // Create the context.
   context = clCreateContext(NULL, num_devices, device_id, NULL, NULL, &status);
   aocl_utils::checkError(status, "Failed to create context");
 
-  // Create the program for all device. Use the first device as the
-  // representative device (assuming all device are of the same type).
-  std::string binary_file = aocl_utils::getBoardBinaryFile(name, device_id[0]);
-  std::cout << "Using AOCX: " << binary_file.c_str() << std::endl;
-  program = createProgramFromBinary(context, binary_file.c_str(), device_id, num_devices);
-  
-  // Build the program that was just created.
-  status = clBuildProgram(program, 0, NULL, "", NULL, NULL);
-  aocl_utils::checkError(status, "Failed to build program");
+  // Create and build the program, reconfiguring the FPGA unless the
+  // resident bitstream can be reused.
+  program = aocl_utils::loadProgramFromBinary(context, binary_file.c_str(), device_id, num_devices, resident, state_file);
 
   // kernel
   kernel = clCreateKernel(program, name, &status);
@@ -201,7 +227,7 @@ void init_opencl() {
   }
 
   // command queue
-  command_queue = clCreateCommandQueue(context, device_id[0], 0, &status);
+  command_queue = clCreateCommandQueue(context, device_id[0], aocl_utils::traceQueueProperties(CL_QUEUE_PROFILING_ENABLE), &status);
 
   // memory object_m
   E_buf = clCreateBuffer(context, CL_MEM_READ_WRITE | CL_CHANNEL_1_INTELFPGA, sizeof(long), NULL, &status);
@@ -217,27 +243,43 @@ void init_opencl() {
 
   // Set kernel arguments.
   unsigned argi = 0;
-  status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), &E_buf);   aocl_utils::checkError(status, "Failed to set argument expected");
-  status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), &M_buf);   aocl_utils::checkError(status, "Failed to set argument measured");
-  status = clSetKernelArg(kernel, argi++, sizeof(long),   &datanum); aocl_utils::checkError(status, "Failed to set argument N");
+  if (regions) {
+    counters.reset(new aocl_utils::CounterCollector(context, program));
+    counters->setName(0, "tb_regions");
+    counters->setName(1, "wait_func(N)");
+    counters->setName(2, "wait_func(N/4)");
+    status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), E_buf.ptr()); aocl_utils::checkError(status, "Failed to set argument result");
+    status = clSetKernelArg(kernel, argi++, sizeof(long),   &datanum);    aocl_utils::checkError(status, "Failed to set argument N");
+    return;
+  }
+  status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), E_buf.ptr()); aocl_utils::checkError(status, "Failed to set argument expected");
+  status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), M_buf.ptr()); aocl_utils::checkError(status, "Failed to set argument measured");
+  status = clSetKernelArg(kernel, argi++, sizeof(long),   &datanum);    aocl_utils::checkError(status, "Failed to set argument N");
   // status = clSetKernelArg(kernel, argi++, sizeof(cl_mem), &C_buf);   aocl_utils::checkError(status, "Failed to set argument C");
 }
 
 
 /********************************************************************/
 void run() {
-  status = clEnqueueNDRangeKernel(command_queue, kernel, 1, NULL, global_item_size, local_item_size, 0, NULL, &kernel_event);
+  status = clEnqueueNDRangeKernel(command_queue, kernel, 1, NULL, global_item_size, local_item_size, 0, NULL, kernel_event.out());
   aocl_utils::checkError(status, "Failed to launch kernel");
+  aocl_utils::traceCommand(kernel_event, "kernel");
 }
 
 
 /********************************************************************/
 void readbuf() {
   // device to host_m
-  status = clEnqueueReadBuffer(command_queue, E_buf, CL_TRUE, 0, sizeof(long), &expected_cycles, 1, &kernel_event, &finish_event[0]);
+  status = clEnqueueReadBuffer(command_queue, E_buf, CL_TRUE, 0, sizeof(long), &expected_cycles, 1, kernel_event.ptr(), finish_event[0].out());
   aocl_utils::checkError(status, "Failed to transfer output expected_cycles");
-  status = clEnqueueReadBuffer(command_queue, M_buf, CL_TRUE, 0, sizeof(long), &measured_cycles, 1, &kernel_event, &finish_event[1]);
+  aocl_utils::traceCommand(finish_event[0], "read E");
+  if (regions) {
+    counters->drain(command_queue, 1, kernel_event.ptr());
+    return;
+  }
+  status = clEnqueueReadBuffer(command_queue, M_buf, CL_TRUE, 0, sizeof(long), &measured_cycles, 1, kernel_event.ptr(), finish_event[1].out());
   aocl_utils::checkError(status, "Failed to transfer output measured_cycles");
+  aocl_utils::traceCommand(finish_event[1], "read M");
 }
 
 
@@ -269,23 +311,101 @@ void verify() {
   //   }
   // }
 
+  if (regions) {
+    std::cout << "result: " << expected_cycles << std::endl;
+    counters->print(kernel_mhz);
+    return;
+  }
+
   std::cout << "expected_cycles: " << expected_cycles << std::endl;
   std::cout << "measured_cycles: " << measured_cycles << std::endl;
   
 }
 
 
+/********************************************************************/
+// Runs wait_func for N and returns the cycles it took and what the counter
+// made of them: expected_cycles and measured_cycles of tb_wait_func, or
+// the region of the single call of tb_regions against what wait_func.v
+// returns for N (N + 2, see waitFuncResult), not N itself. Both kernels take
+// N as their last argument.
+void measure(long N, long &expected, long &measured) {
+  datanum = N;
+  status = clSetKernelArg(kernel, regions ? 1 : 2, sizeof(long), &datanum);
+  aocl_utils::checkError(status, "Failed to set argument N");
+  run();
+  readbuf();
+  expected = regions ? (long)aocl_utils::waitFuncResult(N) : expected_cycles;
+  measured = regions ? (long)counters->rawCycles(1) : measured_cycles;
+}
+
+
+/********************************************************************/
+// Sweeps wait_func over powers of two and random lengths, `repeats` runs
+// each, and fits measured = a * expected + b: b is the fixed overhead of
+// starting and stopping the counter, a any scaling error. The fit of
+// tb_regions is saved to AOCL_COUNTER_CALIBRATION for the CounterCollector
+// to subtract; that of tb_wait_func, on another counter, is only printed.
+void sweep() {
+  const long MAX_LENGTH = 1L << 20;
+  std::vector<long> lengths;
+  for (long n = 1; n <= MAX_LENGTH; n <<= 1) lengths.push_back(n);
+  std::mt19937_64 engine(1);
+  std::uniform_int_distribution<long> distribution(1, MAX_LENGTH);
+  for (int i = 0; i < 16; ++i) lengths.push_back(distribution(engine));
+
+  std::vector<aocl_utils::CounterSample> samples;
+  std::cout << std::setw(10) << "N" << std::setw(12) << "expected" << std::setw(14) << "measured"
+            << std::setw(12) << "overhead" << std::setw(8) << "min" << std::setw(8) << "max" << std::endl;
+  for (size_t i = 0; i < lengths.size(); ++i) {
+    long   expected = 0, measured = 0;
+    double sum = 0, lo = 0, hi = 0;
+    for (unsigned r = 0; r < repeats; ++r) {
+      measure(lengths[i], expected, measured);
+      aocl_utils::CounterSample sample = {(double)expected, (double)measured};
+      samples.push_back(sample);
+      double overhead = (double)(measured - expected);
+      sum += measured;
+      lo = (r == 0) ? overhead : std::min(lo, overhead);
+      hi = (r == 0) ? overhead : std::max(hi, overhead);
+    }
+    std::cout << std::setw(10) << lengths[i] << std::setw(12) << expected
+              << std::setw(14) << std::fixed << std::setprecision(1) << sum / repeats
+              << std::setw(12) << sum / repeats - expected << std::setw(8) << lo << std::setw(8) << hi << std::endl;
+  }
+
+  aocl_utils::CounterCalibration calibration;
+  if (!aocl_utils::fitCounterCalibration(samples, calibration)) {
+    std::cerr << "ERROR: the sweep does not determine a fit" << std::endl;
+    exit(1);
+  }
+  std::cout << std::setprecision(6);
+  std::cout << "fit: measured = " << calibration.scale << " * expected + " << calibration.offset
+            << " (" << calibration.samples << " samples)" << std::endl;
+  std::cout << "residuals: rms " << calibration.residual_rms << ", max " << calibration.residual_max << " cycles" << std::endl;
+
+  const char *file = aocl_utils::getCounterCalibrationFile();
+  if (!regions) {
+    std::cout << "Not saved: tb_wait_func counts on cnt_start/cnt_stop, not on the tagged counters (sweep tb_regions)" << std::endl;
+  } else if (file != NULL && aocl_utils::saveCounterCalibration(file, calibration)) {
+    std::cout << "Counter calibration saved to " << file << std::endl;
+  }
+}
+
+
 /********************************************************************/
 void cleanup() {
-  for (int i = 0; i < 2; ++i) clReleaseEvent(write_event[i]);
+  for (int i = 0; i < 2; ++i) write_event[i].reset();
+  kernel_event.reset();
   clFlush(command_queue);
   clFinish(command_queue);
-  clReleaseMemObject(E_buf);
-  clReleaseMemObject(M_buf);
-  clReleaseMemObject(C_buf);
-  clReleaseKernel(kernel);
-  for (int i = 0; i < 2; ++i) clReleaseEvent(finish_event[i]);
-  clReleaseProgram(program);
-  clReleaseCommandQueue(command_queue);
-  clReleaseContext(context);
+  E_buf.reset();
+  M_buf.reset();
+  C_buf.reset();
+  kernel.reset();
+  counters.reset();
+  for (int i = 0; i < 2; ++i) finish_event[i].reset();
+  program.reset();
+  command_queue.reset();
+  context.reset();
 }
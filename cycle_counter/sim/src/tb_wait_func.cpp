@@ -0,0 +1,213 @@
+// Verilator harness for cycle_counter/device/wait_func.v
+//
+// Does what tb_wait_func does on the FPGA, one clock edge at a time: calls
+// wait_func(N) for `expected`, writes cnt_start, calls wait_func(N) again,
+// writes its result to cnt_stop and reads `measured` from cnt_rslt. The io
+// channels are served by CycleCounterModel; the aoc schedule between the
+// handshakes is the call and stop gap of the model (CNT_* variables).
+//
+// Environment: SIM_TIMEOUT_CYCLES [2^32] bounds a run; SIM_VCD names a
+// waveform file when the harness is built with TRACE=1.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+#include "Vwait_func.h"
+#include "verilated.h"
+#if VM_TRACE
+#include "verilated_vcd_c.h"
+#endif
+
+#include "AOCLUtils/counter_model.h"
+
+double sc_time_stamp() { return 0; }
+
+class WaitFuncSim {
+public:
+  explicit WaitFuncSim(const aocl_utils::CounterConfig &config)
+    : m_config(config), m_top(new Vwait_func), m_counter(config), m_cycle(0), m_valid_out_cycles(0), m_trace(NULL) {
+    const char *timeout = getenv("SIM_TIMEOUT_CYCLES");
+    m_timeout = (timeout != NULL) ? strtoull(timeout, NULL, 0) : (1ULL << 32);
+#if VM_TRACE
+    const char *vcd = getenv("SIM_VCD");
+    if(vcd != NULL) {
+      Verilated::traceEverOn(true);
+      m_trace = new VerilatedVcdC;
+      m_top->trace(m_trace, 99);
+      m_trace->open(vcd);
+    }
+#endif
+    m_top->clock = 0;
+    m_top->resetn = 0;
+    m_top->m_valid_in = 0;
+    m_top->m_ready_in = 0;
+    m_top->m_input_value = 0;
+    for(unsigned i = 0; i < 4; ++i) {
+      tick(false, false, false);
+    }
+    m_top->resetn = 1;
+    tick(false, false, false);
+  }
+
+  ~WaitFuncSim() {
+    m_top->final();
+#if VM_TRACE
+    if(m_trace != NULL) {
+      m_trace->close();
+      delete m_trace;
+    }
+#endif
+    delete m_top;
+  }
+
+  // One run of tb_wait_func with argument n
+  aocl_utils::TbWaitFuncTiming run(uint64_t n) {
+    enum Phase { FIRST_CALL, FIRST_RETURN, CALL, SECOND_RETURN, STOP, READ, DONE };
+    Phase    phase = FIRST_CALL;
+    uint64_t deadline = m_cycle + m_timeout;
+    uint64_t first_call = 0, start_at = 0, call_at = 0, stop_at = 0;
+    aocl_utils::TbWaitFuncTiming t = {0, 0, 0};
+
+    m_top->m_input_value = n;
+    while(phase != DONE) {
+      bool valid_in = (phase == FIRST_CALL) || (phase == CALL && m_cycle >= call_at);
+      bool start = (phase == CALL && m_cycle == start_at);
+      bool stop = (phase == STOP && m_cycle == stop_at);
+      bool read = (phase == READ);
+      uint64_t result = m_counter.result();
+      uint64_t e = m_cycle;
+
+      m_top->m_valid_in = valid_in;
+      Edge edge = tick(start, stop, read);
+
+      switch(phase) {
+      case FIRST_CALL:
+        if(edge.started) { first_call = e; phase = FIRST_RETURN; }
+        break;
+      case FIRST_RETURN:
+        if(edge.returned) {
+          // cnt_start once wait_func is ready again
+          t.expected = edge.output;
+          start_at = e + 1;
+          call_at = start_at + m_config.call_gap;
+          phase = CALL;
+        }
+        break;
+      case CALL:
+        if(edge.started) phase = SECOND_RETURN;
+        break;
+      case SECOND_RETURN:
+        if(edge.returned) { stop_at = e + m_config.stop_gap; phase = STOP; }
+        break;
+      case STOP:
+        if(stop) phase = READ;
+        break;
+      case READ:
+        if(edge.taken) { t.measured = result; t.kernel_cycles = e - first_call; phase = DONE; }
+        break;
+      case DONE:
+        break;
+      }
+      if(m_cycle >= deadline) {
+        fprintf(stderr, "ERROR: tb_wait_func did not finish within %llu cycles.\n", (unsigned long long)m_timeout);
+        exit(1);
+      }
+    }
+    m_top->m_valid_in = 0;
+    return t;
+  }
+
+private:
+  struct Edge {
+    bool     started;   // wait_func took N at this edge
+    bool     returned;  // wait_func returned at this edge
+    uint64_t output;
+    bool     taken;     // the result of cnt_rslt was read at this edge
+  };
+
+  Edge tick(bool start, bool stop, bool read) {
+    // Inputs of this cycle
+    m_top->m_ready_in = (m_top->m_valid_out && m_valid_out_cycles >= m_config.ready_delay);
+    m_top->clock = 0;
+    m_top->eval();
+    dump(2 * m_cycle);
+
+    // Everything the module and the counter see at the rising edge
+    Edge edge;
+    edge.started = m_top->resetn && m_top->m_ready_out && m_top->m_valid_in;
+    edge.returned = m_top->resetn && m_top->m_valid_out && m_top->m_ready_in;
+    edge.output = m_top->m_output_value;
+    m_valid_out_cycles = m_top->m_valid_out ? m_valid_out_cycles + 1 : 0;
+    aocl_utils::CycleCounterModel::Inputs in = { start, stop, read };
+    edge.taken = m_counter.edge(in);
+
+    m_top->clock = 1;
+    m_top->eval();
+    dump(2 * m_cycle + 1);
+    ++m_cycle;
+    return edge;
+  }
+
+  void dump(uint64_t time) {
+#if VM_TRACE
+    if(m_trace != NULL) {
+      m_trace->dump(time);
+    }
+#else
+    (void)time;
+#endif
+  }
+
+  aocl_utils::CounterConfig         m_config;
+  Vwait_func                       *m_top;
+  aocl_utils::CycleCounterModel     m_counter;
+  uint64_t                          m_cycle;
+  uint64_t                          m_valid_out_cycles;
+  uint64_t                          m_timeout;
+#if VM_TRACE
+  VerilatedVcdC *m_trace;
+#else
+  void          *m_trace;
+#endif
+
+  // noncopyable
+  WaitFuncSim(const WaitFuncSim &);
+  WaitFuncSim &operator =(const WaitFuncSim &);
+};
+
+/********************************************************************/
+int main(int argc, char *argv[]) {
+  Verilated::commandArgs(argc, argv);
+
+  // check command line arguments
+  if(argc == 1) { printf("usage: ./tb_wait_func <N> [<N> ...]\n"); exit(0); }
+
+  aocl_utils::CounterConfig config = aocl_utils::CounterConfig::fromEnv();
+  config.print();
+
+  WaitFuncSim sim(config);
+  bool error = false;
+  printf("%10s %10s %10s %10s %14s %10s\n", "N", "expected", "measured", "overhead", "kernel cycles", "model");
+  for(int i = 1; i < argc; ++i) {
+    uint64_t n = std::stoull(std::string(argv[i]));
+    aocl_utils::TbWaitFuncTiming t = sim.run(n);
+    aocl_utils::TbWaitFuncTiming p = aocl_utils::predictTbWaitFunc(config, n);
+    bool match = (t.expected == p.expected && t.measured == p.measured && t.kernel_cycles == p.kernel_cycles);
+    printf("%10llu %10llu %10llu %10lld %14llu %10s\n", (unsigned long long)n, (unsigned long long)t.expected,
+           (unsigned long long)t.measured, (long long)(t.measured - t.expected), (unsigned long long)t.kernel_cycles,
+           match ? "match" : "MISMATCH");
+    if(!match) {
+      printf("  model: expected %llu, measured %llu, kernel cycles %llu\n", (unsigned long long)p.expected,
+             (unsigned long long)p.measured, (unsigned long long)p.kernel_cycles);
+      error = true;
+    }
+  }
+  if(error) {
+    printf("Error! The RTL and the model disagree.\n");
+    return 1;
+  }
+  printf("Overhead of the counter: %u cycles\n", config.overheadCycles());
+  return 0;
+}
@@ -85,7 +85,7 @@ int main() {
   size_t gSize[3] = {work_group_size, 1, 1};
 
   // Launch the kernel
-  status = clEnqueueNDRangeKernel(queue, kernel, 1, NULL, gSize, wgSize, 0, NULL, NULL);
+  status = clEnqueueNDRangeKernel(queue, kernel, 1, NULL, gSize, wgSize, 0, NULL, traceEvent("kernel"));
   checkError(status, "Failed to launch kernel");
 
   // Wait for command queue to complete pending events
@@ -141,22 +141,28 @@ bool init() {
   // Display some device information.
   display_device_info(device);
 
+  // Select the binary. Whether it is already resident on the device must be
+  // known before the context is created.
+  std::string binary_file = getBoardBinaryFile("hello_world", device);
+  printf("Using AOCX: %s\n", binary_file.c_str());
+  // Without touching the device: what the AOCX holds, and whether it has the kernel
+  const char *kernel_names[] = {"hello_world"};
+  printAocxSummary(binary_file.c_str());
+  if (!checkAocxKernels(binary_file.c_str(), kernel_names, 1)) return false;
+  const char *state_file = getBitstreamStateFile();
+  bool resident = prepareBinaryLoad(state_file, binary_file.c_str(), &device, 1);
+
   // Create the context.
   context = clCreateContext(NULL, 1, &device, &oclContextCallback, NULL, &status);
   checkError(status, "Failed to create context");
 
   // Create the command queue.
-  queue = clCreateCommandQueue(context, device, CL_QUEUE_PROFILING_ENABLE, &status);
+  queue = clCreateCommandQueue(context, device, traceQueueProperties(CL_QUEUE_PROFILING_ENABLE), &status);
   checkError(status, "Failed to create command queue");
 
-  // Create the program.
-  std::string binary_file = getBoardBinaryFile("hello_world", device);
-  printf("Using AOCX: %s\n", binary_file.c_str());
-  program = createProgramFromBinary(context, binary_file.c_str(), &device, 1);
-
-  // Build the program that was just created.
-  status = clBuildProgram(program, 0, NULL, "", NULL, NULL);
-  checkError(status, "Failed to build program");
+  // Create and build the program, reconfiguring the FPGA unless the
+  // resident bitstream can be reused.
+  program = loadProgramFromBinary(context, binary_file.c_str(), &device, 1, resident, state_file);
 
   // Create the kernel - name passed in here must match kernel name in the
   // original CL file, that was compiled into an AOCX file using the AOC tool
@@ -0,0 +1,33 @@
+#pragma OPENCL EXTENSION cl_intel_channels : enable
+
+// Pipelined ring all-reduce (sum) of float16 vectors over the ring of
+// ring.cl: tx0 of each rank to rx1 of the next. data is `ranks` chunks of
+// `chunk` words. In each step every rank sends one chunk to the next and
+// adds (reduce-scatter) or copies (all-gather) the one from the previous,
+// word by word, so the ring streams like one pipeline: 2 (ranks - 1) steps
+// of `chunk` words, each crossing one link.
+
+channel float16 ring_ot __attribute__((depth(0), io("tx0")));
+channel float16 ring_in __attribute__((depth(0), io("rx1")));
+
+__kernel void allreduce(__global float16* restrict data, int chunk, int ranks, int rank) {
+  // Reduce-scatter: afterwards chunk (rank + 1) % ranks holds the full sum
+  for (int s = 0; s < ranks - 1; s++) {
+    int send = (rank - s + ranks) % ranks;
+    int recv = (rank - s - 1 + ranks) % ranks;
+    for (int w = 0; w < chunk; w++) {
+      write_channel_intel(ring_ot, data[send * chunk + w]);
+      float16 v = read_channel_intel(ring_in);
+      data[recv * chunk + w] += v;
+    }
+  }
+  // All-gather: pass the full sums on round the ring
+  for (int s = 0; s < ranks - 1; s++) {
+    int send = (rank + 1 - s + ranks) % ranks;
+    int recv = (rank - s + ranks) % ranks;
+    for (int w = 0; w < chunk; w++) {
+      write_channel_intel(ring_ot, data[send * chunk + w]);
+      data[recv * chunk + w] = read_channel_intel(ring_in);
+    }
+  }
+}
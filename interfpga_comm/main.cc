@@ -1,4 +1,12 @@
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <math.h>
+#include <new>
 #include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
 #include <mpi.h>
 #include <fcntl.h>
 #include <unistd.h>
@@ -27,6 +35,557 @@
 #include <CL/cl_ext_intelfpga.h>
 #pragma GCC diagnostic pop
 
+#include "AOCLUtils/opencl.h"
+#include "AOCLUtils/counters.h"
+#include "AOCLUtils/kernel_clock.h"
+#include "AOCLUtils/sweep.h"
+
+// Called by aocl_utils::checkError before it exits
+void cleanup() {}
+
+// "64,256,1K" -> {64, 256, 1024}, or a range such as "64..16K*4", in the
+// syntax of the sweep parser (AOCLUtils/sweep.h); aborts all ranks on a
+// malformed value
+static std::vector<size_t> parse_list(std::string const& list) {
+  std::vector<size_t> values;
+  try {
+    for (auto const& point : aocl_utils::parseSweep("value=" + list)) {
+      values.push_back(aocl_utils::getCount(point, "value", 0));
+    }
+  } catch (std::invalid_argument const& e) {
+    fprintf(stderr, "ERROR: %s\n", e.what());
+    MPI_Abort(MPI_COMM_WORLD, 1);
+  }
+  return values;
+}
+
+// std::vector storage from aocl_utils::alignedMalloc, so that host buffers
+// meet the 64-byte alignment the runtime needs to DMA them in place
+template <typename T>
+struct AlignedAllocator {
+  typedef T value_type;
+  AlignedAllocator() = default;
+  template <typename U> AlignedAllocator(AlignedAllocator<U> const&) {}
+  T* allocate(size_t n) {
+    void* p = aocl_utils::alignedMalloc(sizeof(T) * n);
+    if (!p) throw std::bad_alloc();
+    return static_cast<T*>(p);
+  }
+  void deallocate(T* p, size_t) { aocl_utils::alignedFree(p); }
+};
+template <typename T, typename U>
+bool operator==(AlignedAllocator<T> const&, AlignedAllocator<U> const&) { return true; }
+template <typename T, typename U>
+bool operator!=(AlignedAllocator<T> const&, AlignedAllocator<U> const&) { return false; }
+
+typedef std::vector<cl_float16, AlignedAllocator<cl_float16>> Payload;
+
+// A payload of float16 words as main() makes it: random, with s15 zero
+static void fill_payload(Payload& words, unsigned seed) {
+  std::mt19937 g(seed);
+  std::uniform_real_distribution<float> d;
+  for (auto& v : words) {
+    for (int j = 0; j < 15; j++) v.s[j] = d(g);
+    v.s[15] = 0;  // must be zero
+  }
+}
+
+///// Ping-pong (pingpong.cl) /////
+// Usage: interfpga_comm.exe pingpong.aocx pingpong [iters] [bytes,...] [mhz]
+// Rank 1 echoes every message back to rank 0, and ping times each round
+// trip on the tagged BSP counter. Rank 0 prints, per message size, the
+// percentiles and a histogram of the round trips, less the counter overhead
+// fitted by the cycle_counter sweep (AOCL_COUNTER_CALIBRATION), in ns at
+// `mhz` (default: the fmax of the AOCX), or in cycles if there is no clock.
+// An echo that differs from its message makes the exit status non-zero.
+
+static double percentile(std::vector<double> const& sorted, double fraction) {
+  size_t i = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+  return sorted[std::min(i, sorted.size() - 1)];
+}
+
+// 20 buckets from the minimum to p99.9, and the rest in one more
+static void print_histogram(std::vector<double> const& sorted, char const* unit) {
+  size_t const buckets = 20;
+  double const lo = sorted.front();
+  double const hi = std::max(percentile(sorted, 0.999), lo + 1);
+  double const width = (hi - lo) / buckets;
+  std::vector<size_t> counts(buckets + 1, 0);
+  for (auto x : sorted) {
+    counts[(x >= hi) ? buckets : std::min(buckets - 1, static_cast<size_t>((x - lo) / width))]++;
+  }
+  size_t const peak = *std::max_element(counts.begin(), counts.end());
+  for (size_t b = 0; b <= buckets; b++) {
+    if (b == buckets && counts[b] == 0) break;
+    char range[64];
+    if (b < buckets) {
+      snprintf(range, sizeof(range), "[%9.1f, %9.1f) %s", lo + b * width, lo + (b + 1) * width, unit);
+    } else {
+      snprintf(range, sizeof(range), "[%9.1f,       max] %s", hi, unit);
+    }
+    printf("  %s %8zu %s\n", range, counts[b], std::string(counts[b] * 50 / peak, '#').c_str());
+  }
+}
+
+static int pingpong(int rank, int, cl::Context const& ctx, cl::Device const& dev, cl::Program const& prg, int argc, char** argv) {
+  int const iters = std::max(1, (argc > 3) ? atoi(argv[3]) : 10000);
+  std::vector<size_t> const sizes = parse_list((argc > 4) ? argv[4] : "64,256,1024,4096,16384");
+  double mhz = (argc > 5) ? atof(argv[5]) : aocl_utils::getBinaryFmaxMhz(argv[1]);
+
+  aocl_utils::CounterCalibration calibration = {1.0, 0.0, 0.0, 0.0, 0};
+  char const* calibration_file = aocl_utils::getCounterCalibrationFile();
+  if (calibration_file && !aocl_utils::loadCounterCalibration(calibration_file, calibration)) {
+    calibration = {1.0, 0.0, 0.0, 0.0, 0};
+  }
+  if (rank == 0) {
+    printf("Ping-pong: %d round trips per size, kernel clock %.1f MHz, counter overhead %.2f cycles\n",
+           iters, mhz, calibration.offset);
+  }
+
+  cl::CommandQueue cq(ctx, dev);
+  cl::KernelFunctor<cl::Buffer, cl::Buffer, cl_int, cl_int, cl::Buffer> f_ping(cl::Kernel(prg, "ping"));
+  cl::KernelFunctor<cl_int, cl_int> f_pong(cl::Kernel(prg, "pong"));
+
+  int errors = 0;
+
+  for (auto bytes : sizes) {
+    int const words = std::max<int>(1, (bytes + sizeof(cl_float16) - 1) / sizeof(cl_float16));
+    size_t const msg_size = sizeof(cl_float16) * words;
+
+    Payload h_send(words), h_echo(words);
+    std::vector<cl_ulong> h_cycles(iters);
+    fill_payload(h_send, 12345 + words);
+    cl::Buffer d_send(ctx, CL_MEM_READ_ONLY, msg_size);
+    cl::Buffer d_echo(ctx, CL_MEM_WRITE_ONLY, msg_size);
+    cl::Buffer d_cycles(ctx, CL_MEM_WRITE_ONLY, sizeof(cl_ulong) * iters);
+    if (rank == 0) {
+      cq.enqueueWriteBuffer(d_send, CL_TRUE, 0, msg_size, h_send.data());
+    }
+
+    // Both kernels wait on the link, so neither rank has to be first
+    MPI_Barrier(MPI_COMM_WORLD);
+    switch (rank) {
+      case 0:
+        f_ping(cl::EnqueueArgs(cq, cl::NDRange(1), cl::NDRange(1)), d_send, d_echo, words, iters, d_cycles);
+        break;
+      case 1:
+        f_pong(cl::EnqueueArgs(cq, cl::NDRange(1), cl::NDRange(1)), words, iters);
+        break;
+    }
+    cq.finish();
+    MPI_Barrier(MPI_COMM_WORLD);
+    if (rank != 0) continue;
+
+    cq.enqueueReadBuffer(d_echo, CL_TRUE, 0, msg_size, h_echo.data());
+    cq.enqueueReadBuffer(d_cycles, CL_TRUE, 0, sizeof(cl_ulong) * iters, h_cycles.data());
+    if (memcmp(h_send.data(), h_echo.data(), msg_size) != 0) {
+      fprintf(stderr, "ERROR: the echo of %zu bytes differs from the message\n", msg_size);
+      errors++;
+    }
+
+    std::vector<double> rtt(iters);
+    for (int i = 0; i < iters; i++) {
+      double const cycles = (h_cycles[i] - calibration.offset) / calibration.scale;
+      rtt[i] = (mhz > 0) ? cycles * 1.0e3 / mhz : cycles;
+    }
+    std::sort(rtt.begin(), rtt.end());
+    double mean = 0;
+    for (auto x : rtt) mean += x / iters;
+    char const* unit = (mhz > 0) ? "ns" : "cycles";
+    printf("bytes=%zu rtt_%s: min=%.1f p50=%.1f p90=%.1f p99=%.1f p99.9=%.1f max=%.1f mean=%.1f one_way_p50=%.1f\n",
+           msg_size, unit, rtt.front(), percentile(rtt, 0.5), percentile(rtt, 0.9), percentile(rtt, 0.99),
+           percentile(rtt, 0.999), rtt.back(), mean, percentile(rtt, 0.5) / 2);
+    print_histogram(rtt, unit);
+  }
+  return errors ? 1 : 0;
+}
+
+///// Streaming bandwidth (test.cl) /////
+// Usage: interfpga_comm.exe test.aocx stream [uni|bi] [messages,...] [bytes,...] [tries] [link_gbps]
+// Streams `messages` messages of `bytes` (padded to float16 words) with send
+// and recv over tx0/rx1: rank 0 to rank 1 (uni), or both ways at once (bi,
+// send and recv on their own queues on each rank). The device buffers are
+// made once for the largest point and reused by all of them; points larger
+// than CL_DEVICE_MAX_MEM_ALLOC_SIZE are skipped. Rank 0 prints
+// the goodput per direction, message bytes over the longer of the send and
+// recv kernel times, against the serial link rate (`link_gbps`) and the
+// channel rate (512 bits per cycle at the fmax of the AOCX).
+static int stream(int rank, int, cl::Context const& ctx, cl::Device const& dev, cl::Program const& prg, int argc, char** argv) {
+  bool const bidir = argc > 3 && std::string(argv[3]) == "bi";
+  std::vector<size_t> const counts = parse_list((argc > 4) ? argv[4] : "1K,16K");
+  std::vector<size_t> const sizes = parse_list((argc > 5) ? argv[5] : "64,1K,16K");
+  int const tries = std::max(1, (argc > 6) ? atoi(argv[6]) : 3);
+  double const link_gbps = (argc > 7) ? atof(argv[7]) : 40.0;
+  double const mhz = aocl_utils::getBinaryFmaxMhz(argv[1]);
+  double const channel_gbps = 512 * mhz * 1.0e-3;
+  bool const sends = bidir || rank == 0;
+  bool const recvs = bidir || rank == 1;
+
+  // One buffer holds all messages of a point
+  size_t const max_alloc = dev.getInfo<CL_DEVICE_MAX_MEM_ALLOC_SIZE>();
+  auto point_words = [](size_t count, size_t bytes) {
+    return count * ((bytes + sizeof(cl_float16) - 1) / sizeof(cl_float16));
+  };
+  size_t max_words = 1;
+  for (auto count : counts) {
+    for (auto bytes : sizes) {
+      size_t const words = point_words(count, bytes);
+      if (sizeof(cl_float16) * words <= max_alloc) max_words = std::max(max_words, words);
+    }
+  }
+  size_t const max_size = sizeof(cl_float16) * max_words;
+  if (rank == 0) {
+    printf("Streaming %s: up to %zu bytes, link %.1f Gbit/s, channel %.1f Gbit/s (%s)\n",
+           bidir ? "both ways" : "rank 0 to rank 1", max_size, link_gbps, channel_gbps,
+           (mhz > 0) ? "fmax of the AOCX" : "no fmax in the AOCX");
+  }
+
+  // Payload of this rank, and that of the peer to check what arrives
+  Payload h_send(max_words), h_recv(max_words), h_expect(max_words);
+  fill_payload(h_send, 12345 + rank);
+  fill_payload(h_expect, 12345 + (rank ^ 1));
+
+  cl::CommandQueue cq0(ctx, dev, CL_QUEUE_PROFILING_ENABLE);
+  cl::CommandQueue cq1(ctx, dev, CL_QUEUE_PROFILING_ENABLE);
+  cl::KernelFunctor<cl::Buffer, cl_int, cl_int> f_send(cl::Kernel(prg, "send"));
+  cl::KernelFunctor<cl::Buffer, cl_int, cl_int> f_recv(cl::Kernel(prg, "recv"));
+  cl::Buffer d_send(ctx, CL_MEM_READ_ONLY, max_size);
+  cl::Buffer d_recv(ctx, CL_MEM_WRITE_ONLY, max_size);
+  if (sends) {
+    cq0.enqueueWriteBuffer(d_send, CL_TRUE, 0, max_size, h_send.data());
+  }
+
+  for (auto count : counts) {
+    for (auto bytes : sizes) {
+      if (point_words(count, bytes) > max_words) {
+        if (rank == 0) {
+          printf("stream mode=%s messages=%zu bytes=%zu skipped: %zu bytes exceed CL_DEVICE_MAX_MEM_ALLOC_SIZE (%zu)\n",
+                 bidir ? "bi" : "uni", count, bytes, sizeof(cl_float16) * point_words(count, bytes), max_alloc);
+        }
+        continue;
+      }
+      int const words = point_words(count, bytes);
+      double send_ns = 0, recv_ns = 0;
+      int errors = 0;
+      for (int t = 0; t < tries; t++) {
+        // A pattern the payload never has, so that a try that delivers
+        // nothing does not pass on what an earlier try or point left
+        if (recvs) cq1.enqueueFillBuffer(d_recv, cl_uint(0xdeadbeef), 0, sizeof(cl_float16) * words);
+        cq1.finish();
+
+        // recv first: it only waits on the link, while send needs a reader
+        MPI_Barrier(MPI_COMM_WORLD);
+        cl::Event send_event, recv_event;
+        if (recvs) recv_event = f_recv(cl::EnqueueArgs(cq1, cl::NDRange(1), cl::NDRange(1)), d_recv, words, rank);
+        if (sends) send_event = f_send(cl::EnqueueArgs(cq0, cl::NDRange(1), cl::NDRange(1)), d_send, words, rank);
+        cq0.finish();
+        cq1.finish();
+        if (sends) {
+          send_ns += send_event.getProfilingInfo<CL_PROFILING_COMMAND_END>() - send_event.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+        }
+        if (recvs) {
+          recv_ns += recv_event.getProfilingInfo<CL_PROFILING_COMMAND_END>() - recv_event.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+          cq1.enqueueReadBuffer(d_recv, CL_TRUE, 0, sizeof(cl_float16) * words, h_recv.data());
+          errors += memcmp(h_recv.data(), h_expect.data(), sizeof(cl_float16) * words) != 0;
+        }
+      }
+
+      double times[2] = {send_ns / tries, recv_ns / tries}, slowest[2];
+      int all_errors;
+      MPI_Reduce(times, slowest, 2, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+      MPI_Reduce(&errors, &all_errors, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+      if (rank != 0) continue;
+
+      double const ns = std::max(slowest[0], slowest[1]);
+      double const goodput_gbps = count * bytes * 8 / ns;
+      printf("stream mode=%s messages=%zu bytes=%zu send_us=%.3f recv_us=%.3f goodput_gbps=%.3f aggregate_gbps=%.3f link_efficiency=%.3f",
+             bidir ? "bi" : "uni", count, bytes, slowest[0] * 1.0e-3, slowest[1] * 1.0e-3, goodput_gbps,
+             goodput_gbps * (bidir ? 2 : 1), goodput_gbps / link_gbps);
+      if (channel_gbps > 0) printf(" channel_efficiency=%.3f", goodput_gbps / channel_gbps);
+      printf("%s\n", all_errors ? " ERROR: payload differs" : "");
+    }
+  }
+  return 0;
+}
+
+///// N-rank ring (ring.cl) /////
+// Usage: interfpga_comm.exe ring.aocx ring [bytes,...] [tries]
+// The ranks' boards are cabled in a ring, tx0 to rx1 of the next. Rank 0
+// streams each payload round the ring, and every other rank forwards it.
+// MPI only starts the ranks together; rank 0 checks what comes back and
+// prints the time of the trip and the throughput of the ring.
+static int ring(int rank, int ranks, cl::Context const& ctx, cl::Device const& dev, cl::Program const& prg, int argc, char** argv) {
+  std::vector<size_t> const sizes = parse_list((argc > 3) ? argv[3] : "64,4K,256K,16M");
+  int const tries = std::max(1, (argc > 4) ? atoi(argv[4]) : 3);
+
+  size_t max_words = 1;
+  for (auto bytes : sizes) max_words = std::max(max_words, (bytes + sizeof(cl_float16) - 1) / sizeof(cl_float16));
+  Payload h_src(max_words), h_dst(max_words);
+  fill_payload(h_src, 12345);
+
+  cl::CommandQueue cq(ctx, dev, CL_QUEUE_PROFILING_ENABLE);
+  cl::KernelFunctor<cl::Buffer, cl::Buffer, cl_int, cl_int> f_ring(cl::Kernel(prg, "ring"));
+  cl::Buffer d_src(ctx, CL_MEM_READ_ONLY, sizeof(cl_float16) * max_words);
+  cl::Buffer d_dst(ctx, CL_MEM_WRITE_ONLY, sizeof(cl_float16) * max_words);
+  if (rank == 0) {
+    cq.enqueueWriteBuffer(d_src, CL_TRUE, 0, sizeof(cl_float16) * max_words, h_src.data());
+    printf("Ring of %d ranks\n", ranks);
+  }
+
+  for (auto bytes : sizes) {
+    int const words = std::max<int>(1, (bytes + sizeof(cl_float16) - 1) / sizeof(cl_float16));
+    double ns = 0;
+    bool ok = true;
+    for (int t = 0; t < tries; t++) {
+      // A pattern the payload never has, so that a trip that brings nothing
+      // back does not pass on what an earlier try or size left
+      if (rank == 0) cq.enqueueFillBuffer(d_dst, cl_uint(0xdeadbeef), 0, sizeof(cl_float16) * words);
+      cq.finish();
+
+      MPI_Barrier(MPI_COMM_WORLD);
+      cl::Event event = f_ring(cl::EnqueueArgs(cq, cl::NDRange(1), cl::NDRange(1)), d_src, d_dst, words, rank == 0);
+      cq.finish();
+      ns += event.getProfilingInfo<CL_PROFILING_COMMAND_END>() - event.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+      if (rank == 0) {
+        cq.enqueueReadBuffer(d_dst, CL_TRUE, 0, sizeof(cl_float16) * words, h_dst.data());
+        ok = ok && memcmp(h_src.data(), h_dst.data(), sizeof(cl_float16) * words) == 0;
+      }
+    }
+    if (rank != 0) continue;
+
+    ns /= tries;
+    printf("ring ranks=%d bytes=%zu trip_us=%.3f throughput_gbps=%.3f%s\n", ranks, sizeof(cl_float16) * words,
+           ns * 1.0e-3, sizeof(cl_float16) * words * 8 / ns, ok ? "" : " ERROR: payload differs");
+  }
+  return 0;
+}
+
+///// Ring all-reduce (allreduce.cl) /////
+// Usage: interfpga_comm.exe allreduce.aocx allreduce [bytes,...] [tries]
+// Sums a float16 vector of `bytes` (padded to a multiple of ranks words)
+// over all ranks with the allreduce kernel, and the same vector staged
+// through the host: read from the board, MPI_Allreduce, written back. MPI
+// only starts the ranks together and checks the kernel against
+// MPI_Allreduce. Rank 0 prints the algorithmic bandwidth (bytes / time) and
+// the bus bandwidth (times 2 (ranks - 1) / ranks, the bytes each link
+// carries) of both.
+static int allreduce(int rank, int ranks, cl::Context const& ctx, cl::Device const& dev, cl::Program const& prg, int argc, char** argv) {
+  std::vector<size_t> const sizes = parse_list((argc > 3) ? argv[3] : "4K,256K,16M");
+  int const tries = std::max(1, (argc > 4) ? atoi(argv[4]) : 3);
+
+  size_t max_words = 1;
+  for (auto bytes : sizes) {
+    size_t const chunk = std::max<size_t>(1, (bytes / sizeof(cl_float16) + ranks - 1) / ranks);
+    max_words = std::max(max_words, chunk * ranks);
+  }
+  size_t const max_size = sizeof(cl_float16) * max_words;
+  Payload h_data(max_words), h_result(max_words), h_stage(max_words), h_expect(max_words);
+  fill_payload(h_data, 12345 + rank);
+
+  cl::CommandQueue cq(ctx, dev, CL_QUEUE_PROFILING_ENABLE);
+  cl::KernelFunctor<cl::Buffer, cl_int, cl_int, cl_int> f_allreduce(cl::Kernel(prg, "allreduce"));
+  cl::Buffer d_data(ctx, CL_MEM_READ_WRITE, max_size);
+  if (rank == 0) printf("Ring all-reduce of %d ranks\n", ranks);
+
+  for (auto bytes : sizes) {
+    int const chunk = std::max<size_t>(1, (bytes / sizeof(cl_float16) + ranks - 1) / ranks);
+    size_t const size = sizeof(cl_float16) * chunk * ranks;
+
+    // On the boards
+    double fpga_ns = 0;
+    for (int t = 0; t < tries; t++) {
+      cq.enqueueWriteBuffer(d_data, CL_TRUE, 0, size, h_data.data());
+      MPI_Barrier(MPI_COMM_WORLD);
+      cl::Event event = f_allreduce(cl::EnqueueArgs(cq, cl::NDRange(1), cl::NDRange(1)), d_data, chunk, ranks, rank);
+      cq.finish();
+      fpga_ns += event.getProfilingInfo<CL_PROFILING_COMMAND_END>() - event.getProfilingInfo<CL_PROFILING_COMMAND_START>();
+    }
+    cq.enqueueReadBuffer(d_data, CL_TRUE, 0, size, h_result.data());
+
+    // Staged through the hosts; its result is the reference
+    double host_ns = 0, mpi_ns = 0;
+    for (int t = 0; t < tries; t++) {
+      cq.enqueueWriteBuffer(d_data, CL_TRUE, 0, size, h_data.data());
+      MPI_Barrier(MPI_COMM_WORLD);
+      double const start = MPI_Wtime();
+      cq.enqueueReadBuffer(d_data, CL_TRUE, 0, size, h_stage.data());
+      double const mpi_start = MPI_Wtime();
+      MPI_Allreduce(h_stage.data(), h_expect.data(), 16 * chunk * ranks, MPI_FLOAT, MPI_SUM, MPI_COMM_WORLD);
+      mpi_ns += (MPI_Wtime() - mpi_start) * 1.0e9;
+      cq.enqueueWriteBuffer(d_data, CL_TRUE, 0, size, h_expect.data());
+      host_ns += (MPI_Wtime() - start) * 1.0e9;
+    }
+
+    // The kernel adds in ring order, MPI in its own: compare with a tolerance
+    int errors = 0;
+    for (size_t i = 0; i < (size_t)chunk * ranks; i++) {
+      for (int j = 0; j < 16; j++) {
+        float const e = h_expect[i].s[j];
+        if (fabsf(h_result[i].s[j] - e) > 1.0e-5f * ranks * std::max(1.0f, fabsf(e))) errors++;
+      }
+    }
+
+    double local[3] = {fpga_ns / tries, host_ns / tries, mpi_ns / tries}, slowest[3];
+    int all_errors;
+    MPI_Reduce(local, slowest, 3, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(&errors, &all_errors, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (rank != 0) continue;
+
+    double const bus = 2.0 * (ranks - 1) / ranks;
+    printf("allreduce ranks=%d bytes=%zu fpga_us=%.3f fpga_algbw_gbs=%.3f fpga_busbw_gbs=%.3f "
+           "host_us=%.3f mpi_us=%.3f host_algbw_gbs=%.3f host_busbw_gbs=%.3f speedup=%.2f%s\n",
+           ranks, size, slowest[0] * 1.0e-3, size / slowest[0], size / slowest[0] * bus,
+           slowest[1] * 1.0e-3, slowest[2] * 1.0e-3, size / slowest[1], size / slowest[1] * bus,
+           slowest[1] / slowest[0], all_errors ? " ERROR: sums differ from MPI_Allreduce" : "");
+  }
+  return 0;
+}
+
+///// FPGA link vs host-staged MPI (test.cl) /////
+// Usage: interfpga_comm.exe test.aocx compare [bytes,...] [chunk] [tries]
+// Moves the same payload from the board of rank 0 to the board of rank 1:
+//   link       send/recv over tx0/rx1
+//   staged     enqueueReadBuffer, MPI_Send, MPI_Recv, enqueueWriteBuffer
+//   pipelined  the staged path in chunks of `chunk` bytes, so that the read
+//              of one chunk, MPI and the write of another overlap
+// Each time runs from a barrier to the payload being in the memory of the
+// board of rank 1 (the slower rank), launch and transfer overheads included,
+// and is averaged over `tries`. Rank 0 prints latency and bandwidth per
+// size, and the size from which the link is the faster path.
+
+// Runs `transfer` on every rank from a barrier; returns the longest time in us.
+template <typename Transfer>
+static double timed_us(Transfer transfer) {
+  MPI_Barrier(MPI_COMM_WORLD);
+  double const start = MPI_Wtime();
+  transfer();
+  double elapsed = (MPI_Wtime() - start) * 1.0e6, longest;
+  MPI_Allreduce(&elapsed, &longest, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  return longest;
+}
+
+static void staged_transfer(int rank, cl::CommandQueue& cq, cl::Buffer const& d_send, cl::Buffer const& d_recv,
+                            std::vector<char, AlignedAllocator<char>>& host, size_t size, size_t chunk) {
+  size_t const chunks = (size + chunk - 1) / chunk;
+  std::vector<MPI_Request> requests(chunks);
+  if (rank == 0) {
+    std::vector<cl::Event> reads(chunks);
+    for (size_t k = 0; k < chunks; k++) {
+      size_t const offset = k * chunk;
+      cq.enqueueReadBuffer(d_send, CL_FALSE, offset, std::min(chunk, size - offset), &host[offset], nullptr, &reads[k]);
+    }
+    cq.flush();
+    for (size_t k = 0; k < chunks; k++) {
+      size_t const offset = k * chunk;
+      reads[k].wait();
+      MPI_Isend(&host[offset], std::min(chunk, size - offset), MPI_BYTE, 1, k, MPI_COMM_WORLD, &requests[k]);
+    }
+    MPI_Waitall(chunks, requests.data(), MPI_STATUSES_IGNORE);
+  } else if (rank == 1) {
+    for (size_t k = 0; k < chunks; k++) {
+      size_t const offset = k * chunk;
+      MPI_Irecv(&host[offset], std::min(chunk, size - offset), MPI_BYTE, 0, k, MPI_COMM_WORLD, &requests[k]);
+    }
+    for (size_t k = 0; k < chunks; k++) {
+      size_t const offset = k * chunk;
+      MPI_Wait(&requests[k], MPI_STATUS_IGNORE);
+      cq.enqueueWriteBuffer(d_recv, CL_FALSE, offset, std::min(chunk, size - offset), &host[offset]);
+    }
+    cq.finish();
+  }
+}
+
+static int compare(int rank, int, cl::Context const& ctx, cl::Device const& dev, cl::Program const& prg, int argc, char** argv) {
+  std::vector<size_t> const sizes = parse_list((argc > 3) ? argv[3] : "64,1K,16K,256K,4M,32M");
+  size_t const chunk = std::max<size_t>(sizeof(cl_float16), parse_list((argc > 4) ? argv[4] : "1M").at(0));
+  int const tries = std::max(1, (argc > 5) ? atoi(argv[5]) : 5);
+
+  size_t max_words = 1;
+  for (auto bytes : sizes) max_words = std::max(max_words, (bytes + sizeof(cl_float16) - 1) / sizeof(cl_float16));
+  size_t const max_size = sizeof(cl_float16) * max_words;
+  Payload h_payload(max_words), h_zero(max_words), h_check(max_words);
+  fill_payload(h_payload, 12345);
+  memset(h_zero.data(), 0, max_size);
+  std::vector<char, AlignedAllocator<char>> host(max_size);
+
+  cl::CommandQueue cq(ctx, dev);
+  cl::KernelFunctor<cl::Buffer, cl_int, cl_int> f_send(cl::Kernel(prg, "send"));
+  cl::KernelFunctor<cl::Buffer, cl_int, cl_int> f_recv(cl::Kernel(prg, "recv"));
+  cl::Buffer d_send(ctx, CL_MEM_READ_ONLY, max_size);
+  cl::Buffer d_recv(ctx, CL_MEM_WRITE_ONLY, max_size);
+  if (rank == 0) {
+    cq.enqueueWriteBuffer(d_send, CL_TRUE, 0, max_size, h_payload.data());
+    printf("Rank 0 to rank 1: FPGA link vs host-staged MPI (chunks of %zu bytes), %d tries\n", chunk, tries);
+  }
+
+  // Times one path, and counts in `errors` whether it delivered the payload
+  auto measure = [&](size_t size, int& errors, std::function<void()> const& transfer) {
+    double us = 0;
+    for (int t = 0; t < tries; t++) {
+      if (rank == 1) cq.enqueueWriteBuffer(d_recv, CL_TRUE, 0, size, h_zero.data());
+      us += timed_us(transfer);
+    }
+    if (rank == 1) {
+      cq.enqueueReadBuffer(d_recv, CL_TRUE, 0, size, h_check.data());
+      errors += memcmp(h_check.data(), h_payload.data(), size) != 0;
+    }
+    return us / tries;
+  };
+
+  long crossover = -1;
+  for (auto bytes : sizes) {
+    int const words = std::max<int>(1, (bytes + sizeof(cl_float16) - 1) / sizeof(cl_float16));
+    size_t const size = sizeof(cl_float16) * words;
+
+    // Per size and per path, so that one bad transfer flags only itself
+    static char const* const paths[] = {"link", "staged", "pipelined"};
+    int errors[3] = {0, 0, 0};
+    double const link_us = measure(size, errors[0], [&] {
+      if (rank == 0) f_send(cl::EnqueueArgs(cq, cl::NDRange(1), cl::NDRange(1)), d_send, words, rank);
+      if (rank == 1) f_recv(cl::EnqueueArgs(cq, cl::NDRange(1), cl::NDRange(1)), d_recv, words, rank);
+      cq.finish();
+    });
+    double const staged_us = measure(size, errors[1], [&] { staged_transfer(rank, cq, d_send, d_recv, host, size, size); });
+    double const pipelined_us = measure(size, errors[2], [&] { staged_transfer(rank, cq, d_send, d_recv, host, size, chunk); });
+
+    int all_errors[3];
+    MPI_Reduce(errors, all_errors, 3, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    if (rank != 0) continue;
+
+    double const best_staged_us = std::min(staged_us, pipelined_us);
+    bool const link_faster = link_us < best_staged_us;
+    if (link_faster && crossover < 0) crossover = size;
+    if (!link_faster) crossover = -1;
+    printf("compare bytes=%zu link_us=%.3f link_gbps=%.3f staged_us=%.3f staged_gbps=%.3f pipelined_us=%.3f pipelined_gbps=%.3f faster=%s",
+           size, link_us, size * 8 / (link_us * 1.0e3), staged_us, size * 8 / (staged_us * 1.0e3),
+           pipelined_us, size * 8 / (pipelined_us * 1.0e3), link_faster ? "link" : "staged");
+    for (int k = 0; k < 3; k++) {
+      if (all_errors[k]) printf(" ERROR: %s payload differs", paths[k]);
+    }
+    printf("\n");
+  }
+  if (rank == 0) {
+    if (crossover < 0) {
+      printf("The host-staged path is faster at the largest size\n");
+    } else {
+      printf("The FPGA link is faster from %ld bytes on\n", crossover);
+    }
+  }
+  return 0;
+}
+
+// interfpga_comm.exe <aocx> <mode> ...: the modes above, each with its own
+// usage. Without a mode, the transfer of main() itself.
+typedef int (*Mode)(int rank, int ranks, cl::Context const& ctx, cl::Device const& dev, cl::Program const& prg,
+                    int argc, char** argv);
+static std::map<std::string, Mode> const modes = {
+  {"pingpong",  pingpong},
+  {"stream",    stream},
+  {"ring",      ring},
+  {"allreduce", allreduce},
+  {"compare",   compare},
+};
+
 int main(int argc, char** argv) {
 
   MPI_Init(&argc, &argv);
@@ -106,20 +665,29 @@ int main(int argc, char** argv) {
   auto prg = clCreateProgramWithBinary(ctx(), 1, &dev_cl, &len, &image, nullptr, &error);
   cl::detail::errHandler(error, "clCreateProgramWithBinary");
 
+  cl::Program const program(prg, true);
+  auto const mode = (argc > 2) ? modes.find(argv[2]) : modes.end();
+  if (mode != modes.end()) {
+    int const result = mode->second(rank, size, ctx, dev, program, argc, argv);
+    MPI_Finalize();
+    return result;
+  }
+
   ///// Create command queue /////
   cl::CommandQueue cq0(ctx, dev);
   cl::CommandQueue cq1(ctx, dev);
     
   ///// Create kernel /////
-  cl::Kernel k_send(cl::Program(prg, true), "send");
-  cl::Kernel k_recv(cl::Program(prg, true), "recv");
+  cl::Kernel k_send(program, "send");
+  cl::Kernel k_recv(program, "recv");
 
   ///// Create kernel functor /////
   cl::KernelFunctor<cl::Buffer, cl_int, cl_int> f_send(k_send);
   cl::KernelFunctor<cl::Buffer, cl_int, cl_int> f_recv(k_recv);
     
   ///// Create buffer (for host and device) /////
-  size_t const numdata = 1;
+  // interfpga_comm.exe test.aocx [numdata]: numdata float16 from rank 0 to rank 1
+  size_t const numdata = (argc > 2) ? parse_list(argv[2]).at(0) : 1;
   size_t const BUF_SIZE = sizeof(cl_float16) * numdata;
 
   // host
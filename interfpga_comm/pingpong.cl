@@ -0,0 +1,45 @@
+#pragma OPENCL EXTENSION cl_intel_channels : enable
+
+// Ping-pong over the board link: rank 0 runs ping, rank 1 runs pong, both on
+// tx0/rx1 as in test.cl. A message is `words` float16 (64 bytes each). ping
+// times every round trip, from its first write to its last read, on region 0
+// of the tagged BSP counters, and reads and clears the counter before the
+// next one. pong echoes word by word, so that the link, not a store and
+// forward, sets the latency. As in ring.cl, ping interleaves non-blocking
+// writes and reads, so a message longer than the link buffers cannot stall
+// on the echo.
+
+#include "aocl_counters.h"
+
+#define REGION_ROUND_TRIP 0
+
+channel float16 ping_ot __attribute__((depth(0), io("tx0")));
+channel float16 ping_in __attribute__((depth(0), io("rx1")));
+
+__kernel void ping(__global const float16* restrict data, __global float16* restrict echo,
+                   int words, int iters, __global ulong* restrict cycles) {
+  for (int i = 0; i < iters; i++) {
+    aocl_counter_start_after(REGION_ROUND_TRIP, i);
+    int sent = 0, received = 0;
+    float16 last;
+    while (received < words) {
+      if (sent < words) {
+        if (write_channel_nb_intel(ping_ot, data[sent])) sent++;
+      }
+      bool valid;
+      float16 v = read_channel_nb_intel(ping_in, &valid);
+      if (valid) {
+        echo[received++] = v;
+        last = v;
+      }
+    }
+    aocl_counter_stop_after(REGION_ROUND_TRIP, as_int(last.s0));
+    cycles[i] = aocl_counter_query(REGION_ROUND_TRIP | AOCL_COUNTER_QUERY_CLEAR);
+  }
+}
+
+__kernel void pong(int words, int iters) {
+  for (int i = 0; i < iters * words; i++) {
+    write_channel_intel(ping_ot, read_channel_intel(ping_in));
+  }
+}
@@ -0,0 +1,28 @@
+#pragma OPENCL EXTENSION cl_intel_channels : enable
+
+// N-rank ring: the boards are cabled in a ring, tx0 of each to rx1 of the
+// next. Rank 0 (origin) streams n float16 words into the ring and takes them
+// back after they have gone all the way round; every other rank forwards
+// from rx1 to tx0. The origin writes and reads without blocking, so that a
+// stream longer than the ring holds does not stall on its own tail.
+
+channel float16 ring_ot __attribute__((depth(0), io("tx0")));
+channel float16 ring_in __attribute__((depth(0), io("rx1")));
+
+__kernel void ring(__global const float16* restrict src, __global float16* restrict dst, int n, int origin) {
+  if (origin) {
+    int sent = 0, received = 0;
+    while (received < n) {
+      if (sent < n) {
+        if (write_channel_nb_intel(ring_ot, src[sent])) sent++;
+      }
+      bool valid;
+      float16 v = read_channel_nb_intel(ring_in, &valid);
+      if (valid) dst[received++] = v;
+    }
+  } else {
+    for (int i = 0; i < n; i++) {
+      write_channel_intel(ring_ot, read_channel_intel(ring_in));
+    }
+  }
+}
@@ -1,5 +1,10 @@
 #pragma OPENCL EXTENSION cl_intel_channels : enable
 
+// Without -D options: send/recv over ch0, for interkernel_comm.exe. With
+// -DTYPE and -DDEPTH: one send/recv pair of the channel sweep instead, and
+// with -DFAN_N: the fan-out and fan-in kernels of one replication factor.
+#if !defined(TYPE) && !defined(FAN_N)
+
 channel float8 ch0 __attribute__((depth(16)));
 
 __kernel void send(__global float8* restrict data, int n) {
@@ -15,3 +20,117 @@ __kernel void recv(__global float8* restrict data, int n) {
     data[i] = v;
   }
 }
+
+#endif
+
+// Channel sweep of aoclbench (the interkernel test): the send/recv pair
+// send_<type>_d<depth> and recv_<type>_d<depth> of one payload type and
+// channel depth, built alone with -DTYPE=<type> -DDEPTH=<depth> into
+// test_<type>_d<depth>.aocx (make gen_channels), so that each measures a
+// two-kernel design. The lists are in aoclbench/host/src/interkernel.cc.
+#define CHANNEL_PAIR(type, d)                                                   \
+  channel type ch_##type##_d##d __attribute__((depth(d)));                      \
+                                                                                \
+  __kernel void send_##type##_d##d(__global type* restrict data, int n) {       \
+    for (int i = 0; i < n; i++) {                                               \
+      write_channel_intel(ch_##type##_d##d, data[i]);                           \
+    }                                                                           \
+  }                                                                             \
+                                                                                \
+  __kernel void recv_##type##_d##d(__global type* restrict data, int n) {       \
+    for (int i = 0; i < n; i++) {                                               \
+      data[i] = read_channel_intel(ch_##type##_d##d);                           \
+    }                                                                           \
+  }
+
+// Expands TYPE and DEPTH before they are pasted into the names
+#define CHANNEL_PAIR_OF(type, d) CHANNEL_PAIR(type, d)
+
+#if defined(TYPE) && defined(DEPTH)
+CHANNEL_PAIR_OF(TYPE, DEPTH)
+#endif
+
+// Fan-out and fan-in over channel arrays, for the fan test of aoclbench
+// (aoclbench/host/src/fan.cc), with N = 2, 4 or 8 given by -DFAN_N and built
+// into test_fan<N>.aocx (make gen_fan):
+//   fanout_send_rr_N / fanout_send_hash_N  one producer feeding fo<N>_ch[N]
+//   fanout_recv_N_k                        worker k, draining fo<N>_ch[k]
+//   fanin_send_N_k                         producer k, feeding fi<N>_ch[k]
+//   fanin_recv_N                           one collector polling fi<N>_ch[N]
+// Each worker and fan-in producer gets its count from the host, which
+// splits the values the same way (round robin, or FAN_HASH of the bits of
+// s0). The collector stores the values in arrival order.
+#define FAN_HASH(v, N) ((((uint)(as_uint((v).s0) * 2654435761u)) >> 16) % (N))
+
+#define FAN_CHANNELS(N)                                                         \
+  channel float8 fo##N##_ch[N] __attribute__((depth(16)));                      \
+  channel float8 fi##N##_ch[N] __attribute__((depth(16)));
+
+#define FAN_OUT_SEND(N, name, select)                                           \
+  __kernel void fanout_send_##name##_##N(__global float8* restrict data, int n) { \
+    for (int i = 0; i < n; i++) {                                               \
+      float8 v = data[i];                                                       \
+      int w = (select);                                                         \
+      _Pragma("unroll")                                                         \
+      for (int c = 0; c < N; c++) {                                             \
+        if (c == w) write_channel_intel(fo##N##_ch[c], v);                      \
+      }                                                                         \
+    }                                                                           \
+  }
+
+#define FAN_OUT_RECV(N, k)                                                      \
+  __kernel void fanout_recv_##N##_##k(__global float8* restrict data, int n) { \
+    for (int i = 0; i < n; i++) {                                               \
+      data[i] = read_channel_intel(fo##N##_ch[k]);                              \
+    }                                                                           \
+  }
+
+#define FAN_IN_SEND(N, k)                                                       \
+  __kernel void fanin_send_##N##_##k(__global float8* restrict data, int n) {  \
+    for (int i = 0; i < n; i++) {                                               \
+      write_channel_intel(fi##N##_ch[k], data[i]);                              \
+    }                                                                           \
+  }
+
+#define FAN_IN_RECV(N)                                                          \
+  __kernel void fanin_recv_##N(__global float8* restrict data, int n) {        \
+    int received = 0;                                                           \
+    int c = 0;                                                                  \
+    while (received < n) {                                                      \
+      bool valid = false;                                                       \
+      float8 v;                                                                 \
+      _Pragma("unroll")                                                         \
+      for (int k = 0; k < N; k++) {                                             \
+        if (k == c) v = read_channel_nb_intel(fi##N##_ch[k], &valid);           \
+      }                                                                         \
+      if (valid) data[received++] = v;                                          \
+      c = (c == N - 1) ? 0 : c + 1;                                             \
+    }                                                                           \
+  }
+
+#define FAN(N)                                                                  \
+  FAN_CHANNELS(N)                                                               \
+  FAN_OUT_SEND(N, rr, i % N)                                                    \
+  FAN_OUT_SEND(N, hash, FAN_HASH(v, N))                                         \
+  FAN_IN_RECV(N)
+
+#if defined(FAN_N) && FAN_N == 2
+FAN(2)
+FAN_OUT_RECV(2, 0) FAN_OUT_RECV(2, 1)
+FAN_IN_SEND(2, 0)  FAN_IN_SEND(2, 1)
+
+#elif defined(FAN_N) && FAN_N == 4
+FAN(4)
+FAN_OUT_RECV(4, 0) FAN_OUT_RECV(4, 1) FAN_OUT_RECV(4, 2) FAN_OUT_RECV(4, 3)
+FAN_IN_SEND(4, 0)  FAN_IN_SEND(4, 1)  FAN_IN_SEND(4, 2)  FAN_IN_SEND(4, 3)
+
+#elif defined(FAN_N) && FAN_N == 8
+FAN(8)
+FAN_OUT_RECV(8, 0) FAN_OUT_RECV(8, 1) FAN_OUT_RECV(8, 2) FAN_OUT_RECV(8, 3)
+FAN_OUT_RECV(8, 4) FAN_OUT_RECV(8, 5) FAN_OUT_RECV(8, 6) FAN_OUT_RECV(8, 7)
+FAN_IN_SEND(8, 0)  FAN_IN_SEND(8, 1)  FAN_IN_SEND(8, 2)  FAN_IN_SEND(8, 3)
+FAN_IN_SEND(8, 4)  FAN_IN_SEND(8, 5)  FAN_IN_SEND(8, 6)  FAN_IN_SEND(8, 7)
+
+#elif defined(FAN_N)
+#error "FAN_N must be 2, 4 or 8"
+#endif
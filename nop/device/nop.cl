@@ -1 +1,4 @@
 __kernel void nop() {}
+
+// Takes one argument, for the cost of clSetKernelArg
+__kernel void nop_arg(int x) {}
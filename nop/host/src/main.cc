@@ -0,0 +1,331 @@
+// Copyright (C) 2013-2016 Altera Corporation, San Jose, California, USA. All rights reserved.
+// Permission is hereby granted, free of charge, to any person obtaining a copy of this
+// software and associated documentation files (the "Software"), to deal in the Software
+// without restriction, including without limitation the rights to use, copy, modify, merge,
+// publish, distribute, sublicense, and/or sell copies of the Software, and to permit persons to
+// whom the Software is furnished to do so, subject to the following conditions:
+// The above copyright notice and this permission notice shall be included in all copies or
+// substantial portions of the Software.
+// 
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+// OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+// HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+// WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+// FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+// OTHER DEALINGS IN THE SOFTWARE.
+// 
+// This agreement shall be governed in all respects by the laws of the State of California and
+// by the laws of the United States of America.
+
+///////////////////////////////////////////////////////////////////////////////////
+// This host program measures the overhead of launching kernels with the empty
+// nop kernel, so that the cost of the OpenCL runtime and the board interface
+// is seen without any kernel work:
+//   - single-launch latency: host enqueue -> QUEUED -> SUBMIT -> START -> END,
+//     and the lag until the host wakes up, with blocking waits
+//     (clWaitForEvents) and with event callbacks (clSetEventCallback)
+//   - sustained throughput of back-to-back empty launches over 1..N queues
+//   - host cost of clSetKernelArg and of the enqueue, timed separately
+// Each is measured on in-order queues and, if the device supports them, on
+// out-of-order queues.
+///////////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <algorithm>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+#include "CL/opencl.h"
+#include "AOCLUtils/aocl_utils.h"
+
+
+// OpenCL runtime configuration
+/********************************************************************/
+cl_uint                                          num_devices   = 0;
+aocl_utils::scoped_cl_context                    context;
+aocl_utils::scoped_cl_program                    program;
+aocl_utils::scoped_cl_kernel                     kernel;      // nop()
+aocl_utils::scoped_cl_kernel                     kernel_arg;  // nop_arg(x)
+std::vector<aocl_utils::scoped_cl_command_queue> queues;      // in-order, 1..max_queues
+std::vector<aocl_utils::scoped_cl_command_queue> ooo_queues;  // out-of-order, 1..max_queues
+cl_platform_id                                   platform      = NULL;
+cl_int                                           status;
+aocl_utils::scoped_array<cl_device_id>           device_id;
+
+
+// Measurement configuration
+/********************************************************************/
+char   *name;
+size_t try_num;     // the number of launches of each measurement
+size_t max_queues;  // the largest number of queues for the throughput
+
+
+// Function prototypes
+/********************************************************************/
+void init_opencl();
+void run();
+void measure_latency(cl_command_queue queue, const char *label, bool callback);
+void measure_throughput(std::vector<aocl_utils::scoped_cl_command_queue> &qs, const char *label);
+void measure_arg_cost(cl_command_queue queue, const char *label);
+void cleanup();
+
+
+/********************************************************************/
+int main(int argc, char *argv[]) {
+
+  // check command line arguments
+  if (argc == 1) { std::cout << "usage: ./host <name> <try_num> <max_queues>" << std::endl; exit(0); }
+  if (argc != 4) { std::cerr << "Error! The number of arguments is wrong." << std::endl; exit(1); }
+  name       = argv[1];
+  try_num    = std::stoull(std::string(argv[2]));
+  max_queues = std::stoull(std::string(argv[3]));
+  if (try_num == 0 || max_queues == 0) { std::cerr << "Error! <try_num> and <max_queues> must be positive." << std::endl; exit(1); }
+
+  // Initialization
+  init_opencl();
+
+  // kernel running
+  run();
+
+  // Free the resources allocated
+  cleanup();
+
+  return 0;
+}
+
+
+/********************************************************************/
+void init_opencl() {
+  std::cout << "Initializing OpenCL" << std::endl;
+
+  if (!aocl_utils::setCwdToExeDir()) exit(1);
+
+  // Get the OpenCL platform.
+  platform = aocl_utils::findPlatform("Intel(R) FPGA");  // ~ 16.0: aocl_utils::findPlatform("Altera");
+  if (platform == NULL) {
+    std::cerr << "ERROR: Unable to find Intel(R) FPGA OpenCL platform." << std::endl;
+    exit(1);
+  }
+
+  // Query the available OpenCL device.
+  device_id.reset(aocl_utils::getDevices(platform, CL_DEVICE_TYPE_ALL, &num_devices));
+  std::cout << "Platform: " << aocl_utils::getPlatformName(platform).c_str() << std::endl;
+  std::cout << "Using " << num_devices << " device(s)" << std::endl;
+  std::cout << " " << aocl_utils::getDeviceName(device_id[0]).c_str() << std::endl;
+
+  // Select the binary for all device. Use the first device as the
+  // representative device (assuming all device are of the same type).
+  std::string binary_file = aocl_utils::getBoardBinaryFile(name, device_id[0]);
+  std::cout << "Using AOCX: " << binary_file.c_str() << std::endl;
+  // Without touching the device: what the AOCX holds, and whether it has the kernels
+  const char *kernel_names[] = {"nop", "nop_arg"};
+  aocl_utils::printAocxSummary(binary_file.c_str());
+  if (!aocl_utils::checkAocxKernels(binary_file.c_str(), kernel_names, 2)) exit(1);
+  const char *state_file = aocl_utils::getBitstreamStateFile();
+  bool resident = aocl_utils::prepareBinaryLoad(state_file, binary_file.c_str(), device_id, num_devices);
+
+  // Create the context.
+  context = clCreateContext(NULL, num_devices, device_id, NULL, NULL, &status);
+  aocl_utils::checkError(status, "Failed to create context");
+
+  // Create and build the program, reconfiguring the FPGA unless the
+  // resident bitstream can be reused.
+  program = aocl_utils::loadProgramFromBinary(context, binary_file.c_str(), device_id, num_devices, resident, state_file);
+
+  // kernels
+  kernel = clCreateKernel(program, "nop", &status);
+  aocl_utils::checkError(status, "Failed to create kernel nop");
+  kernel_arg = clCreateKernel(program, "nop_arg", &status);
+  aocl_utils::checkError(status, "Failed to create kernel nop_arg");
+
+  // command queues, all with profiling; out-of-order ones only if supported
+  cl_command_queue_properties supported = 0;
+  status = clGetDeviceInfo(device_id[0], CL_DEVICE_QUEUE_PROPERTIES, sizeof(supported), &supported, NULL);
+  aocl_utils::checkError(status, "Failed to query the queue properties");
+  queues.resize(max_queues);
+  for (size_t i = 0; i < max_queues; ++i) {
+    queues[i] = clCreateCommandQueue(context, device_id[0], CL_QUEUE_PROFILING_ENABLE, &status);
+    aocl_utils::checkError(status, "Failed to create command queue");
+  }
+  if (supported & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE) {
+    ooo_queues.resize(max_queues);
+    for (size_t i = 0; i < max_queues; ++i) {
+      ooo_queues[i] = clCreateCommandQueue(context, device_id[0],
+                                           CL_QUEUE_PROFILING_ENABLE | CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE, &status);
+      aocl_utils::checkError(status, "Failed to create out-of-order command queue");
+    }
+  } else {
+    std::cout << "The device has no out-of-order queues; only in-order queues are measured" << std::endl;
+  }
+}
+
+
+/********************************************************************/
+void run() {
+  std::cout << std::fixed << std::setprecision(3);
+
+  // one launch before the measurements, so that none of them pays for the first
+  status = clEnqueueTask(queues[0], kernel, 0, NULL, NULL);
+  aocl_utils::checkError(status, "Failed to launch kernel");
+  clFinish(queues[0]);
+
+  std::cout << std::endl << "Single-launch latency [us] (" << try_num << " launches)" << std::endl;
+  std::cout << std::left << std::setw(28) << "queue / completion" << std::right
+            << std::setw(12) << "interval" << std::setw(12) << "avg" << std::setw(12) << "median" << std::setw(12) << "p99" << std::endl;
+  measure_latency(queues[0], "in-order / blocking", false);
+  measure_latency(queues[0], "in-order / callback", true);
+  if (!ooo_queues.empty()) {
+    measure_latency(ooo_queues[0], "out-of-order / blocking", false);
+    measure_latency(ooo_queues[0], "out-of-order / callback", true);
+  }
+
+  std::cout << std::endl << "Sustained empty-launch throughput (" << try_num << " launches)" << std::endl;
+  std::cout << std::left << std::setw(28) << "queues" << std::right
+            << std::setw(12) << "launches/s" << std::setw(12) << "us/launch" << std::endl;
+  measure_throughput(queues, "in-order");
+  if (!ooo_queues.empty()) measure_throughput(ooo_queues, "out-of-order");
+
+  std::cout << std::endl << "Host cost per launch [us] (" << try_num << " launches)" << std::endl;
+  std::cout << std::left << std::setw(28) << "queue" << std::right
+            << std::setw(12) << "call" << std::setw(12) << "avg" << std::setw(12) << "median" << std::setw(12) << "p99" << std::endl;
+  measure_arg_cost(queues[0], "in-order");
+  if (!ooo_queues.empty()) measure_arg_cost(ooo_queues[0], "out-of-order");
+}
+
+
+// Statistics
+/********************************************************************/
+void print_stats(const char *label, const char *interval, std::vector<double> &us) {
+  std::sort(us.begin(), us.end());
+  double sum = 0;
+  for (size_t i = 0; i < us.size(); ++i) sum += us[i];
+  size_t p99 = std::min(us.size() - 1, (size_t)(0.99 * us.size()));
+  std::cout << std::left << std::setw(28) << label << std::right << std::setw(12) << interval
+            << std::setw(12) << sum / us.size() << std::setw(12) << us[us.size() / 2] << std::setw(12) << us[p99] << std::endl;
+}
+
+
+// Single-launch latency
+/********************************************************************/
+// Completion as seen by an event callback: the host thread sleeps on the
+// condition variable until the callback of the runtime wakes it up
+struct Completion {
+  std::mutex              mutex;
+  std::condition_variable cv;
+  bool                    done;
+};
+
+void CL_CALLBACK on_complete(cl_event, cl_int, void *user_data) {
+  Completion *c = static_cast<Completion *>(user_data);
+  std::lock_guard<std::mutex> lock(c->mutex);
+  c->done = true;
+  c->cv.notify_one();
+}
+
+void measure_latency(cl_command_queue queue, const char *label, bool callback) {
+  std::vector<double> enqueue(try_num), queued_submit(try_num), submit_start(try_num), start_end(try_num), wake(try_num), total(try_num);
+  for (size_t i = 0; i < try_num; ++i) {
+    aocl_utils::scoped_cl_event event;
+    Completion completion;
+    completion.done = false;
+
+    double t0 = aocl_utils::getCurrentTimestamp();
+    status = clEnqueueTask(queue, kernel, 0, NULL, event.out());
+    double t1 = aocl_utils::getCurrentTimestamp();
+    aocl_utils::checkError(status, "Failed to launch kernel");
+    if (callback) {
+      status = clSetEventCallback(event, CL_COMPLETE, on_complete, &completion);
+      aocl_utils::checkError(status, "Failed to set the event callback");
+      clFlush(queue);
+      std::unique_lock<std::mutex> lock(completion.mutex);
+      completion.cv.wait(lock, [&completion] { return completion.done; });
+    } else {
+      status = clWaitForEvents(1, event.ptr());
+      aocl_utils::checkError(status, "Failed to wait for the kernel");
+    }
+    double t2 = aocl_utils::getCurrentTimestamp();
+
+    cl_ulong stamps[4];
+    const cl_profiling_info info[4] = { CL_PROFILING_COMMAND_QUEUED, CL_PROFILING_COMMAND_SUBMIT,
+                                        CL_PROFILING_COMMAND_START, CL_PROFILING_COMMAND_END };
+    for (int k = 0; k < 4; ++k) {
+      status = clGetEventProfilingInfo(event, info[k], sizeof(cl_ulong), &stamps[k], NULL);
+      aocl_utils::checkError(status, "Failed to query the profiling info");
+    }
+    enqueue[i]       = (t1 - t0) * 1.0e6;
+    queued_submit[i] = (stamps[1] - stamps[0]) * 1.0e-3;
+    submit_start[i]  = (stamps[2] - stamps[1]) * 1.0e-3;
+    start_end[i]     = (stamps[3] - stamps[2]) * 1.0e-3;
+    total[i]         = (t2 - t0) * 1.0e6;
+    // the device clock is not the host clock: the lag after END is what the
+    // wall time leaves once the host enqueue and QUEUED..END are taken out
+    wake[i]          = std::max(0.0, total[i] - enqueue[i] - (stamps[3] - stamps[0]) * 1.0e-3);
+  }
+  print_stats(label, "enqueue",  enqueue);
+  print_stats("",    "->SUBMIT", queued_submit);
+  print_stats("",    "->START",  submit_start);
+  print_stats("",    "->END",    start_end);
+  print_stats("",    "->wake",   wake);
+  print_stats("",    "total",    total);
+}
+
+
+// Sustained throughput
+/********************************************************************/
+void measure_throughput(std::vector<aocl_utils::scoped_cl_command_queue> &qs, const char *label) {
+  for (size_t n = 1; n <= qs.size(); ++n) {
+    double t0 = aocl_utils::getCurrentTimestamp();
+    for (size_t i = 0; i < try_num; ++i) {
+      status = clEnqueueTask(qs[i % n], kernel, 0, NULL, NULL);
+      aocl_utils::checkError(status, "Failed to launch kernel");
+    }
+    for (size_t q = 0; q < n; ++q) clFlush(qs[q]);
+    for (size_t q = 0; q < n; ++q) clFinish(qs[q]);
+    double elapsed = aocl_utils::getCurrentTimestamp() - t0;
+
+    std::string queues_label = std::string(label) + " x " + std::to_string(n);
+    std::cout << std::left << std::setw(28) << queues_label << std::right
+              << std::setw(12) << std::setprecision(0) << try_num / elapsed
+              << std::setw(12) << std::setprecision(3) << elapsed * 1.0e6 / try_num << std::endl;
+  }
+}
+
+
+// Host cost of clSetKernelArg and of the enqueue
+/********************************************************************/
+void measure_arg_cost(cl_command_queue queue, const char *label) {
+  std::vector<double> set_arg(try_num), enqueue(try_num);
+  for (size_t i = 0; i < try_num; ++i) {
+    cl_int x = (cl_int)i;
+    double t0 = aocl_utils::getCurrentTimestamp();
+    status = clSetKernelArg(kernel_arg, 0, sizeof(cl_int), &x);
+    double t1 = aocl_utils::getCurrentTimestamp();
+    aocl_utils::checkError(status, "Failed to set argument x");
+    status = clEnqueueTask(queue, kernel_arg, 0, NULL, NULL);
+    double t2 = aocl_utils::getCurrentTimestamp();
+    aocl_utils::checkError(status, "Failed to launch kernel");
+    set_arg[i] = (t1 - t0) * 1.0e6;
+    enqueue[i] = (t2 - t1) * 1.0e6;
+  }
+  clFinish(queue);
+  print_stats(label, "setArg",  set_arg);
+  print_stats("",    "enqueue", enqueue);
+}
+
+
+/********************************************************************/
+void cleanup() {
+  for (size_t i = 0; i < queues.size(); ++i) clFinish(queues[i]);
+  for (size_t i = 0; i < ooo_queues.size(); ++i) clFinish(ooo_queues[i]);
+  queues.clear();
+  ooo_queues.clear();
+  kernel_arg.reset();
+  kernel.reset();
+  program.reset();
+  context.reset();
+}